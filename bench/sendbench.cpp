@@ -0,0 +1,234 @@
+/* sendbench.cpp
+
+   Copyright (C) 2014 - 2020 Marc Postema (mpostema09 -at- gmail.com)
+
+   This program is free software; you can redistribute it and/or
+   modify it under the terms of the GNU General Public License
+   as published by the Free Software Foundation; either version 2
+   of the License, or (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program; if not, write to the Free Software
+   Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+   Or, point your browser to http://www.gnu.org/copyleft/gpl.html
+
+   Benchmark of the CPU time the sending side spends per Gbit, for the
+   amount of TS packets that are send in one go. It sends over loopback
+   the same way the stream threads do: one iovec per buffer of 7 TS packets,
+   with an RTP header in front for RTP/UDP. RTP/UDP batches send several
+   datagrams with one sendmmsg or as segments of one UDP GSO send.
+
+   Build and run with:  make bench && ./sendbench [MBytes]
+ */
+#include <atomic>
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <initializer_list>
+#include <thread>
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/udp.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include <time.h>
+#include <unistd.h>
+
+#ifndef UDP_SEGMENT
+	#define UDP_SEGMENT 103
+#endif
+
+namespace {
+
+	constexpr std::size_t TS_PACKET_SIZE = 188;
+	constexpr std::size_t TS_PACKETS = 7;
+	constexpr std::size_t BUFFER_SIZE = TS_PACKETS * TS_PACKET_SIZE;
+	constexpr std::size_t RTP_HEADER_LEN = 12;
+	constexpr std::size_t MAX_SEND_BUF = 64;
+	constexpr std::size_t MAX_BATCH = 32;
+
+	std::atomic<bool> receiving;
+
+	double getCPUTime() {
+		struct timespec ts;
+		clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+		return ts.tv_sec + ts.tv_nsec / 1e9;
+	}
+
+	double getWallTime() {
+		struct timespec ts;
+		clock_gettime(CLOCK_MONOTONIC, &ts);
+		return ts.tv_sec + ts.tv_nsec / 1e9;
+	}
+
+	void drain(const int fd) {
+		static unsigned char buf[1 << 16];
+		while (receiving) {
+			if (recv(fd, buf, sizeof(buf), 0) <= 0) {
+				break;
+			}
+		}
+	}
+
+	/// Open a connected loopback pair, the receiving end is drained by a thread
+	bool openLoopback(const int type, int &sendFD, int &recvFD) {
+		struct sockaddr_in addr;
+		std::memset(&addr, 0, sizeof(addr));
+		addr.sin_family = AF_INET;
+		addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+		socklen_t len = sizeof(addr);
+
+		const int listenFD = socket(AF_INET, type, 0);
+		if (listenFD == -1 || bind(listenFD, reinterpret_cast<struct sockaddr *>(&addr), len) == -1 ||
+			getsockname(listenFD, reinterpret_cast<struct sockaddr *>(&addr), &len) == -1) {
+			perror("bind");
+			return false;
+		}
+		sendFD = socket(AF_INET, type, 0);
+		if (type == SOCK_STREAM) {
+			listen(listenFD, 1);
+			if (connect(sendFD, reinterpret_cast<struct sockaddr *>(&addr), len) == -1) {
+				perror("connect");
+				return false;
+			}
+			recvFD = accept(listenFD, nullptr, nullptr);
+			close(listenFD);
+		} else {
+			if (connect(sendFD, reinterpret_cast<struct sockaddr *>(&addr), len) == -1) {
+				perror("connect");
+				return false;
+			}
+			recvFD = listenFD;
+			const int size = 4 * 1024 * 1024;
+			setsockopt(recvFD, SOL_SOCKET, SO_RCVBUF, &size, sizeof(size));
+		}
+		return recvFD != -1;
+	}
+
+	enum class Mode {
+		Single, /// one datagram or write per system call
+		Batch,  /// datagrams batched with sendmmsg
+		GSO     /// datagrams as segments of one UDP GSO send
+	};
+
+	/// Send @p bytes in sends of @p buffers buffers per datagram or write,
+	/// @p batch datagrams per system call for Batch and GSO, and print the
+	/// result
+	void run(const char *name, const int type, const Mode mode, const std::size_t buffers,
+			const std::size_t batch, const std::size_t bytes) {
+		int sendFD;
+		int recvFD;
+		if (!openLoopback(type, sendFD, recvFD)) {
+			return;
+		}
+		receiving = true;
+		std::thread receiver(drain, recvFD);
+
+		const bool rtpHeader = (type == SOCK_DGRAM);
+		static unsigned char data[MAX_SEND_BUF][RTP_HEADER_LEN + BUFFER_SIZE];
+		struct iovec iov[MAX_SEND_BUF];
+		std::size_t iovcnt = 0;
+		for (std::size_t d = 0; d < ((mode == Mode::GSO) ? batch : 1); ++d) {
+			for (std::size_t i = 0; i < buffers; ++i, ++iovcnt) {
+				const bool header = rtpHeader && i == 0;
+				iov[iovcnt].iov_base = data[iovcnt] + (header ? 0 : RTP_HEADER_LEN);
+				iov[iovcnt].iov_len = BUFFER_SIZE + (header ? RTP_HEADER_LEN : 0);
+			}
+		}
+		struct mmsghdr msgs[MAX_BATCH];
+		std::memset(msgs, 0, sizeof(msgs));
+		for (std::size_t i = 0; i < MAX_BATCH; ++i) {
+			msgs[i].msg_hdr.msg_iov = iov;
+			msgs[i].msg_hdr.msg_iovlen = buffers;
+		}
+		const uint16_t segmentSize = buffers * BUFFER_SIZE + RTP_HEADER_LEN;
+		char control[CMSG_SPACE(sizeof(uint16_t))];
+		std::memset(control, 0, sizeof(control));
+		struct msghdr gso;
+		std::memset(&gso, 0, sizeof(gso));
+		gso.msg_iov = iov;
+		gso.msg_iovlen = iovcnt;
+		gso.msg_control = control;
+		gso.msg_controllen = sizeof(control);
+		struct cmsghdr *cmsg = CMSG_FIRSTHDR(&gso);
+		cmsg->cmsg_level = SOL_UDP;
+		cmsg->cmsg_type = UDP_SEGMENT;
+		cmsg->cmsg_len = CMSG_LEN(sizeof(uint16_t));
+		std::memcpy(CMSG_DATA(cmsg), &segmentSize, sizeof(uint16_t));
+
+		const std::size_t sendSize = buffers * BUFFER_SIZE;
+		unsigned long sends = 0;
+		unsigned long datagrams = 0;
+		std::size_t send = 0;
+		const double tCPU = getCPUTime();
+		const double tWall = getWallTime();
+		while (send < bytes) {
+			int ret = -1;
+			switch (mode) {
+				case Mode::Single:
+					ret = (writev(sendFD, iov, buffers) == -1) ? -1 : 1;
+					break;
+				case Mode::Batch:
+					ret = sendmmsg(sendFD, msgs, batch, 0);
+					break;
+				case Mode::GSO:
+					ret = (sendmsg(sendFD, &gso, 0) == -1) ? -1 : batch;
+					break;
+			}
+			if (ret == -1) {
+				if (errno == ENOBUFS || errno == EAGAIN || errno == ECONNREFUSED) {
+					continue;
+				}
+				perror("send");
+				break;
+			}
+			send += sendSize * ret;
+			datagrams += ret;
+			++sends;
+		}
+		const double cpu = getCPUTime() - tCPU;
+		const double wall = getWallTime() - tWall;
+		const double gbit = send * 8.0 / 1e9;
+		std::printf("%-12s %4zu TS packets x %2zu  %8lu sends  %7.0f kpps  %7.1f Mbit/s  %6.3f CPU sec/Gbit  %5.2f us/send\n",
+			name, buffers * TS_PACKETS, batch, sends, datagrams / wall / 1000.0, gbit * 1000.0 / wall,
+			cpu / gbit, cpu * 1e6 / sends);
+
+		receiving = false;
+		shutdown(sendFD, SHUT_RDWR);
+		close(sendFD);
+		shutdown(recvFD, SHUT_RDWR);
+		receiver.join();
+		close(recvFD);
+	}
+
+} // namespace
+
+int main(int argc, char *argv[]) {
+	const std::size_t mbytes = (argc > 1) ? std::strtoul(argv[1], nullptr, 10) : 512;
+	const std::size_t bytes = mbytes * 1024 * 1024;
+
+	// RTP/UDP: standard and jumbo frame datagrams
+	for (std::size_t buffers : {1, 2, 4, 6}) {
+		run("RTP/UDP", SOCK_DGRAM, Mode::Single, buffers, 1, bytes);
+	}
+	// RTP/UDP: standard datagrams batched with sendmmsg
+	for (std::size_t batch : {8, 32}) {
+		run("RTP/UDP mmsg", SOCK_DGRAM, Mode::Batch, 1, batch, bytes);
+	}
+	// RTP/UDP: standard datagrams as UDP GSO segments, 49 fill 64 KB
+	for (std::size_t batch : {8, 32, 49}) {
+		run("RTP/UDP GSO", SOCK_DGRAM, Mode::GSO, 1, batch, bytes);
+	}
+	// HTTP and RTP/TCP: up to the 64 KB aggregate
+	for (std::size_t buffers : {1, 7, 21, 49}) {
+		run("TCP", SOCK_STREAM, Mode::Single, buffers, 1, bytes);
+	}
+	return 0;
+}
@@ -0,0 +1,10 @@
+#include <linux/io_uring.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+int main(void) {
+  struct io_uring_params params = {};
+  struct io_uring_getevents_arg arg = {};
+  (void)arg;
+  params.features = IORING_FEAT_EXT_ARG;
+  return syscall(__NR_io_uring_setup, 8, &params) == -1;
+}
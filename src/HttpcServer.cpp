@@ -117,6 +117,12 @@ void HttpcServer::getHtmlBodyNoContent(std::string &htmlBody, const std::string
 bool HttpcServer::process(SocketClient &client) {
 	std::string msg = client.getMessage();
 
+	// Interleaved RTCP reports of a RTP/TCP client
+	if (!msg.empty() && msg[0] == '$') {
+		_streamManager.processRtcpData(client);
+		return true;
+	}
+
 //	SI_LOG_DEBUG("%s HTML data from client %s: %s", client.getProtocolString().c_str(), client.getIPAddress().c_str(), msg.c_str());
 
 	// parse HTML
@@ -74,7 +74,10 @@ class SatPI :
 			const std::string &dvbPath,
 			unsigned int httpPort,
 			unsigned int rtspPort,
-			const bool enableChildPIPE) :
+			const bool enableChildPIPE,
+			const bool enableIngestReactor,
+			const bool enableHugePages,
+			const bool enableIoUring) :
 			XMLSaveSupport((appdataPath.empty() ? currentPath : appdataPath) + "/" + "SatPI.xml"),
 			_interface(ifaceName),
 			_streamManager(),
@@ -85,7 +88,8 @@ class SatPI :
 			_properties.setFunctionNotifyChanges(std::bind(&XMLSaveSupport::notifyChanges, this));
 			_ssdpServer.setFunctionNotifyChanges(std::bind(&XMLSaveSupport::notifyChanges, this));
 			//
-			_streamManager.enumerateDevices(_interface.getIPAddress(), _properties.getAppDataPath(), dvbPath, enableChildPIPE);
+			_streamManager.enumerateDevices(_interface.getIPAddress(), _properties.getAppDataPath(), dvbPath,
+				enableChildPIPE, enableIngestReactor, enableHugePages, enableIoUring);
 			//
 			std::string xml;
 			if (restoreXML(xml)) {
@@ -327,6 +331,9 @@ static void printUsage(const char *prog_name) {
 	       "\t--http-port      set http port default 8875 (1024 - 65535)\r\n" \
 	       "\t--rtsp-port      set rtsp port default 554  ( 554 - 65535)\r\n" \
 	       "\t--childpipe      enabled Frontend 'Child PIPE - TS Reader'\r\n" \
+	       "\t--ingest-reactor watch all input devices with one epoll thread\r\n" \
+	       "\t--hugepages      back the stream packet pool with huge pages\r\n" \
+	       "\t--io-uring       send the output of all streams with one io_uring thread\r\n" \
 	       "\t--no-daemon      do NOT daemonize\r\n" \
 	       "\t--no-ssdp        do NOT advertise server\r\n", prog_name);
 }
@@ -338,6 +345,9 @@ int main(int argc, char *argv[]) {
 	bool ssdp = true;
 	bool daemon = true;
 	bool enableChildPIPE = false;
+	bool enableIngestReactor = false;
+	bool enableHugePages = false;
+	bool enableIoUring = false;
 	int i;
 	char *user = nullptr;
 	extern const char *satpi_version;
@@ -382,6 +392,12 @@ int main(int argc, char *argv[]) {
 			}
 		} else if (strcmp(argv[i], "--childpipe") == 0) {
 			enableChildPIPE = true;
+		} else if (strcmp(argv[i], "--ingest-reactor") == 0) {
+			enableIngestReactor = true;
+		} else if (strcmp(argv[i], "--hugepages") == 0) {
+			enableHugePages = true;
+		} else if (strcmp(argv[i], "--io-uring") == 0) {
+			enableIoUring = true;
 		} else if (strcmp(argv[i], "--app-data-path") == 0) {
 			if (i + 1 < argc) {
 				++i;
@@ -466,7 +482,8 @@ int main(int argc, char *argv[]) {
 			dvbca.startThread();
 #endif
 			SatPI satpi(ssdp, ifaceName, currentPath, appdataPath,
-					webPath, dvbPath, httpPort, rtspPort, enableChildPIPE);
+					webPath, dvbPath, httpPort, rtspPort,
+					enableChildPIPE, enableIngestReactor, enableHugePages, enableIoUring);
 
 			// Loop
 			while (!exitApp && !satpi.exitApplication() && !restartApp) {
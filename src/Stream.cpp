@@ -25,10 +25,14 @@
 #include <input/dvb/Frontend.h>
 #include <input/dvb/FrontendData.h>
 #include <input/dvb/delivery/DVBS.h>
+#include <output/Pacer.h>
+#include <output/RtcpFeedback.h>
+#include <output/RtpRetransmitter.h>
 #include <output/StreamThreadHttp.h>
 #include <output/StreamThreadRtp.h>
 #include <output/StreamThreadRtpTcp.h>
 #include <output/StreamThreadTSWriter.h>
+#include <output/TcpSink.h>
 #include <socket/SocketClient.h>
 
 #include <stdio.h>
@@ -51,12 +55,47 @@ Stream::Stream(int streamID, input::SpDevice device, decrypt::dvbapi::SpClient d
 	_streaming(nullptr),
 	_decrypt(decrypt),
 	_device(device),
+	_ingestReactor(nullptr),
+	_packetPool(nullptr),
+	_egressRing(nullptr),
+	_rtcpService(nullptr),
 	_ssrc((uint32_t)(rand_r(&seedp) % 0xffff)),
 	_spc(0),
 	_soc(0),
 	_timestamp(0),
 	_rtp_payload(0.0),
-	_rtcpSignalUpdate(1) {
+	_dropped(0),
+	_rtcpSignalUpdate(1),
+	_pacingBurst(8),
+	_pacingLatency(50),
+	_rtpTSPackets(7),
+	_rtpBatchSize(8),
+	_rtpBatchHold(1),
+	_rtpGSO(false),
+	_rtpTcpTSPackets(7),
+	_httpTSPackets(343),
+	_httpZeroCopy(false),
+	_httpSplice(false),
+	_sinkQueueSize(1024),
+	_sinkQueueTime(1000),
+	_sinkPolicy(0),
+	_sinkDeadline(5000),
+	_sinkReducedPIDs("0,1,16,17,18,20"),
+	_rtcpAdaptation(1),
+	_rtcpLossThreshold(5),
+	_rtcpLowPriorityPIDs("18"),
+	_rtpRetransmit(false),
+	_rtpRetransmitWindow(500),
+	_rtpRetransmitMemory(4096),
+	_rtpRetransmitRate(10),
+	_signalUpdate(0),
+	_tuneThread(
+		StringConverter::getFormattedString("Tuning%d", streamID),
+		std::bind(&Stream::tuneThreadExecute, this)),
+	_tuneThreadStarted(false),
+	_tuneRequested(false),
+	_tuneClientID(0),
+	_tuneGeneration(0) {
 	ASSERT(device);
 	for (std::size_t i = 0; i < MAX_CLIENTS; ++i) {
 		_client[i].setStreamIDandClientID(streamID, i);
@@ -64,6 +103,14 @@ Stream::Stream(int streamID, input::SpDevice device, decrypt::dvbapi::SpClient d
 }
 
 Stream::~Stream() {
+	if (_tuneThreadStarted) {
+		_tuneThread.terminateThread();
+	}
+	// Apply the device changes the tuning thread did not get to, like
+	// a teardown of the input device
+	for (const FunctionDeviceRequest &request : _deviceRequests) {
+		request();
+	}
 	DELETE_ARRAY(_client);
 }
 
@@ -83,6 +130,22 @@ input::SpDevice Stream::getInputDevice() const {
 	return _device;
 }
 
+input::IngestReactor *Stream::getIngestReactor() const {
+	return _ingestReactor;
+}
+
+mpegts::PacketPool *Stream::getPacketPool() const {
+	return _packetPool;
+}
+
+output::EgressRing *Stream::getEgressRing() const {
+	return _egressRing;
+}
+
+output::RtcpService *Stream::getRtcpService() const {
+	return _rtcpService;
+}
+
 #ifdef LIBDVBCSA
 decrypt::dvbapi::SpClient Stream::getDecryptDevice() const {
 	return _decrypt;
@@ -101,17 +164,13 @@ uint32_t Stream::getSPC() const {
 	return _spc;
 }
 
-unsigned int Stream::getRtcpSignalUpdateFrequency() const {
-	return _rtcpSignalUpdate;
-}
-
 uint32_t Stream::getSOC() const {
 	return _soc;
 }
 
-void Stream::addRtpData(uint32_t byte, long timestamp) {
+void Stream::addRtpData(uint32_t packets, uint32_t byte, long timestamp) {
 	// inc RTP packet counter
-	++_spc;
+	_spc += packets;
 	_soc += byte;
 	_rtp_payload = _rtp_payload + byte;
 	_timestamp = timestamp;
@@ -121,10 +180,109 @@ double Stream::getRtpPayload() const {
 	return _rtp_payload;
 }
 
+void Stream::addDroppedPackets(uint32_t packets) {
+	_dropped += packets;
+}
+
+unsigned int Stream::getPacingBurst() const {
+	return _pacingBurst;
+}
+
+unsigned int Stream::getPacingLatency() const {
+	return _pacingLatency;
+}
+
+unsigned int Stream::getRtpTSPackets() const {
+	return _rtpTSPackets;
+}
+
+unsigned int Stream::getRtpBatchSize() const {
+	return _rtpBatchSize;
+}
+
+unsigned int Stream::getRtpBatchHold() const {
+	return _rtpBatchHold;
+}
+
+bool Stream::isRtpGSOEnabled() const {
+	return _rtpGSO;
+}
+
+unsigned int Stream::getRtpTcpTSPackets() const {
+	return _rtpTcpTSPackets;
+}
+
+unsigned int Stream::getHttpTSPackets() const {
+	return _httpTSPackets;
+}
+
+bool Stream::isHttpZeroCopyEnabled() const {
+	return _httpZeroCopy;
+}
+
+bool Stream::isHttpSpliceEnabled() const {
+	return _httpSplice;
+}
+
+unsigned int Stream::getSinkQueueSize() const {
+	return _sinkQueueSize;
+}
+
+unsigned int Stream::getSinkQueueTime() const {
+	return _sinkQueueTime;
+}
+
+unsigned int Stream::getSinkPolicy() const {
+	return _sinkPolicy;
+}
+
+unsigned int Stream::getSinkDeadline() const {
+	return _sinkDeadline;
+}
+
+std::string Stream::getSinkReducedPIDs() const {
+	base::MutexLock lock(_mutex);
+	return _sinkReducedPIDs;
+}
+
+unsigned int Stream::getRtcpAdaptation() const {
+	return _rtcpAdaptation;
+}
+
+unsigned int Stream::getRtcpLossThreshold() const {
+	return _rtcpLossThreshold;
+}
+
+std::string Stream::getRtcpLowPriorityPIDs() const {
+	base::MutexLock lock(_mutex);
+	return _rtcpLowPriorityPIDs;
+}
+
+bool Stream::isRtpRetransmitEnabled() const {
+	base::MutexLock lock(_mutex);
+	return _rtpRetransmit && _streamingType == StreamingType::RTSP_UNICAST;
+}
+
+unsigned int Stream::getRtpRetransmitWindow() const {
+	return _rtpRetransmitWindow;
+}
+
+unsigned int Stream::getRtpRetransmitMemory() const {
+	return _rtpRetransmitMemory;
+}
+
+unsigned int Stream::getRtpRetransmitRate() const {
+	return _rtpRetransmitRate;
+}
+
 std::string Stream::attributeDescribeString() const {
 	return _device->attributeDescribeString();
 }
 
+uint64_t Stream::getDescribeVersion() const {
+	return _device->getDescribeVersion();
+}
+
 std::string Stream::getDescribeMediaLevelString() const {
 	static const char *RTSP_DESCRIBE_MEDIA_LEVEL =
 		"m=video %1 RTP/AVP 33\r\n" \
@@ -132,6 +290,16 @@ std::string Stream::getDescribeMediaLevelString() const {
 		"a=control:stream=%3\r\n" \
 		"a=fmtp:33 %4\r\n" \
 		"a=%5\r\n";
+	// Unicast with retransmission (RFC 4588) of NACKed packets (RFC 4585)
+	static const char *RTSP_DESCRIBE_MEDIA_LEVEL_RTX =
+		"m=video %1 RTP/AVPF 33 97\r\n" \
+		"c=IN IP4 %2\r\n" \
+		"a=control:stream=%3\r\n" \
+		"a=fmtp:33 %4\r\n" \
+		"a=rtcp-fb:33 nack\r\n" \
+		"a=rtpmap:97 rtx/90000\r\n" \
+		"a=fmtp:97 apt=33;rtx-time=%6\r\n" \
+		"a=%5\r\n";
 	const std::string desc_attr = _device->attributeDescribeString();
 	if (desc_attr.size() > 5) {
 		if (_streamingType == StreamingType::RTSP_MULTICAST) {
@@ -139,6 +307,10 @@ std::string Stream::getDescribeMediaLevelString() const {
 				_client[0].getRtpSocketAttr().getSocketPort(),
 				_client[0].getIPAddressOfStream() + "/0",
 				_streamID, desc_attr, (_streamActive) ? "sendonly" : "inactive");
+		} else if (_rtpRetransmit) {
+			return StringConverter::stringFormat(RTSP_DESCRIBE_MEDIA_LEVEL_RTX,
+				0, "0.0.0.0", _streamID, desc_attr, (_streamActive) ? "sendonly" : "inactive",
+				_rtpRetransmitWindow.load());
 		} else {
 			return StringConverter::stringFormat(RTSP_DESCRIBE_MEDIA_LEVEL,
 				0, "0.0.0.0", _streamID, desc_attr, (_streamActive) ? "sendonly" : "inactive");
@@ -161,10 +333,96 @@ void Stream::doAddToXML(std::string &xml) const {
 	ADD_XML_ELEMENT(xml, "ownerSessionID", _client[0].getSessionID());
 	ADD_XML_ELEMENT(xml, "userAgent", _client[0].getUserAgent());
 
-	ADD_XML_NUMBER_INPUT(xml, "rtcpSignalUpdate", _rtcpSignalUpdate, 0, 5);
+	ADD_XML_NUMBER_INPUT(xml, "rtcpSignalUpdate", _rtcpSignalUpdate.load(), 0, 5);
+	ADD_XML_NUMBER_INPUT(xml, "pacingBurst", _pacingBurst.load(), 0, 100);
+	ADD_XML_NUMBER_INPUT(xml, "pacingLatency", _pacingLatency.load(), 10, 1000);
+	ADD_XML_NUMBER_INPUT(xml, "rtpTSPackets", _rtpTSPackets.load(), 7, 42);
+	ADD_XML_NUMBER_INPUT(xml, "rtpBatchSize", _rtpBatchSize.load(), 1, 32);
+	ADD_XML_NUMBER_INPUT(xml, "rtpBatchHold", _rtpBatchHold.load(), 0, 50);
+	ADD_XML_CHECKBOX(xml, "rtpGSO", (_rtpGSO ? "true" : "false"));
+	ADD_XML_NUMBER_INPUT(xml, "rtpTcpTSPackets", _rtpTcpTSPackets.load(), 7, 343);
+	ADD_XML_NUMBER_INPUT(xml, "httpTSPackets", _httpTSPackets.load(), 7, 700);
+	ADD_XML_CHECKBOX(xml, "httpZeroCopy", (_httpZeroCopy ? "true" : "false"));
+	ADD_XML_CHECKBOX(xml, "httpSplice", (_httpSplice ? "true" : "false"));
+	ADD_XML_NUMBER_INPUT(xml, "sinkQueueSize", _sinkQueueSize.load(), 64, 16384);
+	ADD_XML_NUMBER_INPUT(xml, "sinkQueueTime", _sinkQueueTime.load(), 10, 10000);
+	ADD_XML_BEGIN_ELEMENT(xml, "sinkPolicy");
+		ADD_XML_ELEMENT(xml, "inputtype", "selectionlist");
+		ADD_XML_ELEMENT(xml, "value", _sinkPolicy.load());
+		ADD_XML_BEGIN_ELEMENT(xml, "list");
+		ADD_XML_ELEMENT(xml, "option0", "Drop oldest");
+		ADD_XML_ELEMENT(xml, "option1", "Reduced PIDs");
+		ADD_XML_ELEMENT(xml, "option2", "Disconnect");
+		ADD_XML_END_ELEMENT(xml, "list");
+	ADD_XML_END_ELEMENT(xml, "sinkPolicy");
+	ADD_XML_NUMBER_INPUT(xml, "sinkDeadline", _sinkDeadline.load(), 100, 60000);
+	ADD_XML_TEXT_INPUT(xml, "sinkReducedPIDs", _sinkReducedPIDs);
+	ADD_XML_BEGIN_ELEMENT(xml, "rtcpAdaptation");
+		ADD_XML_ELEMENT(xml, "inputtype", "selectionlist");
+		ADD_XML_ELEMENT(xml, "value", _rtcpAdaptation.load());
+		ADD_XML_BEGIN_ELEMENT(xml, "list");
+		ADD_XML_ELEMENT(xml, "option0", "Off");
+		ADD_XML_ELEMENT(xml, "option1", "Alert");
+		ADD_XML_ELEMENT(xml, "option2", "Pacing");
+		ADD_XML_ELEMENT(xml, "option3", "Drop low priority PIDs");
+		ADD_XML_END_ELEMENT(xml, "list");
+	ADD_XML_END_ELEMENT(xml, "rtcpAdaptation");
+	ADD_XML_NUMBER_INPUT(xml, "rtcpLossThreshold", _rtcpLossThreshold.load(), 1, 100);
+	ADD_XML_TEXT_INPUT(xml, "rtcpLowPriorityPIDs", _rtcpLowPriorityPIDs);
+	ADD_XML_CHECKBOX(xml, "rtpRetransmit", (_rtpRetransmit ? "true" : "false"));
+	ADD_XML_NUMBER_INPUT(xml, "rtpRetransmitWindow", _rtpRetransmitWindow.load(), 50, 5000);
+	ADD_XML_NUMBER_INPUT(xml, "rtpRetransmitMemory", _rtpRetransmitMemory.load(), 64, 65536);
+	ADD_XML_NUMBER_INPUT(xml, "rtpRetransmitRate", _rtpRetransmitRate.load(), 1, 100);
 
 	ADD_XML_ELEMENT(xml, "spc", _spc.load());
 	ADD_XML_ELEMENT(xml, "payload", _rtp_payload.load() / (1024.0 * 1024.0));
+	ADD_XML_ELEMENT(xml, "dropped", _dropped.load());
+	if (_streaming) {
+		const output::Pacer &pacer = _streaming->getPacer();
+		ADD_XML_ELEMENT(xml, "pacingBitrate", pacer.getBitrate());
+		ADD_XML_ELEMENT(xml, "pacingJitter", pacer.getJitter());
+		ADD_XML_ELEMENT(xml, "pacingMaxJitter", pacer.getMaxJitter());
+		ADD_XML_ELEMENT(xml, "sendBatches", _streaming->getSendBatches());
+		ADD_XML_ELEMENT(xml, "sendBatchAvg", _streaming->getSendBatchAverage());
+		ADD_XML_ELEMENT(xml, "sendBatchMax", _streaming->getSendBatchMax());
+		ADD_XML_ELEMENT(xml, "sendBatchTimeouts", _streaming->getSendBatchTimeouts());
+		const output::TcpSink *sink = _streaming->getTcpSink();
+		if (sink != nullptr) {
+			ADD_XML_ELEMENT(xml, "sinkBacklog", sink->getBacklog());
+			ADD_XML_ELEMENT(xml, "sinkMaxBacklog", sink->getMaxBacklog());
+			ADD_XML_ELEMENT(xml, "sinkBlockedWrites", sink->getBlockedWrites());
+			ADD_XML_ELEMENT(xml, "sinkDropped", sink->getDroppedPackets());
+			ADD_XML_ELEMENT(xml, "sinkReductions", sink->getReductions());
+			ADD_XML_ELEMENT(xml, "sinkDisconnects", sink->getDisconnects());
+			ADD_XML_ELEMENT(xml, "sinkSendQueue", sink->getSendQueue());
+			ADD_XML_ELEMENT(xml, "sinkRtt", sink->getRtt());
+			ADD_XML_ELEMENT(xml, "sinkRetransmits", sink->getRetransmits());
+			ADD_XML_ELEMENT(xml, "sinkZeroCopySends", sink->getZeroCopySends());
+			ADD_XML_ELEMENT(xml, "sinkZeroCopyCopied", sink->getZeroCopyCopied());
+			ADD_XML_ELEMENT(xml, "sinkSpliced", sink->getSplicedBytes() / (1024.0 * 1024.0));
+			ADD_XML_ELEMENT(xml, "splicing", _streaming->isSplicing() ? "yes" : "no");
+		}
+		const output::RtcpFeedback *feedback = _streaming->getRtcpFeedback();
+		if (feedback != nullptr) {
+			ADD_XML_ELEMENT(xml, "rtcpReports", feedback->getReports());
+			ADD_XML_ELEMENT(xml, "rtcpFractionLost", feedback->getFractionLost());
+			ADD_XML_ELEMENT(xml, "rtcpCumulativeLost", feedback->getCumulativeLost());
+			ADD_XML_ELEMENT(xml, "rtcpJitter", feedback->getJitter());
+			ADD_XML_ELEMENT(xml, "rtcpRtt", feedback->getRtt());
+			ADD_XML_ELEMENT(xml, "rtcpCongested", feedback->isCongested() ? "yes" : "no");
+			ADD_XML_ELEMENT(xml, "rtcpNacks", feedback->getNacks());
+		}
+		const output::RtpRetransmitter *retransmitter = _streaming->getRtpRetransmitter();
+		if (retransmitter != nullptr && retransmitter->isEnabled()) {
+			ADD_XML_ELEMENT(xml, "rtxRequested", retransmitter->getRequested());
+			ADD_XML_ELEMENT(xml, "rtxSent", retransmitter->getSent());
+			ADD_XML_ELEMENT(xml, "rtxExpired", retransmitter->getExpired());
+			ADD_XML_ELEMENT(xml, "rtxRateLimited", retransmitter->getRateLimited());
+			ADD_XML_ELEMENT(xml, "rtxMemory", retransmitter->getMemory());
+		}
+		ADD_XML_ELEMENT(xml, "sendLoad", _streaming->getSendLoad());
+		ADD_XML_ELEMENT(xml, "ingestLoad", _streaming->getIngestLoad());
+	}
 
 	_device->addToXML(xml);
 }
@@ -178,7 +436,76 @@ void Stream::doFromXML(const std::string &xml) {
 	if (findXMLElement(xml, "rtcpSignalUpdate.value", element)) {
 		_rtcpSignalUpdate = std::stoi(element);
 	}
-	_device->fromXML(xml);
+	if (findXMLElement(xml, "pacingBurst.value", element)) {
+		_pacingBurst = std::stoi(element);
+	}
+	if (findXMLElement(xml, "pacingLatency.value", element)) {
+		_pacingLatency = std::stoi(element);
+	}
+	if (findXMLElement(xml, "rtpTSPackets.value", element)) {
+		_rtpTSPackets = std::stoi(element);
+	}
+	if (findXMLElement(xml, "rtpBatchSize.value", element)) {
+		_rtpBatchSize = std::stoi(element);
+	}
+	if (findXMLElement(xml, "rtpBatchHold.value", element)) {
+		_rtpBatchHold = std::stoi(element);
+	}
+	if (findXMLElement(xml, "rtpGSO.value", element)) {
+		_rtpGSO = (element == "true") ? true : false;
+	}
+	if (findXMLElement(xml, "rtpTcpTSPackets.value", element)) {
+		_rtpTcpTSPackets = std::stoi(element);
+	}
+	if (findXMLElement(xml, "httpTSPackets.value", element)) {
+		_httpTSPackets = std::stoi(element);
+	}
+	if (findXMLElement(xml, "httpZeroCopy.value", element)) {
+		_httpZeroCopy = (element == "true") ? true : false;
+	}
+	if (findXMLElement(xml, "httpSplice.value", element)) {
+		_httpSplice = (element == "true") ? true : false;
+	}
+	if (findXMLElement(xml, "sinkQueueSize.value", element)) {
+		_sinkQueueSize = std::stoi(element);
+	}
+	if (findXMLElement(xml, "sinkQueueTime.value", element)) {
+		_sinkQueueTime = std::stoi(element);
+	}
+	if (findXMLElement(xml, "sinkPolicy.value", element)) {
+		_sinkPolicy = std::stoi(element);
+	}
+	if (findXMLElement(xml, "sinkDeadline.value", element)) {
+		_sinkDeadline = std::stoi(element);
+	}
+	if (findXMLElement(xml, "sinkReducedPIDs.value", element)) {
+		_sinkReducedPIDs = element;
+	}
+	if (findXMLElement(xml, "rtcpAdaptation.value", element)) {
+		_rtcpAdaptation = std::stoi(element);
+	}
+	if (findXMLElement(xml, "rtcpLossThreshold.value", element)) {
+		_rtcpLossThreshold = std::stoi(element);
+	}
+	if (findXMLElement(xml, "rtcpLowPriorityPIDs.value", element)) {
+		_rtcpLowPriorityPIDs = element;
+	}
+	if (findXMLElement(xml, "rtpRetransmit.value", element)) {
+		_rtpRetransmit = (element == "true") ? true : false;
+	}
+	if (findXMLElement(xml, "rtpRetransmitWindow.value", element)) {
+		_rtpRetransmitWindow = std::stoi(element);
+	}
+	if (findXMLElement(xml, "rtpRetransmitMemory.value", element)) {
+		_rtpRetransmitMemory = std::stoi(element);
+	}
+	if (findXMLElement(xml, "rtpRetransmitRate.value", element)) {
+		_rtpRetransmitRate = std::stoi(element);
+	}
+	// The tuning thread may use the device configuration right now
+	queueDeviceRequest([this, xml]() {
+		_device->fromXML(xml);
+	});
 }
 
 // ===========================================================================
@@ -230,6 +557,13 @@ bool Stream::findClientIDFor(SocketClient &socketClient,
 	for (std::size_t i = 0; i < MAX_CLIENTS; ++i) {
 		// If we have a new session we like to find an empty slot so '-1'
 		if (_client[i].getSessionID().compare(newSession ? "-1" : sessionID) == 0) {
+			// A client sharing this stream can not retune the input device
+			if (!newSession && i > 0 && StringConverter::hasTransportParameters(message) &&
+					!_device->isTunedTo(message, method)) {
+				SI_LOG_INFO("Stream: %d, StreamClient[%d] with SessionID %s shares this stream and can not retune it",
+				            _streamID, i, sessionID.c_str());
+				return false;
+			}
 			if (msys != input::InputSystem::UNDEFINED) {
 				SI_LOG_INFO("Stream: %d, StreamClient[%d] with SessionID %s for %s",
 				            _streamID, i, sessionID.c_str(), StringConverter::delsys_to_string(msys));
@@ -253,6 +587,39 @@ bool Stream::findClientIDFor(SocketClient &socketClient,
 	return false;
 }
 
+bool Stream::shareClientIDFor(SocketClient &socketClient,
+                              const std::string &method,
+                              int &clientID) {
+	base::MutexLock lock(_mutex);
+
+	// Only RTP/UDP unicast streams can be shared
+	if (!_enabled || !_streamInUse || !_streamActive || !_streaming ||
+	    _streamingType != StreamingType::RTSP_UNICAST || method != "SETUP") {
+		return false;
+	}
+	const std::string message = socketClient.getPercentDecodedMessage();
+	const std::string transport = StringConverter::getHeaderFieldParameter(message, "Transport:");
+	if (transport.find("unicast") == std::string::npos ||
+	    transport.find("RTP/AVP/TCP") != std::string::npos ||
+	    !_device->isTunedTo(message, method)) {
+		return false;
+	}
+	for (std::size_t i = 1; i < MAX_CLIENTS; ++i) {
+		if (_client[i].getSessionID() == "-1") {
+			SI_LOG_INFO("Stream: %d, StreamClient[%d] shares this stream", _streamID, i);
+			_client[i].setSocketClient(socketClient);
+			clientID = i;
+			return true;
+		}
+	}
+	return false;
+}
+
+int Stream::allocationScore(const std::string &msg, const std::string &method) const {
+	base::MutexLock lock(_mutex);
+	return _device ? _device->allocationScore(msg, method) : 0;
+}
+
 void Stream::checkForSessionTimeout() {
 	base::MutexLock lock(_mutex);
 
@@ -266,14 +633,43 @@ void Stream::checkForSessionTimeout() {
 							_streamID, i, _client[i].getSessionID().c_str());
 			}
 			teardown(i);
-			close(i);
 		}
 	}
 }
 
+void Stream::monitorSignal() {
+	if (!_streamActive) {
+		return;
+	}
+	// check do we need to update Device monitor signals
+	if (_signalUpdate == 0) {
+		// The device is (re)tuning, so skip this sample and try next time
+		if (!_deviceMutex.tryLock()) {
+			return;
+		}
+		_device->monitorSignal(false);
+		_deviceMutex.unlock();
+		_signalUpdate = _rtcpSignalUpdate;
+	} else {
+		--_signalUpdate;
+	}
+}
+
 bool Stream::update(int clientID, bool start) {
 	base::MutexLock lock(_mutex);
 
+	// A client sharing this stream only needs its PIDs updated
+	if (clientID != 0) {
+		if (!_streaming || !_streamActive) {
+			return false;
+		}
+		if (start && !_streaming->addSharedClient(clientID)) {
+			return false;
+		}
+		requestUpdate(0);
+		return true;
+	}
+
 	// first time streaming?
 	if (!_streaming && start) {
 		switch (_streamingType) {
@@ -309,13 +705,119 @@ bool Stream::update(int clientID, bool start) {
 			return false;
 		}
 	}
-	// Get changed flag, before device update, because it resets it
-	const bool changed = _device->hasDeviceDataChanged();
-
-	if (!_device->update()) {
+	if (!startTuneThread()) {
 		return false;
 	}
+	requestUpdate(clientID);
+	return true;
+}
+
+bool Stream::startTuneThread() {
+	if (!_tuneThreadStarted) {
+		_tuneThreadStarted = _tuneThread.startThread();
+		if (!_tuneThreadStarted) {
+			SI_LOG_ERROR("Stream: %d, Start tuning thread failed", _streamID);
+		}
+	}
+	return _tuneThreadStarted;
+}
+
+void Stream::requestUpdate(const int clientID) {
+	{
+		std::lock_guard<std::mutex> lock(_tuneRequestMutex);
+		_tuneRequested = true;
+		_tuneClientID = clientID;
+	}
+	_tuneRequestCond.notify_one();
+}
+
+void Stream::queueDeviceRequest(const FunctionDeviceRequest &request) {
+	if (!startTuneThread()) {
+		return;
+	}
+	{
+		std::lock_guard<std::mutex> lock(_tuneRequestMutex);
+		_deviceRequests.push_back(request);
+	}
+	_tuneRequestCond.notify_one();
+}
+
+void Stream::queueSharedPIDs(const std::vector<int> &pids, const bool use) {
+	if (pids.empty()) {
+		return;
+	}
+	queueDeviceRequest([this, pids, use]() {
+		for (const int pid : pids) {
+			_device->setSharedPID(pid, use);
+		}
+	});
+}
+
+bool Stream::tuneThreadExecute() {
+	std::vector<FunctionDeviceRequest> requests;
+	bool update;
+	int clientID;
+	unsigned long generation;
+	{
+		std::unique_lock<std::mutex> lock(_tuneRequestMutex);
+		if (!_tuneRequestCond.wait_for(lock, std::chrono::milliseconds(100),
+				[this] { return _tuneRequested || !_deviceRequests.empty(); })) {
+			return true;
+		}
+		requests.swap(_deviceRequests);
+		update = _tuneRequested;
+		_tuneRequested = false;
+		clientID = _tuneClientID;
+		// Taken together with the requests, so a teardown queued after
+		// them cancels this update
+		generation = _tuneGeneration;
+	}
 
+	// Change and update the device without holding _mutex, so the RTSP/HTTP
+	// servers can still handle other requests during tuning
+	bool changed = false;
+	{
+		base::MutexLock lock(_deviceMutex);
+		for (const FunctionDeviceRequest &request : requests) {
+			request();
+		}
+		if (!update || generation != _tuneGeneration) {
+			return true;
+		}
+		// Get changed flag, before device update, because it resets it
+		changed = _device->hasDeviceDataChanged();
+	}
+
+	// Channel changed?.. pause Stream
+	if (changed) {
+		base::MutexLock lock(_mutex);
+		if (generation != _tuneGeneration) {
+			return true;
+		}
+		if (_streaming && _streamActive) {
+			_streaming->pauseStreaming(clientID);
+		}
+	}
+
+	bool updated = false;
+	{
+		base::MutexLock lock(_deviceMutex);
+		if (generation != _tuneGeneration) {
+			// Stream was teardown before we could start
+			return true;
+		}
+		updated = _device->update();
+	}
+
+	base::MutexLock lock(_mutex);
+	if (generation != _tuneGeneration) {
+		// Stream was teardown during tuning
+		return true;
+	}
+	if (!updated) {
+		SI_LOG_ERROR("Stream: %d, Update of input device failed", _streamID);
+		return true;
+	}
 	// start or restart streaming again
 	if (_streaming) {
 		if (!_streamActive) {
@@ -333,12 +835,32 @@ bool Stream::teardown(int clientID) {
 	SI_LOG_INFO("Stream: %d, Teardown StreamClient[%d] with SessionID %s",
 	            _streamID, clientID, _client[clientID].getSessionID().c_str());
 
+	// A client sharing this stream, so keep streaming to the others
+	if (clientID != 0 && _streamInUse) {
+		detachSharedClient(clientID);
+		if (_streamActive) {
+			requestUpdate(0);
+		}
+		return true;
+	}
+
+	// Cancel any pending update request and an update in progress, so we
+	// do not have to wait for tuning
+	{
+		std::lock_guard<std::mutex> lock(_tuneRequestMutex);
+		_tuneRequested = false;
+		++_tuneGeneration;
+	}
+
 	// Stop streaming by deleting object
 	if (_streaming) {
 		_streaming.reset(nullptr);
 	}
 
-	_device->teardown();
+	// The tuning thread will teardown the device after its current update
+	queueDeviceRequest([this]() {
+		_device->teardown();
+	});
 
 	// as last, else sessionID and IP is reset
 	_client[clientID].teardown();
@@ -355,6 +877,22 @@ bool Stream::teardown(int clientID) {
 	return true;
 }
 
+bool Stream::processRtcpData(const int fd, const std::string &data) {
+	base::MutexLock lock(_mutex);
+	for (std::size_t i = 0; i < MAX_CLIENTS; ++i) {
+		if (_client[i].getHttpSocketFD() != fd) {
+			continue;
+		}
+		// RTCP is interleaved on the odd channel, after RTP
+		if (_streaming && data.size() > 4 && (data[1] & 0x01) != 0) {
+			_streaming->processRtcpReport(i,
+				reinterpret_cast<const uint8_t *>(data.data()) + 4, data.size() - 4);
+		}
+		return true;
+	}
+	return false;
+}
+
 bool Stream::processStreamingRequest(const std::string &msg, const int clientID, const std::string &method) {
 	base::MutexLock lock(_mutex);
 
@@ -370,15 +908,44 @@ bool Stream::processStreamingRequest(const std::string &msg, const int clientID,
 		_client[clientID].setUserAgent(userAgent);
 	}
 
+	// The device data is changed by the tuning thread, so we do not have
+	// to wait here for a tune in progress
 	if ((method == "SETUP" || method == "PLAY"  || method == "GET") &&
 	    StringConverter::hasTransportParameters(msg)) {
-		_device->parseStreamString(msg, method);
-	}
-
-	// Channel changed?.. stop/pause Stream
-	if (_device->hasDeviceDataChanged()) {
-		if (_streaming) {
-			_streaming->pauseStreaming(clientID);
+		std::vector<int> opened;
+		std::vector<int> closed;
+		if (clientID == 0) {
+			const bool retune = StringConverter::getDoubleParameter(msg, method, "freq=") != -1.0 &&
+				!_device->isTunedTo(msg, method);
+			if (retune && hasSharedClients()) {
+				SI_LOG_INFO("Stream: %d, Owner retunes, stop all StreamClients sharing this stream", _streamID);
+				for (std::size_t i = 1; i < MAX_CLIENTS; ++i) {
+					if (_client[i].getSessionID() != "-1") {
+						detachSharedClient(i);
+					}
+				}
+			}
+			_client[0].parsePIDs(msg, method, retune, opened, closed);
+			// Open the PIDs of the clients sharing this stream again after
+			// the owner requested its PIDs
+			const std::vector<int> shared = getSharedPIDs();
+			queueDeviceRequest([this, msg, method, shared]() {
+				_device->parseStreamString(msg, method);
+				for (const int pid : shared) {
+					_device->setSharedPID(pid, true);
+				}
+			});
+		} else {
+			// Only the PIDs of a client sharing this stream can change
+			_client[clientID].parsePIDs(msg, method, false, opened, closed);
+			std::vector<int> unused;
+			for (const int pid : closed) {
+				if (!isPIDRequestedByOtherClient(pid, clientID)) {
+					unused.push_back(pid);
+				}
+			}
+			queueSharedPIDs(opened, true);
+			queueSharedPIDs(unused, false);
 		}
 	}
 
@@ -442,3 +1009,53 @@ bool Stream::processStreamingRequest(const std::string &msg, const int clientID,
 	_client[clientID].restartWatchDog();
 	return true;
 }
+
+bool Stream::hasSharedClients() const {
+	for (std::size_t i = 1; i < MAX_CLIENTS; ++i) {
+		if (_client[i].getSessionID() != "-1") {
+			return true;
+		}
+	}
+	return false;
+}
+
+bool Stream::isPIDRequestedByOtherClient(const int pid, const int clientID) const {
+	for (std::size_t i = 0; i < MAX_CLIENTS; ++i) {
+		if (static_cast<int>(i) != clientID && _client[i].getSessionID() != "-1" &&
+		    _client[i].isPIDSet(pid)) {
+			return true;
+		}
+	}
+	return false;
+}
+
+std::vector<int> Stream::getSharedPIDs() const {
+	std::vector<int> pids;
+	for (std::size_t i = 1; i < MAX_CLIENTS; ++i) {
+		if (_client[i].getSessionID() == "-1") {
+			continue;
+		}
+		for (std::size_t pid = 0; pid < mpegts::PidTable::MAX_PIDS; ++pid) {
+			if (_client[i].isPIDSet(pid)) {
+				pids.push_back(pid);
+			}
+		}
+	}
+	return pids;
+}
+
+void Stream::detachSharedClient(const int clientID) {
+	if (_streaming) {
+		_streaming->removeSharedClient(clientID);
+	}
+	std::vector<int> closed;
+	_client[clientID].clearPIDs(closed);
+	std::vector<int> unused;
+	for (const int pid : closed) {
+		if (!isPIDRequestedByOtherClient(pid, clientID)) {
+			unused.push_back(pid);
+		}
+	}
+	queueSharedPIDs(unused, false);
+	_client[clientID].teardown();
+}
@@ -23,18 +23,27 @@
 #include <FwDecl.h>
 #include <StreamClient.h>
 #include <StreamInterface.h>
+#include <base/Mutex.h>
+#include <base/Thread.h>
 #include <base/XMLSupport.h>
 #include <input/Device.h>
 
 #include <atomic>
+#include <condition_variable>
 #include <cstddef>
+#include <functional>
 #include <memory>
+#include <mutex>
 #include <string>
 #include <vector>
 
 FW_DECL_NS0(SocketClient);
 FW_DECL_NS1(output, StreamThreadBase);
 FW_DECL_NS1(input, DeviceData);
+FW_DECL_NS1(input, IngestReactor);
+FW_DECL_NS1(mpegts, PacketPool);
+FW_DECL_NS1(output, EgressRing);
+FW_DECL_NS1(output, RtcpService);
 
 FW_DECL_UP_NS1(output, StreamThreadBase);
 FW_DECL_SP_NS2(decrypt, dvbapi, Client);
@@ -89,6 +98,14 @@ class Stream :
 
 		virtual input::SpDevice getInputDevice() const final;
 
+		virtual input::IngestReactor *getIngestReactor() const final;
+
+		virtual mpegts::PacketPool *getPacketPool() const final;
+
+		virtual output::EgressRing *getEgressRing() const final;
+
+		virtual output::RtcpService *getRtcpService() const final;
+
 #ifdef LIBDVBCSA
 		///
 		virtual decrypt::dvbapi::SpClient getDecryptDevice() const final;
@@ -100,16 +117,62 @@ class Stream :
 
 		virtual uint32_t getSPC() const final;
 
-		virtual unsigned int getRtcpSignalUpdateFrequency() const final;
-
 		virtual uint32_t getSOC() const final;
 
-		virtual void addRtpData(uint32_t byte, long timestamp) final;
+		virtual void addRtpData(uint32_t packets, uint32_t byte, long timestamp) final;
 
 		virtual double getRtpPayload() const final;
 
+		virtual void addDroppedPackets(uint32_t packets) final;
+
+		virtual unsigned int getPacingBurst() const final;
+
+		virtual unsigned int getPacingLatency() const final;
+
+		virtual unsigned int getRtpTSPackets() const final;
+
+		virtual unsigned int getRtpBatchSize() const final;
+
+		virtual unsigned int getRtpBatchHold() const final;
+
+		virtual bool isRtpGSOEnabled() const final;
+
+		virtual unsigned int getRtpTcpTSPackets() const final;
+
+		virtual unsigned int getHttpTSPackets() const final;
+
+		virtual bool isHttpZeroCopyEnabled() const final;
+
+		virtual bool isHttpSpliceEnabled() const final;
+
+		virtual unsigned int getSinkQueueSize() const final;
+
+		virtual unsigned int getSinkQueueTime() const final;
+
+		virtual unsigned int getSinkPolicy() const final;
+
+		virtual unsigned int getSinkDeadline() const final;
+
+		virtual std::string getSinkReducedPIDs() const final;
+
+		virtual unsigned int getRtcpAdaptation() const final;
+
+		virtual unsigned int getRtcpLossThreshold() const final;
+
+		virtual std::string getRtcpLowPriorityPIDs() const final;
+
+		virtual bool isRtpRetransmitEnabled() const final;
+
+		virtual unsigned int getRtpRetransmitWindow() const final;
+
+		virtual unsigned int getRtpRetransmitMemory() const final;
+
+		virtual unsigned int getRtpRetransmitRate() const final;
+
 		virtual std::string attributeDescribeString() const final;
 
+		virtual uint64_t getDescribeVersion() const final;
+
 		virtual std::string getDescribeMediaLevelString() const final;
 
 		// =======================================================================
@@ -134,6 +197,32 @@ class Stream :
 			}
 		}
 
+		/// Set the reactor that should watch the input device of this stream,
+		/// this should be done before any streaming is started
+		/// @param reactor specifies the reactor or nullptr to disable it
+		void setIngestReactor(input::IngestReactor *reactor) {
+			_ingestReactor = reactor;
+		}
+
+		/// Set the packet pool the stream buffers are allocated from,
+		/// this should be done before any streaming is started
+		void setPacketPool(mpegts::PacketPool *pool) {
+			_packetPool = pool;
+		}
+
+		/// Set the io_uring that should send the output of this stream,
+		/// this should be done before any streaming is started
+		/// @param ring specifies the ring or nullptr to disable it
+		void setEgressRing(output::EgressRing *ring) {
+			_egressRing = ring;
+		}
+
+		/// Set the service that should send the RTCP reports of this stream,
+		/// this should be done before any streaming is started
+		void setRtcpService(output::RtcpService *service) {
+			_rtcpService = service;
+		}
+
 		/// Find the clientID for the requested parameters
 		bool findClientIDFor(SocketClient &socketClient,
 		                     bool newSession,
@@ -141,12 +230,29 @@ class Stream :
 		                     const std::string &method,
 		                     int &clientID);
 
+		/// Find a free clientID for a new session that can share the input
+		/// device of this stream, because it is tuned to the requested transponder
+		/// @return true if a clientID is found
+		bool shareClientIDFor(SocketClient &socketClient,
+		                      const std::string &method,
+		                      int &clientID);
+
+		/// Update the monitor signals of the input device, this is called
+		/// periodically by the signal monitor and will only sample an active
+		/// device every 'rtcpSignalUpdate' calls
+		void monitorSignal();
+
 		/// Check is this stream used already
 		bool streamInUse() const {
 			base::MutexLock lock(_mutex);
 			return _streamInUse;
 		}
 
+		/// Get a score on how fast the input device of this stream can deliver
+		/// the first packet of the request (higher is faster)
+		/// @see input::Device::allocationScore
+		int allocationScore(const std::string &msg, const std::string &method) const;
+
 		/// Check is this stream enabled, can we use it?
 		bool streamEnabled() const {
 			base::MutexLock lock(_mutex);
@@ -174,9 +280,60 @@ class Stream :
 		///
 		bool processStreamingRequest(const std::string &msg, int clientID, const std::string &method);
 
-		///
+		/// Process an interleaved RTCP packet ('$', channel, length and data)
+		/// a RTP/TCP client send on its RTSP connection
+		/// @param fd specifies the RTSP connection it was received on
+		/// @return true if a client of this stream uses that connection
+		bool processRtcpData(int fd, const std::string &data);
+
+		/// Request to update (tune) the input device and start streaming to
+		/// clientID. The update is done by the tuning thread of this stream,
+		/// so this function does not block on tuning or locking the frontend.
+		/// @return true if the update request is queued
 		bool update(int clientID, bool start);
 
+		// =======================================================================
+		// -- Other member functions ---------------------------------------------
+		// =======================================================================
+	private:
+
+		/// A change of the input device, done by the tuning thread
+		using FunctionDeviceRequest = std::function<void()>;
+
+		/// Thread execute function of the tuning thread @see base::Thread
+		/// This will wait for device or update requests and then apply them
+		/// to the input device
+		bool tuneThreadExecute();
+
+		/// Start the tuning thread, if it is not running yet
+		/// @return true if the tuning thread is running
+		bool startTuneThread();
+
+		/// Queue an update request for the tuning thread
+		void requestUpdate(int clientID);
+
+		/// Queue a change of the input device for the tuning thread, so the
+		/// caller does not have to wait for a tune in progress
+		void queueDeviceRequest(const FunctionDeviceRequest &request);
+
+		/// Queue a request to open or close the PIDs of the clients sharing
+		/// this stream
+		void queueSharedPIDs(const std::vector<int> &pids, bool use);
+
+		/// Check if a client that shares this stream is active
+		bool hasSharedClients() const;
+
+		/// Check if an other client than clientID requested this PID
+		bool isPIDRequestedByOtherClient(int pid, int clientID) const;
+
+		/// Get the PIDs of the clients sharing this stream, so the input device
+		/// can open them again, for ex. after the owner requested other PIDs
+		std::vector<int> getSharedPIDs() const;
+
+		/// Stop streaming to a client sharing this stream and close the PIDs
+		/// only it requested
+		void detachSharedClient(int clientID);
+
 		// =======================================================================
 		// -- Data members -------------------------------------------------------
 		// =======================================================================
@@ -188,19 +345,57 @@ class Stream :
 		StreamingType     _streamingType; ///
 		bool              _enabled;       /// is this stream enabled, could we use it?
 		bool              _streamInUse;   ///
-		bool              _streamActive;  ///
+		std::atomic<bool> _streamActive;  ///
 
 		StreamClient     *_client;        /// defines the participants of this stream
 		                                  /// index 0 is the owner of this stream
 		output::UpStreamThreadBase _streaming; ///
 		decrypt::dvbapi::SpClient _decrypt;///
 		input::SpDevice _device;          ///
+		input::IngestReactor *_ingestReactor; /// nullptr if not used
+		mpegts::PacketPool *_packetPool;  /// shared by all streams
+		output::EgressRing *_egressRing;  /// nullptr if not used
+		output::RtcpService *_rtcpService; /// shared by all streams
 		std::atomic<uint32_t> _ssrc;      /// synchronisation source identifier of sender
 		std::atomic<uint32_t> _spc;       /// sender RTP packet count  (used in SR packet)
 		std::atomic<uint32_t> _soc;       /// sender RTP payload count (used in SR packet)
 		std::atomic<long> _timestamp;     ///
 		std::atomic<double> _rtp_payload; ///
-		unsigned int _rtcpSignalUpdate;   ///
+		std::atomic<uint32_t> _dropped;   /// TS packets dropped by a slow output
+		std::atomic<unsigned int> _rtcpSignalUpdate; /// signal monitor calls to skip
+		std::atomic<unsigned int> _pacingBurst;   /// max buffers send back-to-back, 0 no pacing
+		std::atomic<unsigned int> _pacingLatency; /// pacer latency target in msec
+		std::atomic<unsigned int> _rtpTSPackets;    /// TS packets per RTP/UDP datagram
+		std::atomic<unsigned int> _rtpBatchSize;    /// RTP/UDP datagrams per sendmmsg
+		std::atomic<unsigned int> _rtpBatchHold;    /// max msec to hold a partial batch
+		std::atomic<bool> _rtpGSO;                  /// send RTP/UDP batches with UDP GSO
+		std::atomic<unsigned int> _rtpTcpTSPackets; /// TS packets per RTP/TCP packet
+		std::atomic<unsigned int> _httpTSPackets;   /// TS packets per HTTP write
+		std::atomic<bool> _httpZeroCopy;            /// send HTTP with MSG_ZEROCOPY
+		std::atomic<bool> _httpSplice;              /// splice the input device to HTTP
+		std::atomic<unsigned int> _sinkQueueSize;   /// TCP client backlog in KBytes
+		std::atomic<unsigned int> _sinkQueueTime;   /// TCP client backlog in msec
+		std::atomic<unsigned int> _sinkPolicy;      /// @see output::TcpSink::Policy
+		std::atomic<unsigned int> _sinkDeadline;    /// msec a TCP client may be too slow
+		std::string _sinkReducedPIDs;               /// PIDs send to a too slow TCP client
+		std::atomic<unsigned int> _rtcpAdaptation;  /// @see output::RtcpFeedback::Adaptation
+		std::atomic<unsigned int> _rtcpLossThreshold; /// reported loss in % of a congested client
+		std::string _rtcpLowPriorityPIDs;           /// PIDs not send to a congested client
+		std::atomic<bool> _rtpRetransmit;           /// send lost RTP/UDP packets again
+		std::atomic<unsigned int> _rtpRetransmitWindow; /// msec send packets are kept
+		std::atomic<unsigned int> _rtpRetransmitMemory; /// KBytes of kept packets per session
+		std::atomic<unsigned int> _rtpRetransmitRate;   /// max retransmit rate in % of stream
+		unsigned int _signalUpdate;       /// calls left before the next sample
+
+		base::Thread _tuneThread;         /// updates (tunes) the input device
+		bool _tuneThreadStarted;          ///
+		base::Mutex _deviceMutex;         /// held by the tuning thread while it changes _device
+		std::mutex _tuneRequestMutex;     /// protects the requests below
+		std::condition_variable _tuneRequestCond;
+		std::vector<FunctionDeviceRequest> _deviceRequests; /// in order of arrival
+		bool _tuneRequested;              ///
+		int _tuneClientID;                ///
+		std::atomic<unsigned long> _tuneGeneration; /// increased on every teardown
 
 };
 
@@ -20,9 +20,13 @@
 #include <StreamClient.h>
 
 #include <Log.h>
+#include <StringConverter.h>
 #include <socket/SocketClient.h>
 #include <Stream.h>
 
+#include <cctype>
+#include <cerrno>
+
 #include <sys/uio.h>
 
 // ============================================================================
@@ -39,7 +43,11 @@ StreamClient::StreamClient() :
 		_sessionTimeout(60),
 		_sessionID("-1"),
 		_userAgent("None"),
-		_cseq(0) {}
+		_cseq(0) {
+	for (std::size_t i = 0; i < mpegts::PidTable::MAX_PIDS; ++i) {
+		_pids[i] = false;
+	}
+}
 
 StreamClient::~StreamClient() {}
 
@@ -58,6 +66,10 @@ void StreamClient::teardown() {
 
 	// Do not delete
 	_socketClient = nullptr;
+
+	for (std::size_t i = 0; i < mpegts::PidTable::MAX_PIDS; ++i) {
+		_pids[i] = false;
+	}
 }
 
 void StreamClient::restartWatchDog() {
@@ -104,6 +116,88 @@ SocketAttr &StreamClient::getRtcpSocketAttr() {
 	return _rtcp;
 }
 
+// ============================================================================
+//  -- PID member functions ---------------------------------------------------
+// ============================================================================
+
+void StreamClient::parsePIDs(const std::string &msg, const std::string &method,
+		const bool clear, std::vector<int> &opened, std::vector<int> &closed) {
+	base::MutexLock lock(_mutex);
+	// Same as the frontend, always request PID 0 - Program Association
+	// Table (PAT) and the user defined PIDs
+	static const std::string addPids = ",0,1,16,17,18";
+
+	const std::string pidsList = StringConverter::getStringParameter(msg, method, "pids=");
+	// A SETUP/PLAY with query but without any 'xxxpids=' is a channel change
+	// (TvHeadend Bug #4809)
+	const bool noPids = (method == "SETUP" || method == "PLAY") &&
+		StringConverter::hasTransportParameters(msg) && msg.find("pids=") == std::string::npos;
+	if (clear || noPids || !pidsList.empty()) {
+		for (std::size_t i = 0; i < mpegts::PidTable::MAX_PIDS; ++i) {
+			setPID(i, false, opened, closed);
+		}
+	}
+	if (!pidsList.empty()) {
+		parsePIDList(pidsList + addPids, true, opened, closed);
+	}
+	const std::string addpidsList = StringConverter::getStringParameter(msg, method, "addpids=");
+	if (!addpidsList.empty()) {
+		parsePIDList(addpidsList + addPids, true, opened, closed);
+	}
+	const std::string delpidsList = StringConverter::getStringParameter(msg, method, "delpids=");
+	if (!delpidsList.empty()) {
+		parsePIDList(delpidsList, false, opened, closed);
+	}
+}
+
+void StreamClient::clearPIDs(std::vector<int> &closed) {
+	base::MutexLock lock(_mutex);
+	std::vector<int> opened;
+	for (std::size_t i = 0; i < mpegts::PidTable::MAX_PIDS; ++i) {
+		setPID(i, false, opened, closed);
+	}
+}
+
+void StreamClient::setPID(const int pid, const bool use,
+		std::vector<int> &opened, std::vector<int> &closed) {
+	if (pid < 0 || pid >= static_cast<int>(mpegts::PidTable::MAX_PIDS) || _pids[pid] == use) {
+		return;
+	}
+	_pids[pid] = use;
+	// Changed back within the same request, so it is not changed at all
+	std::vector<int> &undo = use ? closed : opened;
+	for (std::vector<int>::iterator it = undo.begin(); it != undo.end(); ++it) {
+		if (*it == pid) {
+			undo.erase(it);
+			return;
+		}
+	}
+	(use ? opened : closed).push_back(pid);
+}
+
+void StreamClient::parsePIDList(const std::string &pids, const bool use,
+		std::vector<int> &opened, std::vector<int> &closed) {
+	if (pids.find("none") != std::string::npos) {
+		return;
+	}
+	if (pids.find("all") != std::string::npos) {
+		setPID(mpegts::PidTable::ALL_PIDS, use, opened, closed);
+		return;
+	}
+	std::string::size_type begin = 0;
+	while (begin < pids.size()) {
+		std::string::size_type end = pids.find_first_of(",", begin);
+		if (end == std::string::npos) {
+			end = pids.size();
+		}
+		const std::string pid = pids.substr(begin, end - begin);
+		if (!pid.empty() && std::isdigit(pid[0]) != 0) {
+			setPID(std::stoi(pid), use, opened, closed);
+		}
+		begin = end + 1;
+	}
+}
+
 // ============================================================================
 //  -- HTTP member functions --------------------------------------------------
 // ============================================================================
@@ -118,6 +212,45 @@ bool StreamClient::writeHttpData(const struct iovec *iov, int iovcnt) {
 	return (_socketClient == nullptr) ? false : _socketClient->writeData(iov, iovcnt);
 }
 
+ssize_t StreamClient::sendHttpData(const struct iovec *iov, int iovcnt, int flags) {
+	base::MutexLock lock(_mutex);
+	if (_socketClient == nullptr) {
+		errno = EBADF;
+		return -1;
+	}
+	return _socketClient->sendData(iov, iovcnt, flags);
+}
+
+int StreamClient::getHttpSocketFD() const {
+	base::MutexLock lock(_mutex);
+	return (_socketClient == nullptr) ? -1 : _socketClient->getFD();
+}
+
+bool StreamClient::getHttpTcpInfo(unsigned int &sendQueue, unsigned int &rtt,
+		unsigned int &retransmits) const {
+	base::MutexLock lock(_mutex);
+	return (_socketClient == nullptr) ? false : _socketClient->getTcpInfo(sendQueue, rtt, retransmits);
+}
+
+bool StreamClient::setHttpZeroCopy() {
+	base::MutexLock lock(_mutex);
+	return (_socketClient == nullptr) ? false : _socketClient->setZeroCopy();
+}
+
+bool StreamClient::getHttpZeroCopyCompletion(uint32_t &lo, uint32_t &hi, bool &copied) {
+	base::MutexLock lock(_mutex);
+	return (_socketClient == nullptr) ? false : _socketClient->getZeroCopyCompletion(lo, hi, copied);
+}
+
+ssize_t StreamClient::spliceHttpData(const int pipeFD, const std::size_t len) {
+	base::MutexLock lock(_mutex);
+	if (_socketClient == nullptr) {
+		errno = EBADF;
+		return -1;
+	}
+	return _socketClient->spliceData(pipeFD, len);
+}
+
 int StreamClient::getHttpSocketPort() const {
 	base::MutexLock lock(_mutex);
 	return (_socketClient == nullptr) ? 0 : _socketClient->getSocketPort();
@@ -24,9 +24,12 @@
 #include <socket/SocketAttr.h>
 #include <socket/SocketClient.h>
 #include <base/Mutex.h>
+#include <mpegts/PidTable.h>
 
+#include <atomic>
 #include <ctime>
 #include <string>
+#include <vector>
 
 /// StreamClient defines the owner/participants of an stream
 class StreamClient {
@@ -150,6 +153,34 @@ class StreamClient {
 			return _sessionTimeout;
 		}
 
+		// =====================================================================
+		//  -- PID member functions --------------------------------------------
+		// =====================================================================
+
+		/// Update the PIDs requested by this client with the 'pids=', 'addpids='
+		/// and 'delpids=' of the request
+		/// @param msg
+		/// @param method
+		/// @param clear specifies if the previous requested PIDs should be cleared
+		/// @param opened will be filled with the PIDs this client requests now
+		/// @param closed will be filled with the PIDs this client does not request anymore
+		void parsePIDs(const std::string &msg, const std::string &method, bool clear,
+			std::vector<int> &opened, std::vector<int> &closed);
+
+		/// Clear all requested PIDs of this client
+		/// @param closed will be filled with the PIDs this client does not request anymore
+		void clearPIDs(std::vector<int> &closed);
+
+		/// Check if this client requested this PID (or 'all')
+		bool isPIDRequested(int pid) const {
+			return _pids[mpegts::PidTable::ALL_PIDS] || _pids[pid];
+		}
+
+		/// Check if this client requested exactly this PID
+		bool isPIDSet(int pid) const {
+			return _pids[pid];
+		}
+
 		// =====================================================================
 		//  -- HTTP member functions -------------------------------------------
 		// =====================================================================
@@ -160,6 +191,30 @@ class StreamClient {
 		/// Send HTTP/RTP_TCP data to connected client
 		bool writeHttpData(const struct iovec *iov, int iovcnt);
 
+		/// Send HTTP/RTP_TCP data to connected client, without waiting when
+		/// flags has MSG_DONTWAIT
+		/// @return the amount of bytes send, or -1 and errno tells why
+		ssize_t sendHttpData(const struct iovec *iov, int iovcnt, int flags);
+
+		/// Get the file descriptor of the HTTP/RTP_TCP connected client
+		int getHttpSocketFD() const;
+
+		/// Get the backlog of the HTTP/RTP_TCP connection @see SocketAttr
+		bool getHttpTcpInfo(unsigned int &sendQueue, unsigned int &rtt,
+			unsigned int &retransmits) const;
+
+		/// Let the HTTP/RTP_TCP connection send with MSG_ZEROCOPY @see SocketAttr
+		bool setHttpZeroCopy();
+
+		/// Get a completion of the MSG_ZEROCOPY sends to the HTTP/RTP_TCP
+		/// connected client @see SocketAttr
+		bool getHttpZeroCopyCompletion(uint32_t &lo, uint32_t &hi, bool &copied);
+
+		/// Move the data of a pipe to the HTTP/RTP_TCP connected client,
+		/// without waiting
+		/// @return the amount of bytes moved, or -1 and errno tells why
+		ssize_t spliceHttpData(int pipeFD, std::size_t len);
+
 		/// Get the HTTP/RTP_TCP port of the connected client
 		int getHttpSocketPort() const;
 
@@ -169,6 +224,15 @@ class StreamClient {
 		/// Set the HTTP/RTP_TCP network send buffer size for this Socket
 		bool setHttpNetworkSendBufferSize(int size);
 
+	private:
+
+		/// Set the PID requested or not
+		void setPID(int pid, bool use, std::vector<int> &opened, std::vector<int> &closed);
+
+		/// Parse an PID list for example '0,1,16,17'
+		void parsePIDList(const std::string &pids, bool use,
+			std::vector<int> &opened, std::vector<int> &closed);
+
 		// =====================================================================
 		// -- Data members -----------------------------------------------------
 		// =====================================================================
@@ -187,6 +251,9 @@ class StreamClient {
 		int          _cseq;
 		SocketAttr   _rtp;
 		SocketAttr   _rtcp;
+		// The PIDs requested by this client, these are read by the streaming
+		// thread for filtering the TS packets of a shared stream
+		std::atomic<bool> _pids[mpegts::PidTable::MAX_PIDS];
 };
 
 #endif // STREAM_CLIENT_H_INCLUDE
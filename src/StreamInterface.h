@@ -23,6 +23,10 @@
 #include <FwDecl.h>
 
 FW_DECL_NS0(StreamClient);
+FW_DECL_NS1(input, IngestReactor);
+FW_DECL_NS1(mpegts, PacketPool);
+FW_DECL_NS1(output, EgressRing);
+FW_DECL_NS1(output, RtcpService);
 FW_DECL_SP_NS1(input, Device);
 FW_DECL_SP_NS2(decrypt, dvbapi, Client);
 
@@ -51,6 +55,21 @@ class StreamInterface {
 		///
 		virtual input::SpDevice getInputDevice() const = 0;
 
+		/// Get the reactor that watches the input device for data
+		/// @return the reactor or nullptr if the stream thread should poll
+		/// the input device itself
+		virtual input::IngestReactor *getIngestReactor() const = 0;
+
+		/// Get the packet pool the stream buffers are allocated from
+		virtual mpegts::PacketPool *getPacketPool() const = 0;
+
+		/// Get the io_uring that sends the output of the stream threads
+		/// @return the ring or nullptr if the stream thread should send itself
+		virtual output::EgressRing *getEgressRing() const = 0;
+
+		/// Get the service that sends the RTCP reports of all streams
+		virtual output::RtcpService *getRtcpService() const = 0;
+
 #ifdef LIBDVBCSA
 		///
 		virtual decrypt::dvbapi::SpClient getDecryptDevice() const = 0;
@@ -64,21 +83,103 @@ class StreamInterface {
 		///
 		virtual uint32_t getSPC() const = 0;
 
-		/// The Frontend Monitor update interval
-		virtual unsigned int getRtcpSignalUpdateFrequency() const = 0;
-
 		///
 		virtual uint32_t getSOC() const  = 0;
 
-		///
-		virtual void addRtpData(uint32_t byte, long timestamp)  = 0;
+		/// Add send RTP packets and their payload
+		/// @param packets specifies the amount of RTP packets send
+		/// @param byte specifies the payload of these RTP packets
+		/// @param timestamp specifies the RTP timestamp of the last packet
+		virtual void addRtpData(uint32_t packets, uint32_t byte, long timestamp)  = 0;
 
 		///
 		virtual double getRtpPayload() const = 0;
 
+		/// Add TS packets that are dropped, because the output can not keep up
+		virtual void addDroppedPackets(uint32_t packets) = 0;
+
+		/// Get the max buffers the pacer sends back-to-back, 0 disables pacing
+		virtual unsigned int getPacingBurst() const = 0;
+
+		/// Get the latency target of the pacer in msec
+		virtual unsigned int getPacingLatency() const = 0;
+
+		/// Get the TS packets to send in one RTP/UDP datagram, more then 7
+		/// needs a jumbo frame network
+		virtual unsigned int getRtpTSPackets() const = 0;
+
+		/// Get the amount of RTP/UDP datagrams to send with one system call
+		virtual unsigned int getRtpBatchSize() const = 0;
+
+		/// Get the max time in msec a partial RTP/UDP batch is held, waiting
+		/// for more buffers to fill it
+		virtual unsigned int getRtpBatchHold() const = 0;
+
+		/// Check if RTP/UDP batches should be send as one UDP GSO send, that
+		/// the kernel or NIC segments into the datagrams
+		virtual bool isRtpGSOEnabled() const = 0;
+
+		/// Get the TS packets to send in one RTP/TCP packet
+		virtual unsigned int getRtpTcpTSPackets() const = 0;
+
+		/// Get the TS packets to send in one HTTP write
+		virtual unsigned int getHttpTSPackets() const = 0;
+
+		/// Check if HTTP should send with MSG_ZEROCOPY
+		virtual bool isHttpZeroCopyEnabled() const = 0;
+
+		/// Check if HTTP may splice the input device to the client
+		virtual bool isHttpSpliceEnabled() const = 0;
+
+		/// Get the max backlog of a too slow HTTP/RTP_TCP client in KBytes
+		virtual unsigned int getSinkQueueSize() const = 0;
+
+		/// Get the max backlog of a too slow HTTP/RTP_TCP client in msec
+		virtual unsigned int getSinkQueueTime() const = 0;
+
+		/// Get what to do with a too slow HTTP/RTP_TCP client
+		/// @see output::TcpSink::Policy
+		virtual unsigned int getSinkPolicy() const = 0;
+
+		/// Get the msec a HTTP/RTP_TCP client may be too slow, before it is
+		/// disconnected
+		virtual unsigned int getSinkDeadline() const = 0;
+
+		/// Get the PIDs (for ex. '0,1,16,17') still send to a too slow
+		/// HTTP/RTP_TCP client
+		virtual std::string getSinkReducedPIDs() const = 0;
+
+		/// Get how to adapt the output to the loss a RTP client reports
+		/// @see output::RtcpFeedback::Adaptation
+		virtual unsigned int getRtcpAdaptation() const = 0;
+
+		/// Get the percentage of lost packets, reported by a RTP client, from
+		/// where the client is congested
+		virtual unsigned int getRtcpLossThreshold() const = 0;
+
+		/// Get the PIDs (for ex. '18') not send to a congested RTP/UDP client
+		virtual std::string getRtcpLowPriorityPIDs() const = 0;
+
+		/// Check if the RTP packets of an unicast RTSP session should be send
+		/// again, when the client reports them lost (RFC 4588)
+		virtual bool isRtpRetransmitEnabled() const = 0;
+
+		/// Get how long the send RTP packets are kept, in msec
+		virtual unsigned int getRtpRetransmitWindow() const = 0;
+
+		/// Get the max memory for the send RTP packets of a session, in KBytes
+		virtual unsigned int getRtpRetransmitMemory() const = 0;
+
+		/// Get the max retransmission rate, in percent of the stream rate
+		virtual unsigned int getRtpRetransmitRate() const = 0;
+
 		/// Get the stream Description string for RTCP and DESCRIBE command
 		virtual std::string attributeDescribeString() const = 0;
 
+		/// Get the version of the stream Description string, it changes
+		/// when the Description may have changed
+		virtual uint64_t getDescribeVersion() const = 0;
+
 		/// Get the RTSP Describe Media-Level string
 		virtual std::string getDescribeMediaLevelString() const = 0;
 
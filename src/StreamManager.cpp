@@ -24,17 +24,28 @@
 #include <StreamClient.h>
 #include <socket/SocketClient.h>
 #include <StringConverter.h>
+#include <input/IngestReactor.h>
 #include <input/childpipe/TSReader.h>
 #include <input/dvb/Frontend.h>
 #include <input/file/TSReader.h>
 #include <input/stream/Streamer.h>
+#include <mpegts/PacketPool.h>
+#include <output/EgressRing.h>
+#include <output/RtcpService.h>
+#include <output/StreamThreadBase.h>
+#include <output/TcpSink.h>
 #ifdef LIBDVBCSA
 	#include <decrypt/dvbapi/Client.h>
 	#include <input/dvb/FrontendDecryptInterface.h>
 #endif
 
-#include <random>
+#include <algorithm>
+#include <chrono>
 #include <cmath>
+#include <random>
+#include <thread>
+#include <utility>
+#include <vector>
 
 #include <assert.h>
 
@@ -44,13 +55,18 @@
 
 StreamManager::StreamManager() :
 	XMLSupport(),
-	_decrypt(nullptr) {
+	_decrypt(nullptr),
+	_ingestReactor(nullptr),
+	_packetPool(nullptr),
+	_signalMonitor("SignalMonitor", std::bind(&StreamManager::signalMonitorExecute, this)) {
 #ifdef LIBDVBCSA
 	_decrypt = std::make_shared<decrypt::dvbapi::Client>(*this);
 #endif
 }
 
-StreamManager::~StreamManager() {}
+StreamManager::~StreamManager() {
+	_signalMonitor.terminateThread();
+}
 
 // =============================================================================
 // -- Other member functions ---------------------------------------------------
@@ -60,7 +76,10 @@ void StreamManager::enumerateDevices(
 		const std::string &bindIPAddress,
 		const std::string &appDataPath,
 		const std::string &dvbPath,
-		const bool enableChildPIPE) {
+		const bool enableChildPIPE,
+		const bool enableIngestReactor,
+		const bool enableHugePages,
+		const bool enableIoUring) {
 	base::MutexLock lock(_mutex);
 
 #ifdef NOT_PREFERRED_DVB_API
@@ -76,6 +95,64 @@ void StreamManager::enumerateDevices(
 	if (enableChildPIPE) {
 		input::childpipe::TSReader::enumerate(_stream, appDataPath);
 	}
+	// One packet pool for the buffers of all streams, and the buffers the
+	// kernel may still send from with zero copy or io_uring
+	const std::size_t heldBuffers =
+		(output::TcpSink::MAX_ZERO_COPY_BUF > output::EgressRing::MAX_HELD_BUF) ?
+		output::TcpSink::MAX_ZERO_COPY_BUF : output::EgressRing::MAX_HELD_BUF;
+	_packetPool.reset(new mpegts::PacketPool(
+		_stream.size() * (output::StreamThreadBase::MAX_BUF + heldBuffers),
+		enableHugePages));
+	for (SpStream stream : _stream) {
+		stream->setPacketPool(_packetPool.get());
+	}
+	if (enableIngestReactor) {
+		_ingestReactor.reset(new input::IngestReactor);
+		if (_ingestReactor->startThread()) {
+			SI_LOG_INFO("Using IngestReactor for all input devices");
+			for (SpStream stream : _stream) {
+				stream->setIngestReactor(_ingestReactor.get());
+			}
+		} else {
+			SI_LOG_ERROR("Start IngestReactor failed, using polling instead");
+			_ingestReactor.reset();
+		}
+	}
+	if (enableIoUring) {
+		_egressRing.reset(new output::EgressRing(*_packetPool));
+		if (_egressRing->isAvailable() && _egressRing->startThread()) {
+			SI_LOG_INFO("Using EgressRing for the output of all streams");
+			for (SpStream stream : _stream) {
+				stream->setEgressRing(_egressRing.get());
+			}
+		} else {
+			SI_LOG_ERROR("Start EgressRing failed, using system calls of the stream threads instead");
+			_egressRing.reset();
+		}
+	}
+	// One thread sends the RTCP reports of all streams
+	_rtcpService.reset(new output::RtcpService);
+	if (_rtcpService->startThread()) {
+		for (SpStream stream : _stream) {
+			stream->setRtcpService(_rtcpService.get());
+		}
+	} else {
+		SI_LOG_ERROR("Start RtcpService failed");
+		_rtcpService.reset();
+	}
+	if (!_signalMonitor.startThread()) {
+		SI_LOG_ERROR("Start SignalMonitor failed");
+	}
+}
+
+bool StreamManager::signalMonitorExecute() {
+	// The stream vector does not change after enumeration, so no need to
+	// lock here and block the RTSP/HTTP servers while doing the ioctls
+	for (SpStream stream : _stream) {
+		stream->monitorSignal();
+	}
+	std::this_thread::sleep_for(std::chrono::milliseconds(200));
+	return true;
 }
 
 std::string StreamManager::getXMLDeliveryString() const {
@@ -128,6 +205,16 @@ std::string StreamManager::getRTSPDescribeString() const {
 }
 
 
+void StreamManager::processRtcpData(SocketClient &socketClient) {
+	base::MutexLock lock(_mutex);
+	const std::string data = socketClient.getMessage();
+	for (SpStream stream : _stream) {
+		if (stream->processRtcpData(socketClient.getFD(), data)) {
+			return;
+		}
+	}
+}
+
 SpStream StreamManager::findStreamAndClientIDFor(SocketClient &socketClient, int &clientID) {
 	base::MutexLock lock(_mutex);
 
@@ -164,7 +251,7 @@ SpStream StreamManager::findStreamAndClientIDFor(SocketClient &socketClient, int
 
 	// if no streamID, then we need to find the streamID
 	if (streamID == -1) {
-		if (!sessionID.empty()) {
+		if (!newSession) {
 			SI_LOG_INFO("Found StreamID x - SessionID: %s", sessionID.c_str());
 			for (SpStream stream : _stream) {
 				if (stream->findClientIDFor(socketClient, newSession, sessionID, method, clientID)) {
@@ -174,12 +261,31 @@ SpStream StreamManager::findStreamAndClientIDFor(SocketClient &socketClient, int
 			}
 		} else {
 			SI_LOG_INFO("Found StreamID x - SessionID x - Creating new SessionID: %s", sessionID.c_str());
+			// A stream already tuned to the requested transponder can be shared,
+			// so it does not need an other frontend
+			for (SpStream stream : _stream) {
+				if (stream->shareClientIDFor(socketClient, method, clientID)) {
+					stream->getStreamClient(clientID).setSessionID(sessionID);
+					return stream;
+				}
+			}
+			// Try the free streams that can deliver the request fastest first
+			std::vector<std::pair<int, SpStream>> candidates;
 			for (SpStream stream : _stream) {
 				if (!stream->streamInUse()) {
-					if (stream->findClientIDFor(socketClient, newSession, sessionID, method, clientID)) {
-						stream->getStreamClient(clientID).setSessionID(sessionID);
-						return stream;
-					}
+					candidates.emplace_back(stream->allocationScore(msg, method), stream);
+				}
+			}
+			std::stable_sort(candidates.begin(), candidates.end(),
+				[](const std::pair<int, SpStream> &a, const std::pair<int, SpStream> &b) {
+					return a.first > b.first;
+				});
+			for (const std::pair<int, SpStream> &candidate : candidates) {
+				SpStream stream = candidate.second;
+				if (stream->findClientIDFor(socketClient, newSession, sessionID, method, clientID)) {
+					SI_LOG_INFO("Stream: %d, Allocated with score %d", stream->getStreamID(), candidate.first);
+					stream->getStreamClient(clientID).setSessionID(sessionID);
+					return stream;
 				}
 			}
 		}
@@ -258,6 +364,30 @@ void StreamManager::doAddToXML(std::string &xml) const {
 		ADD_XML_N_ELEMENT(xml, "stream", i, stream->toXML());
 		++i;
 	}
+	if (_packetPool) {
+		ADD_XML_BEGIN_ELEMENT(xml, "packetPool");
+		ADD_XML_ELEMENT(xml, "poolSize", _packetPool->getSize());
+		ADD_XML_ELEMENT(xml, "poolInUse", _packetPool->getInUse());
+		ADD_XML_ELEMENT(xml, "poolMaxInUse", _packetPool->getMaxInUse());
+		ADD_XML_ELEMENT(xml, "poolAllocFailures", _packetPool->getAllocFailures());
+		ADD_XML_ELEMENT(xml, "poolHugePages", _packetPool->isHugePageBacked() ? "yes" : "no");
+		ADD_XML_END_ELEMENT(xml, "packetPool");
+	}
+	if (_egressRing) {
+		ADD_XML_BEGIN_ELEMENT(xml, "egressRing");
+		ADD_XML_ELEMENT(xml, "ringSubmits", _egressRing->getSubmits());
+		ADD_XML_ELEMENT(xml, "ringRequests", _egressRing->getRequests());
+		ADD_XML_ELEMENT(xml, "ringRejected", _egressRing->getRejected());
+		ADD_XML_ELEMENT(xml, "ringFixedBuffers", _egressRing->hasFixedBuffers() ? "yes" : "no");
+		ADD_XML_ELEMENT(xml, "ringFixedFiles", _egressRing->hasFixedFiles() ? "yes" : "no");
+		ADD_XML_END_ELEMENT(xml, "egressRing");
+	}
+	if (_rtcpService) {
+		ADD_XML_BEGIN_ELEMENT(xml, "rtcpService");
+		ADD_XML_ELEMENT(xml, "rtcpSessions", _rtcpService->getSessions());
+		ADD_XML_ELEMENT(xml, "rtcpReports", _rtcpService->getReports());
+		ADD_XML_END_ELEMENT(xml, "rtcpService");
+	}
 #ifdef LIBDVBCSA
 	ADD_XML_ELEMENT(xml, "decrypt", _decrypt->toXML());
 #endif
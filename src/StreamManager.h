@@ -21,12 +21,18 @@
 #define STREAM_MANAGER_H_INCLUDE STREAM_MANAGER_H_INCLUDE
 
 #include <FwDecl.h>
+#include <base/Thread.h>
 #include <base/XMLSupport.h>
 
 #include <string>
 
 FW_DECL_NS0(SocketClient);
 
+FW_DECL_UP_NS1(input, IngestReactor);
+FW_DECL_UP_NS1(mpegts, PacketPool);
+FW_DECL_UP_NS1(output, EgressRing);
+FW_DECL_UP_NS1(output, RtcpService);
+
 FW_DECL_VECTOR_OF_SP_NS0(Stream);
 
 FW_DECL_SP_NS2(decrypt, dvbapi, Client);
@@ -65,17 +71,29 @@ class StreamManager :
 		/// @param appDataPath specifies the path were to store application data
 		/// @param dvbPath specifies the path were to find dvb devices eg. /dev/dvb
 		/// @param enableChildPIPE to enable frontend 'Child PIPE - TS Reader'
+		/// @param enableIngestReactor to watch all input devices with one
+		/// @c IngestReactor instead of polling them from every stream thread
+		/// @param enableHugePages to back the packet pool with huge pages
+		/// @param enableIoUring to send the output of all streams with one
+		/// @c EgressRing instead of from every stream thread
 		void enumerateDevices(
 			const std::string &bindIPAddress,
 			const std::string &appDataPath,
 			const std::string &dvbPath,
-			bool enableChildPIPE);
+			bool enableChildPIPE,
+			bool enableIngestReactor,
+			bool enableHugePages,
+			bool enableIoUring);
 
 		///
 		SpStream findStreamAndClientIDFor(
 			SocketClient &socketClient,
 			int &clientID);
 
+		/// Process an interleaved RTCP packet a RTP/TCP client send on its
+		/// RTSP connection
+		void processRtcpData(SocketClient &socketClient);
+
 		///
 		void checkForSessionTimeout();
 
@@ -100,6 +118,12 @@ class StreamManager :
 			int streamID);
 #endif
 
+	private:
+
+		/// Thread execute function of the signal monitor @see base::Thread
+		/// This will sample the monitor signals of all input devices
+		bool signalMonitorExecute();
+
 		// =====================================================================
 		// -- Data members -----------------------------------------------------
 		// =====================================================================
@@ -107,7 +131,12 @@ class StreamManager :
 
 		base::Mutex _mutex;
 		decrypt::dvbapi::SpClient _decrypt;
+		input::UpIngestReactor _ingestReactor;
+		mpegts::UpPacketPool _packetPool; /// should be destroyed after the streams
+		output::UpEgressRing _egressRing; /// should be destroyed after the streams
+		output::UpRtcpService _rtcpService; /// should be destroyed after the streams
 		StreamSpVector _stream;
+		base::Thread _signalMonitor;
 };
 
 #endif // STREAM_MANAGER_H_INCLUDE
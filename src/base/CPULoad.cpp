@@ -0,0 +1,77 @@
+/* CPULoad.cpp
+
+   Copyright (C) 2014 - 2020 Marc Postema (mpostema09 -at- gmail.com)
+
+   This program is free software; you can redistribute it and/or
+   modify it under the terms of the GNU General Public License
+   as published by the Free Software Foundation; either version 2
+   of the License, or (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program; if not, write to the Free Software
+   Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+   Or, point your browser to http://www.gnu.org/copyleft/gpl.html
+*/
+#include <base/CPULoad.h>
+
+#include <time.h>
+
+namespace base {
+
+	static constexpr std::int64_t NSEC = 1000000000;
+
+	// =========================================================================
+	//  -- Constructors and destructor -----------------------------------------
+	// =========================================================================
+
+	CPULoad::CPULoad() :
+		_tWall(0),
+		_tCPU(0),
+		_load(0.0) {}
+
+	CPULoad::~CPULoad() {}
+
+	// =========================================================================
+	// -- Static member functions ----------------------------------------------
+	// =========================================================================
+
+	std::int64_t CPULoad::getTime(const int clock) {
+		struct timespec ts;
+		clock_gettime(clock, &ts);
+		return (ts.tv_sec * NSEC) + ts.tv_nsec;
+	}
+
+	// =========================================================================
+	// -- Other member functions -----------------------------------------------
+	// =========================================================================
+
+	void CPULoad::reset() {
+		_tWall = getTime(CLOCK_MONOTONIC);
+		_tCPU = getTime(CLOCK_THREAD_CPUTIME_ID);
+		_load = 0.0;
+	}
+
+	void CPULoad::update() {
+		const std::int64_t tWall = getTime(CLOCK_MONOTONIC);
+		if (_tWall == 0) {
+			reset();
+			return;
+		}
+		const std::int64_t elapsed = tWall - _tWall;
+		// Only read the (more expensive) thread CPU clock every second
+		if (elapsed < NSEC) {
+			return;
+		}
+		const std::int64_t tCPU = getTime(CLOCK_THREAD_CPUTIME_ID);
+		// The CPU time goes back when an other (new) thread is measured
+		_load = (tCPU >= _tCPU) ? ((tCPU - _tCPU) * 100.0) / elapsed : 0.0;
+		_tWall = tWall;
+		_tCPU = tCPU;
+	}
+
+} // namespace base
@@ -0,0 +1,72 @@
+/* CPULoad.h
+
+   Copyright (C) 2014 - 2020 Marc Postema (mpostema09 -at- gmail.com)
+
+   This program is free software; you can redistribute it and/or
+   modify it under the terms of the GNU General Public License
+   as published by the Free Software Foundation; either version 2
+   of the License, or (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program; if not, write to the Free Software
+   Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+   Or, point your browser to http://www.gnu.org/copyleft/gpl.html
+*/
+#ifndef BASE_CPULOAD_H_INCLUDE
+#define BASE_CPULOAD_H_INCLUDE BASE_CPULOAD_H_INCLUDE
+
+#include <atomic>
+#include <cstdint>
+
+namespace base {
+
+/// The class @c CPULoad measures how busy the calling thread is, as the CPU
+/// time used by this thread against the elapsed time
+class CPULoad {
+		// =====================================================================
+		//  -- Constructors and destructor -------------------------------------
+		// =====================================================================
+	public:
+
+		CPULoad();
+
+		virtual ~CPULoad();
+
+		// =====================================================================
+		// -- Other member functions -------------------------------------------
+		// =====================================================================
+	public:
+
+		/// Restart the measurement, call from the measured thread
+		void reset();
+
+		/// Update the measurement, call regularly from the measured thread
+		void update();
+
+		/// Get the busy time of the measured thread in percent
+		double getLoad() const {
+			return _load;
+		}
+
+	private:
+
+		static std::int64_t getTime(int clock);
+
+		// =====================================================================
+		// -- Data members -----------------------------------------------------
+		// =====================================================================
+	private:
+
+		std::int64_t _tWall;
+		std::int64_t _tCPU;
+		std::atomic<double> _load;
+};
+
+} // namespace base
+
+#endif // BASE_CPULOAD_H_INCLUDE
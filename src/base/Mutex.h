@@ -59,6 +59,11 @@ class Mutex {
 			pthread_mutex_lock(&_mutex);
 		}
 
+		/// Exclusively try to lock the @c Mutex per thread, without waiting.
+		bool tryLock() const {
+			return pthread_mutex_trylock(&_mutex) == 0;
+		}
+
 		/// Exclusively try to lock the @c Mutex per thread for a maximum time of
 		/// timeout msec.
 		/// @param timeout specifies the time, in msec, to try locking this mutex.
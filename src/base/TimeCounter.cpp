@@ -19,6 +19,8 @@
 */
 #include <base/TimeCounter.h>
 
+#include <ctime>
+
 #include <sys/time.h>
 
 namespace base {
@@ -29,4 +31,39 @@ long TimeCounter::getTicks() {
   return ((tv.tv_sec * 1000) + (tv.tv_usec / 1000));
 }
 
+uint64_t TimeCounter::getMonotonicMicros() {
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (static_cast<uint64_t>(ts.tv_sec) * 1000000) + (ts.tv_nsec / 1000);
+}
+
+uint32_t TimeCounter::getRtpTimestamp(const uint64_t micros) {
+	// The timestamp wraps around, so only the lower 32 bits are used
+	return static_cast<uint32_t>((micros * 9) / 100);
+}
+
+uint64_t TimeCounter::getNtpTimestamp(const uint64_t micros) {
+	// Seconds between the NTP epoch (1900) and the Unix epoch (1970)
+	static constexpr uint64_t NTP_UNIX_OFFSET = 2208988800ull;
+	struct Mapping {
+		Mapping() {
+			struct timespec wall;
+			clock_gettime(CLOCK_REALTIME, &wall);
+			monotonic = getMonotonicMicros();
+			ntp = ((static_cast<uint64_t>(wall.tv_sec) + NTP_UNIX_OFFSET) << 32) +
+				((static_cast<uint64_t>(wall.tv_nsec) << 32) / 1000000000);
+		}
+		uint64_t monotonic;
+		uint64_t ntp;
+	};
+	static const Mapping mapping;
+
+	// micros may be a bit before the mapping was made
+	const int64_t diff = static_cast<int64_t>(micros - mapping.monotonic);
+	const int64_t sec = diff / 1000000;
+	const int64_t usec = diff % 1000000;
+	return mapping.ntp + static_cast<uint64_t>(sec * 4294967296ll) +
+		static_cast<uint64_t>((usec * 4294967296ll) / 1000000);
+}
+
 } // namespace base
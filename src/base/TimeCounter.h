@@ -20,6 +20,8 @@
 #ifndef BASE_TIMECOUNTER_H_INCLUDE
 #define BASE_TIMECOUNTER_H_INCLUDE BASE_TIMECOUNTER_H_INCLUDE
 
+#include <cstdint>
+
 namespace base {
 
 	///
@@ -27,6 +29,24 @@ namespace base {
 		public:
 			/// returns the ticks
 			static long getTicks();
+
+			/// Get the time of the monotonic clock in usec, it does not jump
+			/// when the wall clock is set
+			static uint64_t getMonotonicMicros();
+
+			/// Get the 90 kHz RTP timestamp of the monotonic time micros
+			static uint32_t getRtpTimestamp(uint64_t micros);
+
+			/// Get the 90 kHz RTP timestamp of now, call it once for a batch
+			/// of packets
+			static uint32_t getRtpTimestamp() {
+				return getRtpTimestamp(getMonotonicMicros());
+			}
+
+			/// Get the 64 bit NTP timestamp (seconds and fraction) of the
+			/// monotonic time micros. The wall clock is mapped on the monotonic
+			/// clock once, so it stays consistent with the RTP timestamps.
+			static uint64_t getNtpTimestamp(uint64_t micros);
 	};
 
 } // namespace base
@@ -0,0 +1,102 @@
+/* WaitEvent.cpp
+
+   Copyright (C) 2014 - 2020 Marc Postema (mpostema09 -at- gmail.com)
+
+   This program is free software; you can redistribute it and/or
+   modify it under the terms of the GNU General Public License
+   as published by the Free Software Foundation; either version 2
+   of the License, or (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program; if not, write to the Free Software
+   Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+   Or, point your browser to http://www.gnu.org/copyleft/gpl.html
+*/
+#include <base/WaitEvent.h>
+
+#include <Log.h>
+
+#include <chrono>
+#include <cstdint>
+#include <thread>
+
+#include <poll.h>
+#include <unistd.h>
+#include <sys/eventfd.h>
+
+namespace base {
+
+	// =========================================================================
+	//  -- Constructors and destructor -----------------------------------------
+	// =========================================================================
+
+	WaitEvent::WaitEvent() :
+		_fd(::eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC)),
+		_parked(false),
+		_spin(MIN_SPIN) {
+		if (_fd == -1) {
+			PERROR("eventfd");
+		}
+	}
+
+	WaitEvent::~WaitEvent() {
+		if (_fd != -1) {
+			::close(_fd);
+		}
+	}
+
+	// =========================================================================
+	// -- Other member functions -----------------------------------------------
+	// =========================================================================
+
+	void WaitEvent::signal() {
+		if (_parked.exchange(false)) {
+			const std::uint64_t value = 1;
+			if (::write(_fd, &value, sizeof(value)) == -1) {
+				PERROR("WaitEvent::signal");
+			}
+		}
+	}
+
+	bool WaitEvent::wait(const FunctionReady &ready, const int timeoutMS) {
+		// Spin first, it is cheaper than parking when the condition becomes
+		// true soon
+		for (unsigned int i = 0; i < _spin; ++i) {
+			if (ready()) {
+				_spin = (_spin < MAX_SPIN) ? _spin * 2 : MAX_SPIN;
+				return true;
+			}
+			std::this_thread::yield();
+		}
+		_spin = (_spin > MIN_SPIN) ? _spin / 2 : MIN_SPIN;
+
+		// Check again after marking parked, so a signal is never lost
+		_parked = true;
+		if (ready()) {
+			_parked = false;
+			return true;
+		}
+		if (_fd == -1) {
+			std::this_thread::sleep_for(std::chrono::milliseconds(1));
+		} else {
+			pollfd pfd;
+			pfd.fd = _fd;
+			pfd.events = POLLIN;
+			pfd.revents = 0;
+			if (::poll(&pfd, 1, timeoutMS) > 0) {
+				std::uint64_t value;
+				if (::read(_fd, &value, sizeof(value)) == -1) {
+					PERROR("WaitEvent::wait");
+				}
+			}
+		}
+		_parked = false;
+		return ready();
+	}
+
+} // namespace base
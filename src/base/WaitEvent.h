@@ -0,0 +1,75 @@
+/* WaitEvent.h
+
+   Copyright (C) 2014 - 2020 Marc Postema (mpostema09 -at- gmail.com)
+
+   This program is free software; you can redistribute it and/or
+   modify it under the terms of the GNU General Public License
+   as published by the Free Software Foundation; either version 2
+   of the License, or (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program; if not, write to the Free Software
+   Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+   Or, point your browser to http://www.gnu.org/copyleft/gpl.html
+*/
+#ifndef BASE_WAITEVENT_H_INCLUDE
+#define BASE_WAITEVENT_H_INCLUDE BASE_WAITEVENT_H_INCLUDE
+
+#include <atomic>
+#include <functional>
+
+namespace base {
+
+/// The class @c WaitEvent lets a thread wait on a condition that an other
+/// thread makes true. The waiting thread spins a while first and then parks
+/// on an eventfd, the spin time adapts to how often spinning succeeds.
+class WaitEvent {
+	public:
+
+		using FunctionReady = std::function<bool()>;
+
+		// =====================================================================
+		//  -- Constructors and destructor -------------------------------------
+		// =====================================================================
+	public:
+
+		WaitEvent();
+
+		virtual ~WaitEvent();
+
+		// =====================================================================
+		// -- Other member functions -------------------------------------------
+		// =====================================================================
+	public:
+
+		/// Wake up the waiting thread, if it is parked. Call this after the
+		/// condition is made true.
+		void signal();
+
+		/// Wait until the condition is true or the timeout expired
+		/// @param ready specifies the function that checks the condition
+		/// @param timeoutMS specifies the max time to park in msec
+		/// @return true if the condition is true
+		bool wait(const FunctionReady &ready, int timeoutMS);
+
+		// =====================================================================
+		// -- Data members -----------------------------------------------------
+		// =====================================================================
+	private:
+
+		static constexpr unsigned int MIN_SPIN = 16;
+		static constexpr unsigned int MAX_SPIN = 1024;
+
+		int _fd;
+		std::atomic<bool> _parked;
+		unsigned int _spin;
+};
+
+} // namespace base
+
+#endif // BASE_WAITEVENT_H_INCLUDE
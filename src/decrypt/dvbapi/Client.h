@@ -79,6 +79,12 @@ class Client :
 		///
 		bool stopDecrypt(int streamID);
 
+		/// Check if this client may decrypt the streams, so it is enabled and
+		/// connected to the server
+		bool canDecrypt() const {
+			return _connected && _enabled;
+		}
+
 	private:
 
 		///
@@ -21,12 +21,18 @@
 #define INPUT_DEVICE_H_INCLUDE INPUT_DEVICE_H_INCLUDE
 
 #include <FwDecl.h>
+#include <Unused.h>
 #include <base/XMLSupport.h>
 #include <input/InputSystem.h>
 #include <base/Mutex.h>
 
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
 #include <string>
 
+#include <sys/types.h>
+
 FW_DECL_NS1(mpegts, PacketBuffer);
 
 FW_DECL_SP_NS1(input, Device);
@@ -67,6 +73,53 @@ class Device :
 		/// @param buffer
 		virtual bool readFullTSPacket(mpegts::PacketBuffer &buffer) = 0;
 
+		/// Read the available data from this device into several buffers at
+		/// once. The first buffer may already be partially filled, the last
+		/// one may be left partially filled.
+		/// @param buffers specifies the buffers to fill, in order
+		/// @param n specifies the amount of buffers available
+		/// @return the amount of buffers that are completely filled
+		virtual std::size_t readTSPackets(mpegts::PacketBuffer *const *buffers, std::size_t n) {
+			return (n > 0 && readFullTSPacket(*buffers[0])) ? 1 : 0;
+		}
+
+		/// Check if data of this device is lost when it is not read in time,
+		/// like from a tuner. Else the reader may wait until there is room.
+		virtual bool isLiveSource() const {
+			return true;
+		}
+
+		/// Get the file descriptor that becomes readable when data is available
+		/// from this device, so it can be watched by an @c IngestReactor
+		/// @return the file descriptor or -1 if this device can not be watched
+		virtual int getDataFD() const {
+			return -1;
+		}
+
+		/// Get the amount of times the data file descriptor was opened, so
+		/// a watcher registers it again also when it got the same number
+		virtual unsigned long getDataFDGeneration() const {
+			return 0;
+		}
+
+		/// Check if the data of this device can be moved to an output with
+		/// @see spliceTSPackets, so it does not need to pass user space
+		/// (like the filter) anymore
+		virtual bool isSpliceable() const {
+			return false;
+		}
+
+		/// Move the available data of this device to a pipe, without copying
+		/// it to user space
+		/// @param fd specifies the write end of the pipe
+		/// @param size specifies the max bytes to move, whole TS packets
+		/// @return the amount of bytes moved, 0 if none is available or -1
+		/// and errno tells why. EINVAL means this device can not splice.
+		virtual ssize_t spliceTSPackets(int UNUSED(fd), std::size_t UNUSED(size)) {
+			errno = EINVAL;
+			return -1;
+		}
+
 		/// Check the capability of this device
 		/// @param system
 		virtual bool capableOf(input::InputSystem system) const = 0;
@@ -77,6 +130,30 @@ class Device :
 		/// @param method
 		virtual bool capableToTransform(const std::string &msg, const std::string &method) const = 0;
 
+		/// Get a score on how fast this (free) device can deliver the first
+		/// packet of the request, used for choosing a device (higher is faster)
+		/// @param msg
+		/// @param method
+		virtual int allocationScore(const std::string &UNUSED(msg),
+				const std::string &UNUSED(method)) const {
+			return 0;
+		}
+
+		/// Check if this device is tuned to the transponder of the request,
+		/// so the request can share this device
+		/// @param msg
+		/// @param method
+		virtual bool isTunedTo(const std::string &UNUSED(msg),
+				const std::string &UNUSED(method)) const {
+			return false;
+		}
+
+		/// Open or close a PID for a client that shares this device. This is
+		/// applied with the next @c update
+		/// @param pid specifies the PID to open or close
+		/// @param use specifies if the PID should be opened or closed
+		virtual void setSharedPID(int UNUSED(pid), bool UNUSED(use)) {}
+
 		/// Monitor signal of this device
 		virtual void monitorSignal(bool showStatus) = 0;
 
@@ -99,6 +176,10 @@ class Device :
 		///
 		virtual std::string attributeDescribeString() const = 0;
 
+		/// Get the version of @see attributeDescribeString, it changes when
+		/// the description may have changed
+		virtual uint64_t getDescribeVersion() const = 0;
+
 		// =======================================================================
 		// -- Data members -------------------------------------------------------
 		// =======================================================================
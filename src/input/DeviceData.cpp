@@ -24,6 +24,9 @@
 
 namespace input {
 
+	/// The versions of all device data, so different objects never share one
+	static std::atomic<uint32_t> nextVersion(0);
+
 	// =======================================================================
 	// -- Constructors and destructor ----------------------------------------
 	// =======================================================================
@@ -31,12 +34,13 @@ namespace input {
 	DeviceData::DeviceData() {
 		_delsys = input::InputSystem::UNDEFINED;
 		_changed = false;
-		_status = static_cast<fe_status_t>(0);
+		_version = ++nextVersion;
+		_monitorSeq = 0;
+		_status = 0;
 		_strength = 0;
 		_snr = 0;
 		_ber = 0;
 		_ublocks = 0;
-		_ublocks = 0;
 	}
 
 	DeviceData::~DeviceData() {}
@@ -52,11 +56,12 @@ namespace input {
 		ADD_XML_ELEMENT(xml, "networkname", sdtData.networkNameUTF8);
 
 		// Monitor
-		ADD_XML_ELEMENT(xml, "status", _status);
-		ADD_XML_ELEMENT(xml, "signal", _strength);
-		ADD_XML_ELEMENT(xml, "snr", _snr);
-		ADD_XML_ELEMENT(xml, "ber", _ber);
-		ADD_XML_ELEMENT(xml, "unc", _ublocks);
+		const MonitorData monitor = getMonitorData();
+		ADD_XML_ELEMENT(xml, "status", monitor.status);
+		ADD_XML_ELEMENT(xml, "signal", monitor.strength);
+		ADD_XML_ELEMENT(xml, "snr", monitor.snr);
+		ADD_XML_ELEMENT(xml, "ber", monitor.ber);
+		ADD_XML_ELEMENT(xml, "unc", monitor.ublocks);
 
 		ADD_XML_ELEMENT(xml, "pidcsv", _filter.getPidCSV());
 
@@ -65,6 +70,7 @@ namespace input {
 
 	void DeviceData::doFromXML(const std::string &xml) {
 		doNextFromXML(xml);
+		updateVersion();
 	}
 
 	// =======================================================================
@@ -78,12 +84,14 @@ namespace input {
 		_filter.clear();
 		setMonitorData(static_cast<fe_status_t>(0), 0, 0, 0, 0);
 		doInitialize();
+		updateVersion();
 	}
 
 	void DeviceData::parseStreamString(int streamID, const std::string &msg,
 		const std::string &method) {
 		base::MutexLock lock(_mutex);
 		doParseStreamString(streamID, msg, method);
+		updateVersion();
 	}
 
 	std::string DeviceData::attributeDescribeString(int streamID) const {
@@ -91,9 +99,20 @@ namespace input {
 		return doAttributeDescribeString(streamID);
 	}
 
+	uint64_t DeviceData::getDescribeVersion() const {
+		return (static_cast<uint64_t>(_version.load()) << 32) | _filter.getPidVersion();
+	}
+
+	void DeviceData::updateVersion() {
+		_version = ++nextVersion;
+	}
+
 	void DeviceData::setDeliverySystem(const input::InputSystem system) {
 		base::MutexLock lock(_mutex);
-		_delsys = system;
+		if (_delsys != system) {
+			_delsys = system;
+			updateVersion();
+		}
 	}
 
 	input::InputSystem DeviceData::getDeliverySystem() const {
@@ -151,42 +170,66 @@ namespace input {
 			const uint16_t snr,
 			const uint32_t ber,
 			const uint32_t ublocks) {
-		base::MutexLock lock(_mutex);
-		_status = status;
-		_strength = strength;
-		_snr = snr;
-		_ber = ber;
-		_ublocks = ublocks;
+		const bool changed =
+			_status.load(std::memory_order_relaxed) != status ||
+			_strength.load(std::memory_order_relaxed) != strength ||
+			_snr.load(std::memory_order_relaxed) != snr ||
+			_ber.load(std::memory_order_relaxed) != ber ||
+			_ublocks.load(std::memory_order_relaxed) != ublocks;
+		// Make the sequence odd to claim the writer side, readers will retry
+		uint32_t seq = _monitorSeq.load(std::memory_order_relaxed);
+		do {
+			seq &= ~1u;
+		} while (!_monitorSeq.compare_exchange_weak(seq, seq + 1, std::memory_order_acquire));
+		std::atomic_thread_fence(std::memory_order_release);
+		_status.store(status, std::memory_order_relaxed);
+		_strength.store(strength, std::memory_order_relaxed);
+		_snr.store(snr, std::memory_order_relaxed);
+		_ber.store(ber, std::memory_order_relaxed);
+		_ublocks.store(ublocks, std::memory_order_relaxed);
+		_monitorSeq.store(seq + 2, std::memory_order_release);
+		if (changed) {
+			updateVersion();
+		}
+	}
+
+	DeviceData::MonitorData DeviceData::getMonitorData() const {
+		MonitorData data;
+		uint32_t seq;
+		do {
+			seq = _monitorSeq.load(std::memory_order_acquire);
+			data.status   = static_cast<fe_status_t>(_status.load(std::memory_order_relaxed));
+			data.strength = _strength.load(std::memory_order_relaxed);
+			data.snr      = _snr.load(std::memory_order_relaxed);
+			data.ber      = _ber.load(std::memory_order_relaxed);
+			data.ublocks  = _ublocks.load(std::memory_order_relaxed);
+			std::atomic_thread_fence(std::memory_order_acquire);
+		} while ((seq & 1) || seq != _monitorSeq.load(std::memory_order_relaxed));
+		return data;
 	}
 
 	int DeviceData::hasLock() const {
-		base::MutexLock lock(_mutex);
-		return (_status & FE_HAS_LOCK) ? 1 : 0;
+		return (getMonitorData().status & FE_HAS_LOCK) ? 1 : 0;
 	}
 
 	fe_status_t DeviceData::getSignalStatus() const {
-		base::MutexLock lock(_mutex);
-		return _status;
+		return getMonitorData().status;
 	}
 
 	uint16_t DeviceData::getSignalStrength() const {
-		base::MutexLock lock(_mutex);
-		return _strength;
+		return getMonitorData().strength;
 	}
 
 	uint16_t DeviceData::getSignalToNoiseRatio() const {
-		base::MutexLock lock(_mutex);
-		return _snr;
+		return getMonitorData().snr;
 	}
 
 	uint32_t DeviceData::getBitErrorRate() const {
-		base::MutexLock lock(_mutex);
-		return _ber;
+		return getMonitorData().ber;
 	}
 
 	uint32_t DeviceData::getUncorrectedBlocks() const {
-		base::MutexLock lock(_mutex);
-		return _ublocks;
+		return getMonitorData().ublocks;
 	}
 
 } // namespace input
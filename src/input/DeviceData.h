@@ -27,6 +27,8 @@
 #include <input/dvb/dvbfix.h>
 #include <mpegts/Filter.h>
 
+#include <atomic>
+
 FW_DECL_NS1(mpegts, PacketBuffer);
 
 namespace input {
@@ -67,8 +69,16 @@ class DeviceData :
 		///
 		std::string attributeDescribeString(int streamID) const;
 
+		/// Get the version of the data @see attributeDescribeString is made
+		/// of, it changes when the tuning, the opened PIDs or the signal
+		/// monitor data changed. The versions of different objects differ.
+		uint64_t getDescribeVersion() const;
+
 	private:
 
+		/// Give this data a new version, @see getDescribeVersion
+		void updateVersion();
+
 		/// Specialization for @see doAddToXML
 		virtual void doNextAddToXML(std::string &UNUSED(xml)) const {}
 
@@ -86,7 +96,17 @@ class DeviceData :
 
 	public:
 
-		///
+		/// Snapshot of the signal monitor data
+		struct MonitorData {
+			fe_status_t status;
+			uint16_t strength;
+			uint16_t snr;
+			uint32_t ber;
+			uint32_t ublocks;
+		};
+
+		/// Set the signal monitor data. This is published as a snapshot
+		/// that can be read without locking, @see getMonitorData
 		void setMonitorData(fe_status_t status,
 				uint16_t strength,
 				uint16_t snr,
@@ -130,6 +150,10 @@ class DeviceData :
 
 		uint32_t getUncorrectedBlocks() const;
 
+		/// Get a consistent snapshot of the signal monitor data, without
+		/// locking (seqlock), so it can be called from any thread
+		MonitorData getMonitorData() const;
+
 		// =======================================================================
 		// -- Data members -------------------------------------------------------
 		// =======================================================================
@@ -140,15 +164,17 @@ class DeviceData :
 		bool _changed;
 		input::InputSystem _delsys;
 		mpegts::Filter _filter;
+		std::atomic<uint32_t> _version;
 
 		// =======================================================================
 		// -- Monitor Data members -----------------------------------------------
 		// =======================================================================
-		fe_status_t _status;
-		uint16_t _strength;
-		uint16_t _snr;
-		uint32_t _ber;
-		uint32_t _ublocks;
+		std::atomic<uint32_t> _monitorSeq; /// odd while the monitor data is written
+		std::atomic<int> _status;
+		std::atomic<uint16_t> _strength;
+		std::atomic<uint16_t> _snr;
+		std::atomic<uint32_t> _ber;
+		std::atomic<uint32_t> _ublocks;
 };
 
 } // namespace input
@@ -0,0 +1,151 @@
+/* IngestReactor.cpp
+
+   Copyright (C) 2014 - 2020 Marc Postema (mpostema09 -at- gmail.com)
+
+   This program is free software; you can redistribute it and/or
+   modify it under the terms of the GNU General Public License
+   as published by the Free Software Foundation; either version 2
+   of the License, or (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program; if not, write to the Free Software
+   Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+   Or, point your browser to http://www.gnu.org/copyleft/gpl.html
+ */
+#include <input/IngestReactor.h>
+
+#include <Log.h>
+#include <Utils.h>
+
+#include <sys/epoll.h>
+
+namespace input {
+
+	constexpr IngestReactor::Token IngestReactor::NO_TOKEN;
+
+	// =========================================================================
+	//  -- Constructors and destructor -----------------------------------------
+	// =========================================================================
+
+	IngestReactor::IngestReactor() :
+		ThreadBase("IngestReactor"),
+		_nextToken(NO_TOKEN + 1) {
+		_epfd = ::epoll_create1(EPOLL_CLOEXEC);
+		if (_epfd == -1) {
+			PERROR("epoll_create1");
+		}
+	}
+
+	IngestReactor::~IngestReactor() {
+		terminateThread();
+		CLOSE_FD(_epfd);
+	}
+
+	// =========================================================================
+	//  -- base::ThreadBase ----------------------------------------------------
+	// =========================================================================
+
+	void IngestReactor::threadEntry() {
+		epoll_event events[MAX_EVENTS];
+		while (running()) {
+			const int n = ::epoll_wait(_epfd, events, MAX_EVENTS, 100);
+			if (n < 0) {
+				if (errno != EINTR) {
+					PERROR("epoll_wait");
+				}
+				continue;
+			}
+			for (int i = 0; i < n; ++i) {
+				const Token token = events[i].data.u64;
+				// Keep the lock while dispatching, so 'remove' can not
+				// return while the readable function is still running
+				base::MutexLock lock(_mutex);
+				const auto it = _watch.find(token);
+				if (it == _watch.end() || it->second.fd == -1) {
+					continue;
+				}
+				if (it->second.readable()) {
+					resume(token);
+				}
+			}
+		}
+	}
+
+	// =========================================================================
+	//  -- Other member functions ----------------------------------------------
+	// =========================================================================
+
+	IngestReactor::Token IngestReactor::add(const int fd, FunctionReadable readable) {
+		base::MutexLock lock(_mutex);
+		if (fd == -1 || _epfd == -1) {
+			return NO_TOKEN;
+		}
+		const Token token = _nextToken++;
+		epoll_event ev;
+		ev.events = EPOLLIN | EPOLLONESHOT;
+		ev.data.u64 = token;
+		if (::epoll_ctl(_epfd, EPOLL_CTL_ADD, fd, &ev) == -1) {
+			PERROR("epoll_ctl: EPOLL_CTL_ADD fd %d", fd);
+			return NO_TOKEN;
+		}
+		// An other registration of this fd number had its fd closed (epoll
+		// removed it then), so it may not touch this number anymore
+		const auto owner = _owner.find(fd);
+		if (owner != _owner.end()) {
+			_watch[owner->second].fd = -1;
+		}
+		_owner[fd] = token;
+		_watch[token] = Watch{fd, readable};
+		SI_LOG_DEBUG("IngestReactor: Watching fd: %d (Total %zu)", fd, _watch.size());
+		return token;
+	}
+
+	void IngestReactor::remove(const Token token) {
+		base::MutexLock lock(_mutex);
+		const auto it = _watch.find(token);
+		if (it == _watch.end()) {
+			return;
+		}
+		const int fd = it->second.fd;
+		if (fd != -1) {
+			// The fd may already be closed by the input device, then epoll
+			// has removed it already
+			if (::epoll_ctl(_epfd, EPOLL_CTL_DEL, fd, nullptr) == -1 &&
+					errno != ENOENT && errno != EBADF) {
+				PERROR("epoll_ctl: EPOLL_CTL_DEL fd %d", fd);
+			}
+			_owner.erase(fd);
+		}
+		_watch.erase(it);
+		SI_LOG_DEBUG("IngestReactor: Stopped watching fd: %d (Total %zu)", fd, _watch.size());
+	}
+
+	bool IngestReactor::resume(const Token token) {
+		base::MutexLock lock(_mutex);
+		const auto it = _watch.find(token);
+		if (it == _watch.end() || it->second.fd == -1) {
+			return false;
+		}
+		const int fd = it->second.fd;
+		epoll_event ev;
+		ev.events = EPOLLIN | EPOLLONESHOT;
+		ev.data.u64 = token;
+		if (::epoll_ctl(_epfd, EPOLL_CTL_MOD, fd, &ev) == -1) {
+			if (errno != ENOENT && errno != EBADF) {
+				PERROR("epoll_ctl: EPOLL_CTL_MOD fd %d", fd);
+			}
+			// The input device closed this fd, so never add this number
+			// again here, it may belong to an other device by now
+			it->second.fd = -1;
+			_owner.erase(fd);
+			return false;
+		}
+		return true;
+	}
+
+} // namespace input
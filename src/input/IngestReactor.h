@@ -0,0 +1,114 @@
+/* IngestReactor.h
+
+   Copyright (C) 2014 - 2020 Marc Postema (mpostema09 -at- gmail.com)
+
+   This program is free software; you can redistribute it and/or
+   modify it under the terms of the GNU General Public License
+   as published by the Free Software Foundation; either version 2
+   of the License, or (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program; if not, write to the Free Software
+   Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+   Or, point your browser to http://www.gnu.org/copyleft/gpl.html
+*/
+#ifndef INPUT_INGEST_REACTOR_H_INCLUDE
+#define INPUT_INGEST_REACTOR_H_INCLUDE INPUT_INGEST_REACTOR_H_INCLUDE
+
+#include <FwDecl.h>
+#include <base/Mutex.h>
+#include <base/ThreadBase.h>
+
+#include <cstdint>
+#include <functional>
+#include <map>
+
+FW_DECL_UP_NS1(input, IngestReactor);
+
+namespace input {
+
+/// The class @c IngestReactor watches the data file descriptors of all
+/// streaming input devices with one epoll and dispatches readable events
+/// to the registered stream, instead of polling each device from its own
+/// stream thread.
+class IngestReactor :
+	public base::ThreadBase {
+	public:
+
+		/// Called when the registered file descriptor is readable.
+		/// @return true to keep watching, false to suspend watching until
+		/// @c resume is called (for ex. when the ring buffer is full)
+		using FunctionReadable = std::function<bool()>;
+
+		/// Identifies a registration, the fd number can not be used for that
+		/// because an input device may close it and another one may get the
+		/// same number
+		using Token = uint64_t;
+
+		static constexpr Token NO_TOKEN = 0;
+
+		// =====================================================================
+		//  -- Constructors and destructor -------------------------------------
+		// =====================================================================
+	public:
+
+		IngestReactor();
+
+		virtual ~IngestReactor();
+
+		// =====================================================================
+		//  -- base::ThreadBase ------------------------------------------------
+		// =====================================================================
+	protected:
+
+		/// @see ThreadBase
+		virtual void threadEntry() final;
+
+		// =====================================================================
+		//  -- Other member functions ------------------------------------------
+		// =====================================================================
+	public:
+
+		/// Start watching the file descriptor fd
+		/// @param fd specifies the file descriptor to watch for data
+		/// @param readable specifies the function called when data is available
+		/// @return the token of this registration or NO_TOKEN if it failed
+		Token add(int fd, FunctionReadable readable);
+
+		/// Stop watching the registration of token. When this function returns
+		/// its readable function is not being called anymore.
+		void remove(Token token);
+
+		/// Resume watching the registration of token, after its readable
+		/// function returned false
+		/// @return false if the fd was closed under this registration, then
+		/// it has to be removed and added again with the new fd
+		bool resume(Token token);
+
+		// =====================================================================
+		// -- Data members -----------------------------------------------------
+		// =====================================================================
+	private:
+
+		static constexpr int MAX_EVENTS = 64;
+
+		struct Watch {
+			int fd;                     /// -1 when the fd was closed under it
+			FunctionReadable readable;
+		};
+
+		base::Mutex _mutex;
+		int _epfd;
+		Token _nextToken;
+		std::map<Token, Watch> _watch;
+		std::map<int, Token> _owner;    /// registration that has the fd in the epoll
+};
+
+} // namespace input
+
+#endif // INPUT_INGEST_REACTOR_H_INCLUDE
@@ -192,6 +192,14 @@ namespace childpipe {
 		return "";
 	}
 
+	uint64_t TSReader::getDescribeVersion() const {
+		if (_exec.isOpen()) {
+			const DeviceData &data = _transform.transformDeviceData(_deviceData);
+			return data.getDescribeVersion();
+		}
+		return 0;
+	}
+
 	// =========================================================================
 	//  -- Other member functions ----------------------------------------------
 	// =========================================================================
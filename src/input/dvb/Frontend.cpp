@@ -31,7 +31,9 @@
 #include <input/dvb/delivery/DiSEqc.h>
 
 #include <chrono>
+#include <cmath>
 #include <thread>
+#include <vector>
 
 #include <stdio.h>
 #include <stdlib.h>
@@ -42,6 +44,7 @@
 #include <sys/ioctl.h>
 #include <sys/stat.h>
 #include <sys/types.h>
+#include <sys/uio.h>
 #include <linux/dvb/dmx.h>
 #include <linux/dvb/frontend.h>
 
@@ -50,6 +53,13 @@ namespace dvb {
 
 	const unsigned int Frontend::DEFAULT_DVR_BUFFER_SIZE = 18;
 	const unsigned int Frontend::MAX_DVR_BUFFER_SIZE     = 18 * 10;
+	const unsigned int Frontend::DEFAULT_LOCK_TIMEOUT    = 600;
+	const unsigned int Frontend::MAX_LOCK_TIMEOUT        = 5000;
+	const unsigned int Frontend::MIN_DVR_BUFFER_SIZE     = 1;
+	const unsigned int Frontend::DVR_BUFFER_SECONDS      = 2;
+	const unsigned int Frontend::DVR_BITRATE_WINDOW      = 5;
+	const int Frontend::SAME_TRANSPONDER_SCORE           = 8;
+	const unsigned int Frontend::RECENT_LOCK_TIME        = 60;
 
 	// =======================================================================
 	// -- Constructors and destructor ----------------------------------------
@@ -65,16 +75,30 @@ namespace dvb {
 		_tuned(false),
 		_fd_fe(-1),
 		_fd_dmx(-1),
+		_dmxGeneration(0),
 		_path_to_fe(fe),
 		_path_to_dvr(dvr),
 		_path_to_dmx(dmx),
+		_lockedParams(),
+		_tLastLock(),
 		_transform(appDataPath, _transformFrontendData),
 		_dvbs2(0),
 		_dvbt(0),
 		_dvbt2(0),
 		_dvbc(0),
 		_dvbc2(0),
-		_dvrBufferSizeMB(DEFAULT_DVR_BUFFER_SIZE) {
+		_dvrBufferSizeMB(DEFAULT_DVR_BUFFER_SIZE),
+		_dvrBufferAuto(false),
+		_dvrBufferSize(0),
+		_dvrOverflows(0),
+		_dvrBitrate(0),
+		_dvrMaxRead(0),
+		_dvrWindowBytes(0),
+		_tDvrWindow(),
+		_lockTimeoutMS(DEFAULT_LOCK_TIMEOUT),
+		_timeToLockMS(-1),
+		_dvrSyscalls(0),
+		_dvrReadBytes(0) {
 		snprintf(_fe_info.name, sizeof(_fe_info.name), "Not Set");
 		setupFrontend();
 #if FULL_DVB_API_VERSION >= 0x050A
@@ -187,6 +211,17 @@ namespace dvb {
 		ADD_XML_ELEMENT(xml, "symbol", StringConverter::stringFormat("%1 symbols/s to %2 symbols/s", _fe_info.symbol_rate_min, _fe_info.symbol_rate_max));
 
 		ADD_XML_NUMBER_INPUT(xml, "dvrbuffer", _dvrBufferSizeMB, 0, MAX_DVR_BUFFER_SIZE);
+		ADD_XML_CHECKBOX(xml, "dvrbufferAuto", (_dvrBufferAuto ? "true" : "false"));
+
+		const double readMB = _dvrReadBytes / (1024.0 * 1024.0);
+		ADD_XML_ELEMENT(xml, "dvrSyscallsPerMB", (readMB > 0.0) ? (_dvrSyscalls / readMB) : 0.0);
+		ADD_XML_ELEMENT(xml, "dvrBufferSize", _dvrBufferSize / (1024.0 * 1024.0));
+		ADD_XML_ELEMENT(xml, "dvrOverflows", _dvrOverflows.load());
+		ADD_XML_ELEMENT(xml, "dvrBitrate", _dvrBitrate.load());
+		ADD_XML_ELEMENT(xml, "dvrHighWater", _dvrMaxRead / 1024.0);
+
+		ADD_XML_NUMBER_INPUT(xml, "lockTimeout", _lockTimeoutMS, 0, MAX_LOCK_TIMEOUT);
+		ADD_XML_ELEMENT(xml, "timeToLock", _timeToLockMS.load());
 
 		// Channel
 		_frontendData.addToXML(xml);
@@ -199,6 +234,8 @@ namespace dvb {
 	}
 
 	void Frontend::doFromXML(const std::string &xml) {
+		// allocationScore() and isTunedTo() read this configuration
+		base::MutexLock lock(_mutex);
 		std::string element;
 		if (findXMLElement(xml, "dvrbuffer.value", element)) {
 			const unsigned int newSize = std::stoi(element);
@@ -206,6 +243,14 @@ namespace dvb {
 				newSize : DEFAULT_DVR_BUFFER_SIZE;
 
 		}
+		if (findXMLElement(xml, "dvrbufferAuto.value", element)) {
+			_dvrBufferAuto = (element == "true") ? true : false;
+		}
+		if (findXMLElement(xml, "lockTimeout.value", element)) {
+			const unsigned int timeout = std::stoi(element);
+			_lockTimeoutMS = (timeout <= MAX_LOCK_TIMEOUT) ?
+				timeout : DEFAULT_LOCK_TIMEOUT;
+		}
 		for (std::size_t i = 0; i < _deliverySystem.size(); ++i) {
 			const std::string deliverySystem = StringConverter::stringFormat("deliverySystem%1", i);
 			if (findXMLElement(xml, deliverySystem, element)) {
@@ -239,6 +284,7 @@ namespace dvb {
 		pfd.fd = _fd_dmx;
 		pfd.events = POLLIN;
 		pfd.revents = 0;
+		++_dvrSyscalls;
 		const int pollRet = ::poll(&pfd, 1, 180);
 		if (pollRet > 0) {
 			return (pfd.revents & POLLIN) == POLLIN;
@@ -252,8 +298,11 @@ namespace dvb {
 
 	bool Frontend::readFullTSPacket(mpegts::PacketBuffer &buffer) {
 		// try read maximum amount of bytes from DMX
-		const int bytes = ::read(_fd_dmx, buffer.getWriteBufferPtr(), buffer.getAmountOfBytesToWrite());
+		++_dvrSyscalls;
+		const std::size_t requested = buffer.getAmountOfBytesToWrite();
+		const int bytes = ::read(_fd_dmx, buffer.getWriteBufferPtr(), requested);
 		if (bytes > 0) {
+			dvrReadDone(bytes);
 			buffer.addAmountOfBytesWritten(bytes);
 			if (buffer.full()) {
 				// Add data to Filter
@@ -261,11 +310,74 @@ namespace dvb {
 				return true;
 			}
 		} else if (bytes < 0) {
-			PERROR("Frontend::readFullTSPacket");
+			if (errno == EOVERFLOW) {
+				dvrOverflow();
+			} else {
+				PERROR("Frontend::readFullTSPacket");
+			}
 		}
 		return false;
 	}
 
+	std::size_t Frontend::readTSPackets(mpegts::PacketBuffer *const *buffers, std::size_t n) {
+		if (n > MAX_READ_IOV) {
+			n = MAX_READ_IOV;
+		}
+		// Scatter one read over all the buffers
+		iovec iov[MAX_READ_IOV];
+		for (std::size_t i = 0; i < n; ++i) {
+			iov[i].iov_base = buffers[i]->getWriteBufferPtr();
+			iov[i].iov_len  = buffers[i]->getAmountOfBytesToWrite();
+		}
+		++_dvrSyscalls;
+		const ssize_t bytes = ::readv(_fd_dmx, iov, n);
+		if (bytes < 0) {
+			if (errno == EOVERFLOW) {
+				dvrOverflow();
+			} else if (errno != EAGAIN && errno != EWOULDBLOCK) {
+				PERROR("Frontend::readTSPackets");
+			}
+			return 0;
+		}
+		dvrReadDone(bytes);
+
+		// Distribute the read bytes over the buffers
+		std::size_t left = bytes;
+		std::size_t full = 0;
+		for (std::size_t i = 0; i < n && left > 0; ++i) {
+			const std::size_t size = (left < iov[i].iov_len) ? left : iov[i].iov_len;
+			buffers[i]->addAmountOfBytesWritten(size);
+			left -= size;
+			if (buffers[i]->full()) {
+				// Add data to Filter
+				_frontendData.addFilterData(_streamID, *buffers[i]);
+				++full;
+			}
+		}
+		return full;
+	}
+
+	bool Frontend::isSpliceable() const {
+		// The filter needs the TS packets until the tables are collected
+		const mpegts::Filter &filter = _frontendData.getFilterData();
+		return filter.getPATData()->isCollected() && filter.getPMTData()->isCollected();
+	}
+
+	ssize_t Frontend::spliceTSPackets(const int fd, const std::size_t size) {
+		++_dvrSyscalls;
+		const ssize_t bytes = ::splice(_fd_dmx, nullptr, fd, nullptr, size,
+			SPLICE_F_MOVE | SPLICE_F_NONBLOCK);
+		if (bytes < 0) {
+			if (errno == EOVERFLOW) {
+				dvrOverflow();
+				return 0;
+			}
+			return (errno == EAGAIN || errno == EWOULDBLOCK) ? 0 : -1;
+		}
+		dvrReadDone(bytes);
+		return bytes;
+	}
+
 	bool Frontend::capableOf(const input::InputSystem system) const {
 		for (const input::dvb::delivery::UpSystem &deliverySystem : _deliverySystem) {
 			if (deliverySystem->isCapableOf(system)) {
@@ -282,11 +394,57 @@ namespace dvb {
 		return capableOf(system);
 	}
 
+	int Frontend::allocationScore(const std::string &msg,
+			const std::string &method) const {
+		base::MutexLock lock(_mutex);
+		// Never locked, so nothing known about this frontend
+		if (_tLastLock == std::chrono::steady_clock::time_point()) {
+			return 0;
+		}
+		if (StringConverter::getDoubleParameter(msg, method, "freq=") == -1.0) {
+			return 0;
+		}
+		const FrontendData::TuningParameters req = getRequestedTuningParameters(msg, method);
+		int score = 0;
+		if (isLockedTransponder(req)) {
+			score = SAME_TRANSPONDER_SCORE;
+		} else {
+			for (const input::dvb::delivery::UpSystem &system : _deliverySystem) {
+				if (system->isCapableOf(_lockedParams.delsys)) {
+					score = system->switchScore(_lockedParams, req);
+					break;
+				}
+			}
+		}
+		// A recent lock means the LNB and switches are probably still powered
+		// and in a known state
+		if (std::chrono::steady_clock::now() - _tLastLock < std::chrono::seconds(RECENT_LOCK_TIME)) {
+			++score;
+		}
+		return score;
+	}
+
+	bool Frontend::isTunedTo(const std::string &msg, const std::string &method) const {
+		base::MutexLock lock(_mutex);
+		if (!_tuned || StringConverter::getDoubleParameter(msg, method, "freq=") == -1.0) {
+			return false;
+		}
+		return isLockedTransponder(getRequestedTuningParameters(msg, method));
+	}
+
+	void Frontend::setSharedPID(const int pid, const bool use) {
+		_frontendData.getFilterData().setPID(pid, use);
+	}
+
 	void Frontend::monitorSignal(const bool showStatus) {
 #if SIMU
 		(void)showStatus;
 		_frontendData.setMonitorData(FE_HAS_LOCK, 214, 15, 0, 0);
 #else
+		// Only sample a tuned frontend, the FE may be closed otherwise
+		if (!_tuned) {
+			return;
+		}
 		fe_status_t status;
 
 		// first read status
@@ -408,21 +566,29 @@ namespace dvb {
 		// Setup, tune and set PID Filters
 		if (_frontendData.hasDeviceDataChanged()) {
 			_frontendData.resetDeviceDataChanged();
-			_tuned = false;
-			// Close active PIDs
-			for (std::size_t i = 0; i < mpegts::PidTable::MAX_PIDS; ++i) {
-				_frontendData.getFilterData().setPID(i, false);
-				closePid(i);
+			if (_tuned && _frontendData.getTuningParameters() == _lockedParams) {
+				// Still the same transponder, so only the PID filters need an update
+				SI_LOG_INFO("Stream: %d, Same transponder requested, keep tuning", _streamID);
+			} else if (_tuned) {
+				// Retune with the FE and DMX kept open, the DMX keeps the PID
+				// filters that are still requested for the new transponder
+				SI_LOG_INFO("Stream: %d, Other transponder requested, retuning...", _streamID);
+				_tuned = false;
+				shrinkDvrBuffer();
+			} else {
+				closeActivePIDFilters();
+				closeFE();
+				closeDMX();
 			}
-			closeFE();
-			closeDMX();
-			// After close wait a moment before opening it again
-			std::this_thread::sleep_for(std::chrono::milliseconds(150));
 		}
 
 		std::size_t timeout = 0;
 		while (!setupAndTune()) {
-			std::this_thread::sleep_for(std::chrono::milliseconds(150));
+			// Waiting on the lock took its time already, only wait when
+			// the FE could not be opened, it may still be busy closing
+			if (_fd_fe == -1) {
+				std::this_thread::sleep_for(std::chrono::milliseconds(150));
+			}
 			++timeout;
 			if (timeout > 1) {
 				return false;
@@ -435,16 +601,17 @@ namespace dvb {
 	}
 
 	bool Frontend::teardown() {
-		// Close active PIDs
-		for (std::size_t i = 0; i < mpegts::PidTable::MAX_PIDS; ++i) {
-			_frontendData.getFilterData().setPID(i, false);
-			closePid(i);
-		}
+		closeActivePIDFilters();
 		_tuned = false;
 		closeFE();
 		closeDMX();
 		_frontendData.initialize();
 		_transform.resetTransformFlag();
+		_dvrSyscalls = 0;
+		_dvrReadBytes = 0;
+		_dvrOverflows = 0;
+		_dvrMaxRead = 0;
+		_dvrBufferSize = 0;
 		return true;
 	}
 
@@ -453,6 +620,11 @@ namespace dvb {
 		return data.attributeDescribeString(_streamID);
 	}
 
+	uint64_t Frontend::getDescribeVersion() const {
+		const DeviceData &data = _transform.transformDeviceData(_frontendData);
+		return data.getDescribeVersion();
+	}
+
 	// =======================================================================
 	//  -- Other member functions --------------------------------------------
 	// =======================================================================
@@ -638,6 +810,9 @@ namespace dvb {
 		if (_fd_fe != -1) {
 			SI_LOG_INFO("Stream: %d, Closing %s fd: %d", _streamID, _path_to_fe.c_str(), _fd_fe);
 			CLOSE_FD(_fd_fe);
+			for (input::dvb::delivery::UpSystem &system : _deliverySystem) {
+				system->frontendClosed();
+			}
 		}
 	}
 
@@ -650,12 +825,14 @@ namespace dvb {
 	}
 
 	void Frontend::closeDMX() {
-		if (_fd_dmx != -1) {
-			SI_LOG_INFO("Stream: %d, Closing %s fd: %d", _streamID, _path_to_dmx.c_str(), _fd_dmx);
-			if (::ioctl(_fd_dmx, DMX_STOP) != 0) {
+		// Hide the fd from the stream thread before the number can be reused
+		int fd = _fd_dmx.exchange(-1);
+		if (fd != -1) {
+			SI_LOG_INFO("Stream: %d, Closing %s fd: %d", _streamID, _path_to_dmx.c_str(), fd);
+			if (::ioctl(fd, DMX_STOP) != 0) {
 				PERROR("DMX_STOP");
 			}
-			CLOSE_FD(_fd_dmx);
+			CLOSE_FD(fd);
 		}
 	}
 
@@ -674,9 +851,13 @@ namespace dvb {
 			// Check if we have already opened a FE
 			if (_fd_fe == -1) {
 				_fd_fe = openFE(_path_to_fe, false);
+				if (_fd_fe == -1) {
+					return false;
+				}
 				SI_LOG_INFO("Stream: %d, Opened %s fd: %d", _streamID, _path_to_fe.c_str(), _fd_fe);
 			}
 			// try tuning
+			const auto tuneStart = std::chrono::steady_clock::now();
 			std::size_t timeout = 0;
 			while (!tune()) {
 				std::this_thread::sleep_for(std::chrono::milliseconds(450));
@@ -687,32 +868,69 @@ namespace dvb {
 			}
 			SI_LOG_INFO("Stream: %d, Waiting on lock...", _streamID);
 
-			// check if frontend is locked, if not try a few times
-			timeout = 0;
-			while (timeout < 4) {
-				fe_status_t status = FE_TIMEDOUT;
-				// first read status
-				if (::ioctl(_fd_fe, FE_READ_STATUS, &status) == 0) {
+			// check if frontend is locked
+			fe_status_t status = FE_TIMEDOUT;
+			if (waitForLock(status)) {
+				{
+					base::MutexLock lock(_mutex);
+					_lockedParams = _frontendData.getTuningParameters();
+					_tLastLock = std::chrono::steady_clock::now();
+				}
+				// We are tuned now
+				_tuned = true;
+				_timeToLockMS = std::chrono::duration_cast<std::chrono::milliseconds>(
+					std::chrono::steady_clock::now() - tuneStart).count();
+				SI_LOG_INFO("Stream: %d, Tuned and locked in %ld ms (FE status 0x%X)",
+					_streamID, _timeToLockMS.load(), status);
+			} else {
+				_timeToLockMS = -1;
+				SI_LOG_INFO("Stream: %d, Not locked within %u ms (FE status 0x%X)...",
+					_streamID, _lockTimeoutMS, status);
+				// The FE stays open, so send the DiSEqC commands again on a retry
+				for (input::dvb::delivery::UpSystem &system : _deliverySystem) {
+					system->tuneFailed();
+				}
+			}
+		}
+		return _tuned;
+	}
+
+	bool Frontend::waitForLock(fe_status_t &status) {
+		const auto deadline = std::chrono::steady_clock::now() +
+			std::chrono::milliseconds(_lockTimeoutMS);
+		struct pollfd pfd;
+		pfd.fd = _fd_fe;
+		pfd.events = POLLPRI;
+		for (;;) {
+			// the status may have changed without (or before) an event
+			if (::ioctl(_fd_fe, FE_READ_STATUS, &status) == 0 && (status & FE_HAS_LOCK)) {
+				return true;
+			}
+			const long remaining = std::chrono::duration_cast<std::chrono::milliseconds>(
+				deadline - std::chrono::steady_clock::now()).count();
+			if (remaining <= 0) {
+				return false;
+			}
+			// Not every driver sends events, so recheck the status at least every 100 ms
+			pfd.revents = 0;
+			const int pollRet = ::poll(&pfd, 1, (remaining < 100) ? remaining : 100);
+			if (pollRet > 0 && (pfd.revents & POLLPRI)) {
+				// get all pending events
+				struct dvb_frontend_event dfe;
+				while (::ioctl(_fd_fe, FE_GET_EVENT, &dfe) == 0) {
+					status = dfe.status;
 					if (status & FE_HAS_LOCK) {
-						// We are tuned now
-						_tuned = true;
-						SI_LOG_INFO("Stream: %d, Tuned and locked (FE status 0x%X)", _streamID, status);
-						break;
-					} else {
-						SI_LOG_INFO("Stream: %d, Not locked yet   (FE status 0x%X)...", _streamID, status);
+						return true;
 					}
 				}
-				std::this_thread::sleep_for(std::chrono::milliseconds(150));
-				++timeout;
+			} else if (pollRet < 0 && errno != EINTR) {
+				PERROR("Stream: %d, poll FE", _streamID);
+				return false;
 			}
 		}
-		return _tuned;
 	}
 
 	void Frontend::openPid(const int pid) {
-		if (!_frontendData.getFilterData().shouldPIDOpen(pid)) {
-			return;
-		}
 		// Check if we have already a DMX open
 		if (_fd_dmx == -1) {
 			// try opening DMX, try again if fails
@@ -724,15 +942,13 @@ namespace dvb {
 					return;
 				}
 			}
+			// Let the stream register the new fd, it may have the old number
+			++_dmxGeneration;
 			{
 				base::MutexLock lock(_mutex);
-				if (_dvrBufferSizeMB > 0) {
-					const unsigned int size = _dvrBufferSizeMB * 1024 * 1024;
-					if (::ioctl(_fd_dmx, DMX_SET_BUFFER_SIZE, size) != 0) {
-						PERROR("DMX - DMX_SET_BUFFER_SIZE failed");
-					} else {
-						SI_LOG_INFO("Stream: %d, Set DMX buffer size to %d Bytes", _streamID, size);
-					}
+				const unsigned long size = getInitialDvrBufferSize();
+				if (size > 0) {
+					resizeDvrBuffer(size, false);
 				}
 			}
 			struct dmx_pes_filter_params pesFilter;
@@ -745,7 +961,7 @@ namespace dvb {
 				PERROR("Stream: %d, DMX_SET_PES_FILTER (PID %04d)", _streamID, 0);
 				return;
 			}
-			SI_LOG_INFO("Stream: %d, Opened %s fd: %d", _streamID, _path_to_dmx.c_str(), _fd_dmx);
+			SI_LOG_INFO("Stream: %d, Opened %s fd: %d", _streamID, _path_to_dmx.c_str(), _fd_dmx.load());
 		} else if (::ioctl(_fd_dmx, DMX_ADD_PID, &pid) != 0) {
 			PERROR("Stream: %d, DMX_ADD_PID: PID %04d", _streamID, pid);
 			return;
@@ -756,9 +972,6 @@ namespace dvb {
 	}
 
 	void Frontend::closePid(const int pid) {
-		if (!_frontendData.getFilterData().shouldPIDClose(pid)) {
-			return;
-		}
 		if (::ioctl(_fd_dmx, DMX_REMOVE_PID, &pid) != 0) {
 			PERROR("Stream: %d, DMX_REMOVE_PID: PID %04d", _streamID, pid);
 			return;
@@ -781,10 +994,142 @@ namespace dvb {
 		}
 		_frontendData.getFilterData().resetPIDTableChanged();
 		SI_LOG_INFO("Stream: %d, Updating PID filters...", _streamID);
-		for (std::size_t i = 0; i < mpegts::PidTable::MAX_PIDS; ++i) {
-			// Check should we close PIDs first then open again
-			closePid(i);
-			openPid(i);
+		std::vector<int> closePIDs;
+		std::vector<int> openPIDs;
+		_frontendData.getFilterData().getChangedPIDs(closePIDs, openPIDs);
+		// Close PIDs first then open the new ones
+		for (const int pid : closePIDs) {
+			closePid(pid);
+		}
+		for (const int pid : openPIDs) {
+			openPid(pid);
+		}
+	}
+
+	FrontendData::TuningParameters Frontend::getRequestedTuningParameters(
+			const std::string &msg, const std::string &method) const {
+		FrontendData::TuningParameters req = _lockedParams;
+		const double reqFreq = StringConverter::getDoubleParameter(msg, method, "freq=");
+		if (reqFreq != -1.0) {
+			req.freq = static_cast<uint32_t>(std::lround(reqFreq * 1000.0));
+		}
+		const input::InputSystem msys = StringConverter::getMSYSParameter(msg, method);
+		if (msys != input::InputSystem::UNDEFINED) {
+			req.delsys = msys;
+		}
+		const int src = StringConverter::getIntParameter(msg, method, "src=");
+		if (src != -1) {
+			req.src = src;
+		}
+		const std::string pol = StringConverter::getStringParameter(msg, method, "pol=");
+		if (pol == "h") {
+			req.pol = delivery::Lnb::Polarization::Horizontal;
+		} else if (pol == "v") {
+			req.pol = delivery::Lnb::Polarization::Vertical;
+		}
+		return req;
+	}
+
+	bool Frontend::isLockedTransponder(const FrontendData::TuningParameters &req) const {
+		return req.delsys == _lockedParams.delsys && req.freq == _lockedParams.freq &&
+			req.src == _lockedParams.src && req.pol == _lockedParams.pol;
+	}
+
+	unsigned long Frontend::getInitialDvrBufferSize() const {
+		static constexpr unsigned long MB = 1024 * 1024;
+		if (!_dvrBufferAuto || _dvrBitrate == 0) {
+			return _dvrBufferSizeMB * MB;
+		}
+		// Size for the last measured bitrate, rounded up to whole MBytes
+		const unsigned long size = (_dvrBitrate * 1000 / 8) * DVR_BUFFER_SECONDS;
+		const unsigned long sizeMB = (size + MB - 1) / MB;
+		if (sizeMB < MIN_DVR_BUFFER_SIZE) {
+			return MIN_DVR_BUFFER_SIZE * MB;
+		} else if (sizeMB > MAX_DVR_BUFFER_SIZE) {
+			return MAX_DVR_BUFFER_SIZE * MB;
+		}
+		return sizeMB * MB;
+	}
+
+	bool Frontend::resizeDvrBuffer(const unsigned long size, const bool running) {
+		// The buffer size can only be changed when the DMX is stopped
+		if (running && ::ioctl(_fd_dmx, DMX_STOP) != 0) {
+			PERROR("DMX_STOP");
+			return false;
+		}
+		bool ok = true;
+		if (::ioctl(_fd_dmx, DMX_SET_BUFFER_SIZE, size) != 0) {
+			PERROR("DMX - DMX_SET_BUFFER_SIZE failed");
+			ok = false;
+		} else {
+			_dvrBufferSize = size;
+			SI_LOG_INFO("Stream: %d, Set DMX buffer size to %lu Bytes", _streamID, size);
+		}
+		if (running && ::ioctl(_fd_dmx, DMX_START) != 0) {
+			PERROR("DMX_START");
+			ok = false;
+		}
+		return ok;
+	}
+
+	void Frontend::shrinkDvrBuffer() {
+		// Resizing flushes the DMX buffer, which is only harmless while
+		// retuning, so a live stream is never shrunk
+		if (!_dvrBufferAuto || _fd_dmx == -1) {
+			return;
+		}
+		const unsigned long size = getInitialDvrBufferSize();
+		if (size * 4 <= _dvrBufferSize) {
+			SI_LOG_INFO("Stream: %d, DVR bitrate %lu kbit/s, shrinking DMX buffer",
+				_streamID, _dvrBitrate.load());
+			base::MutexLock lock(_mutex);
+			resizeDvrBuffer(size, true);
+		}
+	}
+
+	void Frontend::dvrReadDone(const std::size_t bytes) {
+		_dvrReadBytes += bytes;
+		if (bytes > _dvrMaxRead) {
+			_dvrMaxRead = bytes;
+		}
+		_dvrWindowBytes += bytes;
+		const auto now = std::chrono::steady_clock::now();
+		const long elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(now - _tDvrWindow).count();
+		if (elapsed < DVR_BITRATE_WINDOW * 1000) {
+			return;
+		}
+		// bits per ms is kbit/s
+		_dvrBitrate = (_dvrWindowBytes * 8) / elapsed;
+		_dvrWindowBytes = 0;
+		_tDvrWindow = now;
+
+	}
+
+	void Frontend::dvrOverflow() {
+		++_dvrOverflows;
+		SI_LOG_ERROR("Stream: %d, DMX buffer overflow (%lu Bytes), total overflows: %lu",
+			_streamID, _dvrBufferSize.load(), _dvrOverflows.load());
+		if (_dvrBufferAuto) {
+			// The data in the buffer is lost already, so grow it right away
+			static constexpr unsigned long MB = 1024 * 1024;
+			const unsigned long maxSize = MAX_DVR_BUFFER_SIZE * MB;
+			const unsigned long size = (_dvrBufferSize == 0) ?
+				MIN_DVR_BUFFER_SIZE * MB : _dvrBufferSize * 2;
+			if (_dvrBufferSize < maxSize) {
+				base::MutexLock lock(_mutex);
+				resizeDvrBuffer((size < maxSize) ? size : maxSize, true);
+			}
+		}
+	}
+
+	void Frontend::closeActivePIDFilters() {
+		mpegts::Filter &filter = _frontendData.getFilterData();
+		filter.setOpenedPIDsShouldClose();
+		std::vector<int> closePIDs;
+		std::vector<int> openPIDs;
+		filter.getChangedPIDs(closePIDs, openPIDs);
+		for (const int pid : closePIDs) {
+			closePid(pid);
 		}
 	}
 
@@ -30,6 +30,8 @@
 #include <decrypt/dvbapi/ClientProperties.h>
 #endif
 
+#include <atomic>
+#include <chrono>
 #include <string>
 
 FW_DECL_NS1(input, DeviceData);
@@ -57,6 +59,13 @@ class Frontend :
 
 		static const unsigned int DEFAULT_DVR_BUFFER_SIZE;
 		static const unsigned int MAX_DVR_BUFFER_SIZE;
+		static const unsigned int DEFAULT_LOCK_TIMEOUT;
+		static const unsigned int MAX_LOCK_TIMEOUT;
+		static const unsigned int MIN_DVR_BUFFER_SIZE;
+		static const unsigned int DVR_BUFFER_SECONDS;
+		static const unsigned int DVR_BITRATE_WINDOW;
+		static const int SAME_TRANSPONDER_SCORE;
+		static const unsigned int RECENT_LOCK_TIME;
 
 		// =======================================================================
 		//  -- Constructors and destructor ---------------------------------------
@@ -159,10 +168,30 @@ class Frontend :
 
 		virtual bool readFullTSPacket(mpegts::PacketBuffer &buffer) final;
 
+		virtual std::size_t readTSPackets(mpegts::PacketBuffer *const *buffers, std::size_t n) final;
+
+		virtual int getDataFD() const final {
+			return _fd_dmx;
+		}
+
+		virtual unsigned long getDataFDGeneration() const final {
+			return _dmxGeneration;
+		}
+
+		virtual bool isSpliceable() const final;
+
+		virtual ssize_t spliceTSPackets(int fd, std::size_t size) final;
+
 		virtual bool capableOf(InputSystem system) const final;
 
 		virtual bool capableToTransform(const std::string &msg, const std::string &method) const final;
 
+		virtual int allocationScore(const std::string &msg, const std::string &method) const final;
+
+		virtual bool isTunedTo(const std::string &msg, const std::string &method) const final;
+
+		virtual void setSharedPID(int pid, bool use) final;
+
 		virtual void monitorSignal(bool showStatus) final;
 
 		virtual bool hasDeviceDataChanged() const final;
@@ -175,6 +204,8 @@ class Frontend :
 
 		virtual std::string attributeDescribeString() const final;
 
+		virtual uint64_t getDescribeVersion() const final;
+
 		// =======================================================================
 		//  -- Other member functions --------------------------------------------
 		// =======================================================================
@@ -202,15 +233,52 @@ class Frontend :
 			return _tuned;
 		}
 
+		/// Close and open the PIDs that changed since the last update
 		void updatePIDFilters();
 
+		/// Close all opened PIDs
+		void closeActivePIDFilters();
+
+		/// Get the DMX buffer size to use when opening the DMX
+		/// @return the size in bytes or 0 for the kernel default
+		unsigned long getInitialDvrBufferSize() const;
+
+		/// Set the DMX buffer size, the DMX is stopped during resizing
+		/// if it is running
+		bool resizeDvrBuffer(unsigned long size, bool running);
+
+		/// Shrink the DMX buffer to the measured bitrate, when it is much
+		/// bigger. Only called when retuning, because it flushes the buffer.
+		void shrinkDvrBuffer();
+
+		/// Update the DVR statistics and the measured bitrate after a read
+		/// @param bytes specifies the amount of bytes read
+		void dvrReadDone(std::size_t bytes);
+
+		/// Handle a DMX buffer overflow (EOVERFLOW on read)
+		void dvrOverflow();
+
+		/// Get the tuning parameters of the request, the parameters not in
+		/// the request will be the same as the last lock
+		FrontendData::TuningParameters getRequestedTuningParameters(
+			const std::string &msg, const std::string &method) const;
+
+		/// Check if the request is for the transponder of the last lock
+		bool isLockedTransponder(const FrontendData::TuningParameters &req) const;
+
 		///
 		bool setupAndTune();
 
-		///
+		/// Wait on frontend events (POLLPRI) until the frontend has a lock
+		/// or the lock timeout expired
+		/// @param status will be the last read FE status
+		/// @return true if the frontend has a lock
+		bool waitForLock(fe_status_t &status);
+
+		/// Close pid, it should be in state 'ShouldClose'
 		void closePid(int pid);
 
-		///
+		/// Open pid, it should be in state 'ShouldOpen'
 		void openPid(int pid);
 
 		// =======================================================================
@@ -218,9 +286,10 @@ class Frontend :
 		// =======================================================================
 	private:
 
-		bool _tuned;
+		std::atomic<bool> _tuned;
 		int _fd_fe;
-		int _fd_dmx;
+		std::atomic<int> _fd_dmx;       /// read by the stream thread while tuning reopens it
+		std::atomic<unsigned long> _dmxGeneration; /// incremented after _fd_dmx is opened
 		std::string _path_to_fe;
 		std::string _path_to_dvr;
 		std::string _path_to_dmx;
@@ -228,6 +297,8 @@ class Frontend :
 
 		input::dvb::delivery::SystemUpVector _deliverySystem;
 		input::dvb::FrontendData _frontendData;
+		input::dvb::FrontendData::TuningParameters _lockedParams; /// parameters of the last lock
+		std::chrono::steady_clock::time_point _tLastLock;         /// time of the last lock
 #ifdef LIBDVBCSA
 		decrypt::dvbapi::ClientProperties _dvbapiData;
 #endif
@@ -239,8 +310,21 @@ class Frontend :
 		std::size_t _dvbc;
 		std::size_t _dvbc2;
 
-		unsigned long _dvrBufferSizeMB;
+		unsigned long _dvrBufferSizeMB;         /// DMX buffer size or start size if auto
+		bool _dvrBufferAuto;                    /// size the DMX buffer from the measured bitrate
+		std::atomic<unsigned long> _dvrBufferSize; /// current DMX buffer size in bytes
+		std::atomic<unsigned long> _dvrOverflows;  /// DMX buffer overflows
+		std::atomic<unsigned long> _dvrBitrate;    /// measured DVR bitrate in kbit/s
+		std::atomic<unsigned long> _dvrMaxRead;    /// most bytes read at once (buffer high-water mark)
+		unsigned long _dvrWindowBytes;             /// bytes read in the current bitrate window
+		std::chrono::steady_clock::time_point _tDvrWindow; /// begin of the current bitrate window
+		unsigned int _lockTimeoutMS;            /// max time to wait on lock after tuning
+		std::atomic<long> _timeToLockMS;        /// last measured tune to lock time, -1 no lock
 		bool _oldApiCallStats;
+
+		static constexpr std::size_t MAX_READ_IOV = 128;
+		std::atomic<unsigned long> _dvrSyscalls;  /// poll and read calls on DVR/DMX
+		std::atomic<unsigned long> _dvrReadBytes; /// bytes read from DVR/DMX
 };
 
 } // namespace dvb
@@ -24,11 +24,27 @@
 #include <Utils.h>
 #include <StringConverter.h>
 
+#include <cmath>
+
 namespace input {
 namespace dvb {
 
 	using namespace input::dvb::delivery;
 
+	// =======================================================================
+	// -- TuningParameters ---------------------------------------------------
+	// =======================================================================
+
+	bool FrontendData::TuningParameters::operator==(const TuningParameters &rhs) const {
+		return delsys == rhs.delsys && freq == rhs.freq && modtype == rhs.modtype &&
+			srate == rhs.srate && fec == rhs.fec && rolloff == rhs.rolloff &&
+			inversion == rhs.inversion && pilot == rhs.pilot && src == rhs.src &&
+			pol == rhs.pol && c2tft == rhs.c2tft && dataSlice == rhs.dataSlice &&
+			transmission == rhs.transmission && guard == rhs.guard &&
+			hierarchy == rhs.hierarchy && bandwidthHz == rhs.bandwidthHz &&
+			plp == rhs.plp && t2id == rhs.t2id && sm == rhs.sm;
+	}
+
 	// =======================================================================
 	// -- Constructors and destructor ----------------------------------------
 	// =======================================================================
@@ -111,15 +127,17 @@ namespace dvb {
 			const int streamID,
 			const std::string &msg,
 			const std::string &method) {
-		// Save freq FIRST because of possible initializing of channel data
-		const double oldFreq = _freq / 1000.0;
+		// Save tuning parameters FIRST because of possible initializing of channel data
+		const TuningParameters oldParams = getTuningParameters();
 		const double reqFreq = StringConverter::getDoubleParameter(msg, method, "freq=");
 		if (reqFreq != -1.0) {
-			if (reqFreq != oldFreq) {
+			// Compare in kHz, so a fractional MHz does not look like a new frequency
+			const uint32_t reqFreqKHz = static_cast<uint32_t>(std::lround(reqFreq * 1000.0));
+			if (reqFreqKHz != oldParams.freq) {
 				// New frequency, so initialize FrontendData and 'remove' all used PIDS
 				SI_LOG_INFO("Stream: %d, New frequency requested, clearing old channel data...", streamID);
 				initialize();
-				_freq = reqFreq * 1000.0;
+				_freq = reqFreqKHz;
 				_changed = true;
 			} else if (method == "SETUP" || method == "PLAY") {
 				const std::string list = StringConverter::getStringParameter(msg, method, "pids=");
@@ -332,10 +350,16 @@ namespace dvb {
 		if (!delpidsList.empty()) {
 			parsePIDString(delpidsList, "", false);
 		}
+		// Same frequency but an other polarization, source etc. needs tuning also
+		if (getTuningParameters() != oldParams) {
+			_changed = true;
+		}
 	}
 
 	std::string FrontendData::doAttributeDescribeString(const int streamID) const {
 		std::string desc;
+		// use one snapshot, so level, lock and quality belong together
+		const MonitorData monitor = getMonitorData();
 		switch (getDeliverySystem()) {
 			case input::InputSystem::DVBS:
 			case input::InputSystem::DVBS2:
@@ -344,9 +368,9 @@ namespace dvb {
 				StringConverter::addFormattedString(desc, "ver=1.0;src=%d;tuner=%d,%d,%d,%d,%.2lf,%c,%s,%s,%s,%s,%d,%s;pids=%s",
 						getDiSEqcSource(),
 						streamID + 1,
-						getSignalStrength(),
-						hasLock(),
-						getSignalToNoiseRatio(),
+						monitor.strength,
+						(monitor.status & FE_HAS_LOCK) ? 1 : 0,
+						monitor.snr,
 						getFrequency() / 1000.0,
 						getPolarizationChar(),
 						StringConverter::delsys_to_string(getDeliverySystem()),
@@ -363,9 +387,9 @@ namespace dvb {
 				//               <fec>,<plp>,<t2id>,<sm>;pids=<pid0>,..,<pidn>
 				StringConverter::addFormattedString(desc, "ver=1.1;tuner=%d,%d,%d,%d,%.2lf,%.3lf,%s,%s,%s,%s,%s,%d,%d,%d;pids=%s",
 						streamID + 1,
-						getSignalStrength(),
-						hasLock(),
-						getSignalToNoiseRatio(),
+						monitor.strength,
+						(monitor.status & FE_HAS_LOCK) ? 1 : 0,
+						monitor.snr,
 						getFrequency() / 1000.0,
 						getBandwidthHz() / 1000000.0,
 						StringConverter::delsys_to_string(getDeliverySystem()),
@@ -383,9 +407,9 @@ namespace dvb {
 				//               <plp>,<specinv>;pids=<pid0>,..,<pidn>
 				StringConverter::addFormattedString(desc, "ver=1.2;tuner=%d,%d,%d,%d,%.2lf,%.3lf,%s,%s,%d,%d,%d,%d,%d;pids=%s",
 						streamID + 1,
-						getSignalStrength(),
-						hasLock(),
-						getSignalToNoiseRatio(),
+						monitor.strength,
+						(monitor.status & FE_HAS_LOCK) ? 1 : 0,
+						monitor.snr,
 						getFrequency() / 1000.0,
 						getBandwidthHz() / 1000000.0,
 						StringConverter::delsys_to_string(getDeliverySystem()),
@@ -538,6 +562,31 @@ namespace dvb {
 		return _c2tft;
 	}
 
+	FrontendData::TuningParameters FrontendData::getTuningParameters() const {
+		base::MutexLock lock(_mutex);
+		TuningParameters params;
+		params.delsys = _delsys;
+		params.freq = _freq;
+		params.modtype = _modtype;
+		params.srate = _srate;
+		params.fec = _fec;
+		params.rolloff = _rolloff;
+		params.inversion = _inversion;
+		params.pilot = _pilot;
+		params.src = _src;
+		params.pol = _pol;
+		params.c2tft = _c2tft;
+		params.dataSlice = _data_slice;
+		params.transmission = _transmission;
+		params.guard = _guard;
+		params.hierarchy = _hierarchy;
+		params.bandwidthHz = _bandwidthHz;
+		params.plp = _plp_id;
+		params.t2id = _t2_system_id;
+		params.sm = _siso_miso;
+		return params;
+	}
+
 	int FrontendData::getUniqueIDT2() const {
 		base::MutexLock lock(_mutex);
 		return _t2_system_id;
@@ -32,6 +32,37 @@ namespace dvb {
 /// The class @c FrontendData carries all the data/information for tuning a frontend
 class FrontendData :
 	public DeviceData {
+	public:
+
+		/// The parameters that select a transponder/multiplex, so if these are
+		/// the same the frontend does not have to be retuned
+		struct TuningParameters {
+			input::InputSystem delsys;
+			uint32_t freq;
+			int modtype;
+			int srate;
+			int fec;
+			int rolloff;
+			int inversion;
+			int pilot;
+			int src;
+			input::dvb::delivery::Lnb::Polarization pol;
+			int c2tft;
+			int dataSlice;
+			int transmission;
+			int guard;
+			int hierarchy;
+			uint32_t bandwidthHz;
+			int plp;
+			int t2id;
+			int sm;
+
+			bool operator==(const TuningParameters &rhs) const;
+			bool operator!=(const TuningParameters &rhs) const {
+				return !(*this == rhs);
+			}
+		};
+
 		// =====================================================================
 		// -- Constructors and destructor --------------------------------------
 		// =====================================================================
@@ -121,6 +152,9 @@ class FrontendData :
 
 		int getC2TuningFrequencyType() const;
 
+		/// Get the parameters that select the current transponder/multiplex
+		TuningParameters getTuningParameters() const;
+
 	private:
 
 		///
@@ -118,6 +118,42 @@ namespace delivery {
 		return true;
 	}
 
+	void DVBS::frontendClosed() {
+		if (_diseqc) {
+			_diseqc->resetSwitchState();
+		}
+	}
+
+	void DVBS::tuneFailed() {
+		if (_diseqc) {
+			_diseqc->resetSwitchState();
+		}
+	}
+
+	int DVBS::switchScore(
+			const input::dvb::FrontendData::TuningParameters &last,
+			const input::dvb::FrontendData::TuningParameters &req) const {
+		if (!_diseqc) {
+			return 0;
+		}
+		// A shared cable needs a bus command for every tuning request, so
+		// prefer an other frontend when possible
+		int score = _diseqc->isSharedCable() ? -1 : 0;
+		if (last.src == req.src) {
+			// Same switch position, so no DiSEqC switching needed if
+			// the LNB band and polarization are the same also
+			const int src = (req.src - 1) % DiSEqc::MAX_LNB;
+			const Lnb &lnb = _diseqc->getLNB(src);
+			if (last.pol == req.pol &&
+				lnb.isHighBand(last.freq, last.pol) == lnb.isHighBand(req.freq, req.pol)) {
+				score += 2;
+			} else {
+				score += 1;
+			}
+		}
+		return score;
+	}
+
 	// =======================================================================
 	//  -- Other member functions --------------------------------------------
 	// =======================================================================
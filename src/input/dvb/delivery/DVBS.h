@@ -70,6 +70,14 @@ class DVBS :
 				   system == input::InputSystem::DVBS;
 		}
 
+		virtual void frontendClosed() final;
+
+		virtual void tuneFailed() final;
+
+		virtual int switchScore(
+				const input::dvb::FrontendData::TuningParameters &last,
+				const input::dvb::FrontendData::TuningParameters &req) const final;
+
 		// =======================================================================
 		// -- Other member functions ---------------------------------------------
 		// =======================================================================
@@ -60,6 +60,22 @@ namespace delivery {
 			virtual bool sendDiseqc(int feFD, int streamID, uint32_t &freq,
 				int src, Lnb::Polarization pol) = 0;
 
+			/// Forget the last send switch state, so the next @c sendDiseqc
+			/// will send it again (for ex. when the frontend was closed or
+			/// the tune did not lock)
+			virtual void resetSwitchState() {}
+
+			/// Check if this device shares one cable between several tuners
+			/// (Unicable), so each tuning request is send over a shared bus
+			virtual bool isSharedCable() const {
+				return false;
+			}
+
+			/// Get the LNB properties of DiSEqc source @c src
+			const Lnb &getLNB(int src) const {
+				return _lnb[src % MAX_LNB];
+			}
+
 		private:
 
 			/// Specialization for @see doAddToXML
@@ -50,6 +50,11 @@ namespace delivery {
 			virtual bool sendDiseqc(int feFD, int streamID, uint32_t &freq,
 				int src, Lnb::Polarization pol) final;
 
+			/// @see DiSEqc
+			virtual bool isSharedCable() const final {
+				return true;
+			}
+
 		private:
 
 			/// @see DiSEqc
@@ -37,7 +37,9 @@ namespace delivery {
 	//  -- Constructors and destructor ---------------------------------------
 	// =======================================================================
 	DiSEqcSwitch::DiSEqcSwitch() :
-		DiSEqc() {}
+		DiSEqc(),
+		_switchStateValid(false),
+		_switchState(0) {}
 
 	DiSEqcSwitch::~DiSEqcSwitch() {}
 
@@ -69,11 +71,20 @@ namespace delivery {
 		cmd.msg[3] =
 		  0xf0 | (((src << 2) & 0x0f) | ((pol == Lnb::Polarization::Vertical) ? 0 : 2) | (hiband ? 1 : 0));
 
+		// Switch is still in the requested position, so no need to send it again
+		if (_switchStateValid && _switchState == cmd.msg[3]) {
+			SI_LOG_INFO("Stream: %d, DiSEqC [%02x] unchanged, skip sending", streamID, cmd.msg[3]);
+			return true;
+		}
+
 		SI_LOG_INFO("Stream: %d, Sending DiSEqC [%02x] [%02x] [%02x] [%02x]", streamID, cmd.msg[0],
 				cmd.msg[1], cmd.msg[2], cmd.msg[3]);
 
-		return diseqcSwitch(feFD, (pol == Lnb::Polarization::Vertical) ? SEC_VOLTAGE_13 : SEC_VOLTAGE_18,
+		const uint8_t state = cmd.msg[3];
+		_switchStateValid = diseqcSwitch(feFD, (pol == Lnb::Polarization::Vertical) ? SEC_VOLTAGE_13 : SEC_VOLTAGE_18,
 				cmd, hiband ? SEC_TONE_ON : SEC_TONE_OFF, (src % 2) ? SEC_MINI_B : SEC_MINI_A);
+		_switchState = state;
+		return _switchStateValid;
 	}
 
 	void DiSEqcSwitch::doNextAddToXML(std::string &UNUSED(xml)) const {}
@@ -50,6 +50,11 @@ namespace delivery {
 			virtual bool sendDiseqc(int feFD, int streamID, uint32_t &freq,
 				int src, Lnb::Polarization pol) final;
 
+			/// @see DiSEqc
+			virtual void resetSwitchState() final {
+				_switchStateValid = false;
+			}
+
 		private:
 
 			/// @see DiSEqc
@@ -72,6 +77,10 @@ namespace delivery {
 			// =======================================================================
 
 		private:
+
+			// Last send switch state, to skip sending the same again
+			bool _switchStateValid;
+			uint8_t _switchState;
 	};
 
 } // namespace delivery
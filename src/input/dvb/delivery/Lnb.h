@@ -75,6 +75,13 @@ class Lnb :
 		void getIntermediateFrequency(uint32_t &freq,
 			bool &hiband, Polarization pol) const;
 
+		/// Check if the frequency needs the high band of this LNB
+		bool isHighBand(uint32_t freq, Polarization pol) const {
+			bool hiband = false;
+			getIntermediateFrequency(freq, hiband, pol);
+			return hiband;
+		}
+
 		// =======================================================================
 		// -- Data members -------------------------------------------------------
 		// =======================================================================
@@ -21,13 +21,13 @@
 #define INPUT_DVB_DELIVERY_SYSTEM_H_INCLUDE INPUT_DVB_DELIVERY_SYSTEM_H_INCLUDE
 
 #include <FwDecl.h>
+#include <Unused.h>
 #include <base/XMLSupport.h>
 #include <input/InputSystem.h>
+#include <input/dvb/FrontendData.h>
 
 #include <string>
 
-FW_DECL_NS2(input, dvb, FrontendData);
-
 FW_DECL_VECTOR_OF_UP_NS3(input, dvb, delivery, System);
 
 namespace input {
@@ -59,6 +59,24 @@ class System :
 		///
 		virtual bool isCapableOf(input::InputSystem system) const = 0;
 
+		/// The frontend is closed, so the state of connected devices (like
+		/// a DiSEqC switch) is not known anymore
+		virtual void frontendClosed() {}
+
+		/// The tune did not lock, so connected devices (like a DiSEqC switch)
+		/// may not be in the state that was send to them
+		virtual void tuneFailed() {}
+
+		/// Get a score on how fast this delivery system can switch from the
+		/// last locked transponder to the requested one (higher is faster)
+		/// @param last specifies the last locked tuning parameters
+		/// @param req specifies the requested tuning parameters
+		virtual int switchScore(
+				const input::dvb::FrontendData::TuningParameters &UNUSED(last),
+				const input::dvb::FrontendData::TuningParameters &UNUSED(req)) const {
+			return 0;
+		}
+
 		// =======================================================================
 		// -- Data members -------------------------------------------------------
 		// =======================================================================
@@ -190,6 +190,14 @@ namespace file {
 		return "";
 	}
 
+	uint64_t TSReader::getDescribeVersion() const {
+		if (_file.is_open()) {
+			const DeviceData &data = _transform.transformDeviceData(_deviceData);
+			return data.getDescribeVersion();
+		}
+		return 0;
+	}
+
 	// =========================================================================
 	//  -- Other member functions ----------------------------------------------
 	// =========================================================================
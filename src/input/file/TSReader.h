@@ -90,6 +90,10 @@ class TSReader :
 
 		virtual bool readFullTSPacket(mpegts::PacketBuffer &buffer) final;
 
+		virtual bool isLiveSource() const final {
+			return false;
+		}
+
 		virtual bool capableOf(input::InputSystem msys) const final;
 
 		virtual bool capableToTransform(const std::string &msg, const std::string &method) const final;
@@ -106,6 +110,8 @@ class TSReader :
 
 		virtual std::string attributeDescribeString() const final;
 
+		virtual uint64_t getDescribeVersion() const final;
+
 		// =====================================================================
 		//  -- Other member functions ------------------------------------------
 		// =====================================================================
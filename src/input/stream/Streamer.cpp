@@ -25,8 +25,11 @@
 #include <StringConverter.h>
 #include <mpegts/PacketBuffer.h>
 
+#include <cerrno>
 #include <cstring>
 
+#include <fcntl.h>
+
 namespace input {
 namespace stream {
 
@@ -120,6 +123,15 @@ namespace stream {
 		return false;
 	}
 
+	ssize_t Streamer::spliceTSPackets(const int fd, const std::size_t size) {
+		const ssize_t bytes = ::splice(_udpMultiListen.getFD(), nullptr, fd, nullptr, size,
+			SPLICE_F_MOVE | SPLICE_F_NONBLOCK);
+		if (bytes < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+			return 0;
+		}
+		return bytes;
+	}
+
 	bool Streamer::capableOf(const input::InputSystem system) const {
 		return system == input::InputSystem::STREAMER;
 	}
@@ -199,6 +211,14 @@ namespace stream {
 		return "";
 	}
 
+	uint64_t Streamer::getDescribeVersion() const {
+		if (_udpMultiListen.getFD() != -1) {
+			const DeviceData &data = _transform.transformDeviceData(_deviceData);
+			return data.getDescribeVersion();
+		}
+		return 0;
+	}
+
 	// =======================================================================
 	//  -- Other member functions --------------------------------------------
 	// =======================================================================
@@ -93,6 +93,16 @@ class Streamer :
 
 		virtual bool readFullTSPacket(mpegts::PacketBuffer &buffer) final;
 
+		virtual int getDataFD() const final {
+			return _udpMultiListen.getFD();
+		}
+
+		virtual bool isSpliceable() const final {
+			return true;
+		}
+
+		virtual ssize_t spliceTSPackets(int fd, std::size_t size) final;
+
 		virtual bool capableOf(input::InputSystem msys) const final;
 
 		virtual bool capableToTransform(const std::string &msg, const std::string &method) const final;
@@ -109,6 +119,8 @@ class Streamer :
 
 		virtual std::string attributeDescribeString() const final;
 
+		virtual uint64_t getDescribeVersion() const final;
+
 		// =====================================================================
 		//  -- Other member functions ------------------------------------------
 		// =====================================================================
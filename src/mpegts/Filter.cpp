@@ -171,6 +171,11 @@ namespace mpegts {
 		return _pidTable.getPidCSV();
 	}
 
+	uint32_t Filter::getPidVersion() const {
+		base::MutexLock lock(_mutex);
+		return _pidTable.getPidVersion();
+	}
+
 	void Filter::setPID(const int pid, const bool val) {
 		base::MutexLock lock(_mutex);
 		_pidTable.setPID(pid, val);
@@ -209,4 +214,14 @@ namespace mpegts {
 		_pidTable.setAllPID(val);
 	}
 
+	void Filter::setOpenedPIDsShouldClose() {
+		base::MutexLock lock(_mutex);
+		_pidTable.setOpenedPIDsShouldClose();
+	}
+
+	void Filter::getChangedPIDs(std::vector<int> &closePIDs, std::vector<int> &openPIDs) {
+		base::MutexLock lock(_mutex);
+		_pidTable.getChangedPIDs(closePIDs, openPIDs);
+	}
+
 } // namespace mpegts
@@ -102,6 +102,9 @@ class Filter {
 		/// Get the CSV of all the requested PID
 		std::string getPidCSV() const;
 
+		/// @see PidTable::getPidVersion
+		uint32_t getPidVersion() const;
+
 		/// Set pid used or not
 		void setPID(int pid, bool val);
 
@@ -120,6 +123,12 @@ class Filter {
 		/// Set all PID
 		void setAllPID(bool val);
 
+		/// Set all opened PIDs not used, so they will be closed
+		void setOpenedPIDsShouldClose();
+
+		/// @see PidTable::getChangedPIDs
+		void getChangedPIDs(std::vector<int> &closePIDs, std::vector<int> &openPIDs);
+
 		// =====================================================================
 		//  -- Data members ----------------------------------------------------
 		// =====================================================================
@@ -34,6 +34,26 @@ namespace mpegts {
 
 	PCR::~PCR() {}
 
+	// =======================================================================
+	//  -- Static member functions -------------------------------------------
+	// =======================================================================
+
+	bool PCR::getPCR(const unsigned char *data, std::uint64_t &pcr) {
+		// Check for 'adaptation field flag', length and 'PCR field present'
+		if ((data[3] & 0x20) != 0x20 || data[4] < 7 || (data[5] & 0x10) != 0x10) {
+			return false;
+		}
+		const std::uint64_t base =
+			(static_cast<std::uint64_t>(data[6]) << 25) |
+			(static_cast<std::uint64_t>(data[7]) << 17) |
+			(static_cast<std::uint64_t>(data[8]) <<  9) |
+			(static_cast<std::uint64_t>(data[9]) <<  1) |
+			(data[10] >> 7);
+		const std::uint64_t ext = ((data[10] & 0x01) << 8) | data[11];
+		pcr = (base * 300) + ext;
+		return true;
+	}
+
 	// =======================================================================
 	//  -- Other member functions --------------------------------------------
 	// =======================================================================
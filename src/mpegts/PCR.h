@@ -38,6 +38,17 @@ class PCR {
 
 		virtual ~PCR();
 
+		// =====================================================================
+		//  -- Static member functions -----------------------------------------
+		// =====================================================================
+	public:
+
+		/// Get the PCR (Base * 300 + Ext) of a TS packet
+		/// @param data specifies the TS packet
+		/// @param pcr will contain the PCR in 27 MHz ticks
+		/// @return true if this TS packet carries a PCR
+		static bool getPCR(const unsigned char *data, std::uint64_t &pcr);
+
 		// =====================================================================
 		//  -- Other member functions ------------------------------------------
 		// =====================================================================
@@ -44,23 +44,25 @@ PacketBuffer::~PacketBuffer() {}
 // =============================================================================
 
 void PacketBuffer::initialize(const uint32_t ssrc, const long timestamp) {
-	// initialize RTP header
-	_buffer[0]  = 0x80;                     // version: 2, padding: 0, extension: 0, CSRC: 0
-	_buffer[1]  = 33;                       // marker: 0, payload type: 33 (MP2T)
-	_buffer[2]  = (0 >> 8) & 0xff;          // sequence number
-	_buffer[3]  = (0 >> 0) & 0xff;          // sequence number
-	_buffer[4]  = (timestamp >> 24) & 0xff; // timestamp
-	_buffer[5]  = (timestamp >> 16) & 0xff; // timestamp
-	_buffer[6]  = (timestamp >>  8) & 0xff; // timestamp
-	_buffer[7]  = (timestamp >>  0) & 0xff; // timestamp
-	_buffer[8]  = (ssrc >> 24) & 0xff;      // synchronization source
-	_buffer[9]  = (ssrc >> 16) & 0xff;      // synchronization source
-	_buffer[10] = (ssrc >>  8) & 0xff;      // synchronization source
-	_buffer[11] = (ssrc >>  0) & 0xff;      // synchronization source
-
+	initializeRTPHeader(_buffer, ssrc, timestamp);
 	_initialized = true;
 }
 
+void PacketBuffer::initializeRTPHeader(unsigned char *header, const uint32_t ssrc, const long timestamp) {
+	header[0]  = 0x80;                     // version: 2, padding: 0, extension: 0, CSRC: 0
+	header[1]  = 33;                       // marker: 0, payload type: 33 (MP2T)
+	header[2]  = (0 >> 8) & 0xff;          // sequence number
+	header[3]  = (0 >> 0) & 0xff;          // sequence number
+	header[4]  = (timestamp >> 24) & 0xff; // timestamp
+	header[5]  = (timestamp >> 16) & 0xff; // timestamp
+	header[6]  = (timestamp >>  8) & 0xff; // timestamp
+	header[7]  = (timestamp >>  0) & 0xff; // timestamp
+	header[8]  = (ssrc >> 24) & 0xff;      // synchronization source
+	header[9]  = (ssrc >> 16) & 0xff;      // synchronization source
+	header[10] = (ssrc >>  8) & 0xff;      // synchronization source
+	header[11] = (ssrc >>  0) & 0xff;      // synchronization source
+}
+
 bool PacketBuffer::trySyncing() {
 	if (isSynced()) {
 		return true;
@@ -83,15 +85,19 @@ bool PacketBuffer::trySyncing() {
 }
 
 void PacketBuffer::tagRTPHeaderWith(const uint16_t cseq, const long timestamp) {
+	tagRTPHeader(_buffer, cseq, timestamp);
+}
+
+void PacketBuffer::tagRTPHeader(unsigned char *header, const uint16_t cseq, const long timestamp) {
 	// update sequence number
-	_buffer[2] = ((cseq >> 8) & 0xFF); // sequence number
-	_buffer[3] =  (cseq & 0xFF);       // sequence number
+	header[2] = ((cseq >> 8) & 0xFF); // sequence number
+	header[3] =  (cseq & 0xFF);       // sequence number
 
 	// update timestamp
-	_buffer[4] = (timestamp >> 24) & 0xFF; // timestamp
-	_buffer[5] = (timestamp >> 16) & 0xFF; // timestamp
-	_buffer[6] = (timestamp >>  8) & 0xFF; // timestamp
-	_buffer[7] = (timestamp >>  0) & 0xFF; // timestamp
+	header[4] = (timestamp >> 24) & 0xFF; // timestamp
+	header[5] = (timestamp >> 16) & 0xFF; // timestamp
+	header[6] = (timestamp >>  8) & 0xFF; // timestamp
+	header[7] = (timestamp >>  0) & 0xFF; // timestamp
 }
 
 } // namespace mpegts
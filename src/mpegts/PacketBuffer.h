@@ -61,6 +61,14 @@ class PacketBuffer {
 		/// This will tag the RTP header with sequence number and timestamp
 		void tagRTPHeaderWith(uint16_t cseq, long timestamp);
 
+		/// Initialize an RTP header for MP2T payload
+		/// @param header specifies the RTP header of RTP_HEADER_LEN bytes
+		static void initializeRTPHeader(unsigned char *header, uint32_t ssrc, long timestamp);
+
+		/// Tag an RTP header with sequence number and timestamp
+		/// @param header specifies the RTP header of RTP_HEADER_LEN bytes
+		static void tagRTPHeader(unsigned char *header, uint16_t cseq, long timestamp);
+
 		/// This function will return the number of TS Packets that are
 		/// in this TS Packet
 		static constexpr std::size_t getNumberOfTSPackets() {
@@ -83,6 +91,11 @@ class PacketBuffer {
 			_writeIndex += index;
 		}
 
+		/// Check if nothing is written to this buffer yet
+		bool empty() const {
+			return _writeIndex == RTP_HEADER_LEN;
+		}
+
 		/// Check if we have written all the buffer
 		bool full() const {
 			return (MTU_MAX_TS_PACKET_SIZE + RTP_HEADER_LEN) == _writeIndex;
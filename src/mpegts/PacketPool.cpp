@@ -0,0 +1,139 @@
+/* PacketPool.cpp
+
+   Copyright (C) 2014 - 2020 Marc Postema (mpostema09 -at- gmail.com)
+
+   This program is free software; you can redistribute it and/or
+   modify it under the terms of the GNU General Public License
+   as published by the Free Software Foundation; either version 2
+   of the License, or (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program; if not, write to the Free Software
+   Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+   Or, point your browser to http://www.gnu.org/copyleft/gpl.html
+*/
+#include <mpegts/PacketPool.h>
+
+#include <Log.h>
+
+#include <cstdlib>
+#include <cstring>
+#include <new>
+
+#include <sys/mman.h>
+
+namespace mpegts {
+
+// =============================================================================
+// -- Constructors and destructor ----------------------------------------------
+// =============================================================================
+
+PacketPool::PacketPool(const std::size_t size, const bool hugePages) :
+	_size(size),
+	_stride(((sizeof(Block) + CACHE_LINE_SIZE - 1) / CACHE_LINE_SIZE) * CACHE_LINE_SIZE),
+	_memorySize(size * _stride),
+	_memory(nullptr),
+	_mapped(false),
+	_hugePages(false),
+	_inUse(0),
+	_maxInUse(0),
+	_allocFailures(0) {
+	if (hugePages) {
+		const std::size_t hugeSize = ((_memorySize + HUGE_PAGE_SIZE - 1) / HUGE_PAGE_SIZE) * HUGE_PAGE_SIZE;
+		void *memory = ::mmap(nullptr, hugeSize, PROT_READ | PROT_WRITE,
+			MAP_PRIVATE | MAP_ANONYMOUS | MAP_POPULATE | MAP_HUGETLB, -1, 0);
+		if (memory != MAP_FAILED) {
+			_memory = static_cast<unsigned char *>(memory);
+			_memorySize = hugeSize;
+			_mapped = true;
+			_hugePages = true;
+		} else {
+			PERROR("PacketPool: mmap with huge pages failed, using normal pages");
+		}
+	}
+	if (_memory == nullptr) {
+		void *memory = ::mmap(nullptr, _memorySize, PROT_READ | PROT_WRITE,
+			MAP_PRIVATE | MAP_ANONYMOUS | MAP_POPULATE, -1, 0);
+		if (memory != MAP_FAILED) {
+			_memory = static_cast<unsigned char *>(memory);
+			_mapped = true;
+		} else if (::posix_memalign(&memory, CACHE_LINE_SIZE, _memorySize) == 0) {
+			// Touch all pages now, so the streams do not page fault later
+			std::memset(memory, 0, _memorySize);
+			_memory = static_cast<unsigned char *>(memory);
+		} else {
+			SI_LOG_ERROR("PacketPool: Unable to allocate %zu Bytes", _memorySize);
+			_size = 0;
+		}
+	}
+	_free.reserve(_size);
+	for (std::size_t i = 0; i < _size; ++i) {
+		Block *block = new (_memory + (i * _stride)) Block;
+		block->refCount = 0;
+		// Push in reverse, so the first blocks are allocated first
+		_free.push_back(_size - 1 - i);
+	}
+	SI_LOG_INFO("PacketPool: %zu blocks of %zu Bytes (%s pages)", _size, _stride,
+		_hugePages ? "huge" : "normal");
+}
+
+PacketPool::~PacketPool() {
+	for (std::size_t i = 0; i < _size; ++i) {
+		reinterpret_cast<Block *>(_memory + (i * _stride))->~Block();
+	}
+	if (_mapped) {
+		::munmap(_memory, _memorySize);
+	} else {
+		std::free(_memory);
+	}
+}
+
+// =============================================================================
+//  -- Other member functions --------------------------------------------------
+// =============================================================================
+
+PacketPool::Block &PacketPool::getBlock(PacketBuffer *buffer, std::size_t &index) {
+	index = (reinterpret_cast<unsigned char *>(buffer) - _memory) / _stride;
+	return *reinterpret_cast<Block *>(_memory + (index * _stride));
+}
+
+PacketBuffer *PacketPool::allocate() {
+	std::size_t index;
+	{
+		base::MutexLock lock(_mutex);
+		if (_free.empty()) {
+			++_allocFailures;
+			return nullptr;
+		}
+		index = _free.back();
+		_free.pop_back();
+	}
+	const std::size_t inUse = ++_inUse;
+	if (inUse > _maxInUse) {
+		_maxInUse = inUse;
+	}
+	Block *block = reinterpret_cast<Block *>(_memory + (index * _stride));
+	block->refCount = 1;
+	return &block->buffer;
+}
+
+void PacketPool::addRef(PacketBuffer *buffer) {
+	std::size_t index;
+	++getBlock(buffer, index).refCount;
+}
+
+void PacketPool::release(PacketBuffer *buffer) {
+	std::size_t index;
+	if (--getBlock(buffer, index).refCount == 0) {
+		--_inUse;
+		base::MutexLock lock(_mutex);
+		_free.push_back(index);
+	}
+}
+
+} // namespace mpegts
@@ -0,0 +1,137 @@
+/* PacketPool.h
+
+   Copyright (C) 2014 - 2020 Marc Postema (mpostema09 -at- gmail.com)
+
+   This program is free software; you can redistribute it and/or
+   modify it under the terms of the GNU General Public License
+   as published by the Free Software Foundation; either version 2
+   of the License, or (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program; if not, write to the Free Software
+   Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+   Or, point your browser to http://www.gnu.org/copyleft/gpl.html
+*/
+#ifndef MPEGTS_PACKET_POOL_H_INCLUDE
+#define MPEGTS_PACKET_POOL_H_INCLUDE MPEGTS_PACKET_POOL_H_INCLUDE
+
+#include <FwDecl.h>
+#include <base/Mutex.h>
+#include <mpegts/PacketBuffer.h>
+
+#include <atomic>
+#include <cstddef>
+#include <vector>
+
+FW_DECL_UP_NS1(mpegts, PacketPool);
+
+namespace mpegts {
+
+/// The class @c PacketPool is a pool of @c PacketBuffer blocks shared by all
+/// streams. The blocks are reference counted, so one read from an input device
+/// can be handed to several consumers without copying. The memory is
+/// pre-faulted, every block starts on a cache line and it can optionally be
+/// backed by huge pages.
+class PacketPool {
+		// =====================================================================
+		// -- Constructors and destructor --------------------------------------
+		// =====================================================================
+	public:
+
+		/// @param size specifies the amount of blocks in this pool
+		/// @param hugePages specifies if it should try to use huge pages
+		PacketPool(std::size_t size, bool hugePages);
+
+		virtual ~PacketPool();
+
+		// =====================================================================
+		// -- Other member functions -------------------------------------------
+		// =====================================================================
+	public:
+
+		/// Get a free block with a reference count of one, the content is
+		/// not initialized
+		/// @return the block or nullptr if the pool is exhausted
+		PacketBuffer *allocate();
+
+		/// Add a reference to an allocated block
+		void addRef(PacketBuffer *buffer);
+
+		/// Release a reference to a block, when it was the last reference
+		/// the block returns to the pool
+		void release(PacketBuffer *buffer);
+
+		/// Get the amount of blocks in this pool
+		std::size_t getSize() const {
+			return _size;
+		}
+
+		/// Get the amount of allocated blocks
+		std::size_t getInUse() const {
+			return _inUse;
+		}
+
+		/// Get the most blocks that were allocated at once
+		std::size_t getMaxInUse() const {
+			return _maxInUse;
+		}
+
+		/// Get the amount of failed allocations, because the pool was exhausted
+		unsigned long getAllocFailures() const {
+			return _allocFailures;
+		}
+
+		/// Get the memory all blocks are in, for ex. to register it with the kernel
+		unsigned char *getMemory() const {
+			return _memory;
+		}
+
+		/// Get the size of the memory all blocks are in
+		std::size_t getMemorySize() const {
+			return _memorySize;
+		}
+
+		/// Check if this pool is backed by huge pages
+		bool isHugePageBacked() const {
+			return _hugePages;
+		}
+
+	private:
+
+		struct Block {
+			PacketBuffer buffer;
+			std::atomic<unsigned int> refCount;
+		};
+
+		/// Get the block that contains buffer
+		Block &getBlock(PacketBuffer *buffer, std::size_t &index);
+
+		// =====================================================================
+		// -- Data members -----------------------------------------------------
+		// =====================================================================
+	private:
+
+		static constexpr std::size_t CACHE_LINE_SIZE = 64;
+		static constexpr std::size_t HUGE_PAGE_SIZE = 2 * 1024 * 1024;
+
+		base::Mutex _mutex;
+		std::size_t _size;
+		std::size_t _stride;              /// block size rounded up to cache lines
+		std::size_t _memorySize;
+		unsigned char *_memory;
+		bool _mapped;                     /// memory is from mmap, else from posix_memalign
+		bool _hugePages;
+		std::vector<std::size_t> _free;   /// indices of the free blocks
+		std::atomic<std::size_t> _inUse;
+		std::atomic<std::size_t> _maxInUse;
+		std::atomic<unsigned long> _allocFailures;
+};
+
+} // namespace mpegts
+
+#endif // MPEGTS_PACKET_POOL_H_INCLUDE
@@ -25,9 +25,12 @@
 
 namespace mpegts {
 
-	PidTable::PidTable() {
+	PidTable::PidTable() :
+		_pidVersion(0) {
 		for (size_t i = 0; i < MAX_PIDS; ++i) {
+			_data[i].state = State::Closed;
 			resetPidData(i);
+			_data[i].logged = false;
 		}
 		_changed = false;
 	}
@@ -48,7 +51,7 @@ namespace mpegts {
 	}
 
 	void PidTable::resetPidData(const int pid) {
-		_data[pid].state       = State::Closed;
+		setPIDState(pid, State::Closed);
 		_data[pid].cc          = 0x80;
 		_data[pid].cc_error    = 0;
 		_data[pid].count       = 0;
@@ -107,11 +110,16 @@ namespace mpegts {
 	void PidTable::setPID(const int pid, const bool use) {
 		// Check PID not used anymore, so set ShouldClose state
 		if (!use && _data[pid].state == State::Opened) {
-			_data[pid].state = State::ShouldClose;
+			setPIDState(pid, State::ShouldClose);
 			_changed = true;
+			logPIDChange(pid);
 		} else if (use && _data[pid].state == State::Closed) {
-			_data[pid].state = State::ShouldOpen;
+			setPIDState(pid, State::ShouldOpen);
 			_changed = true;
+			logPIDChange(pid);
+		} else if (use && _data[pid].state == State::ShouldClose) {
+			// Requested again before it was closed, so keep it open
+			setPIDState(pid, State::Opened);
 		}
 	}
 
@@ -124,7 +132,7 @@ namespace mpegts {
 	}
 
 	void PidTable::setPIDClosed(const int pid) {
-		_data[pid].state = State::Closed;
+		setPIDState(pid, State::Closed);
 	}
 
 	bool PidTable::shouldPIDOpen(const int pid) const {
@@ -132,11 +140,55 @@ namespace mpegts {
 	}
 
 	void PidTable::setPIDOpened(const int pid) {
-		_data[pid].state = State::Opened;
+		setPIDState(pid, State::Opened);
 	}
 
 	void PidTable::setAllPID(const bool use) {
 		setPID(ALL_PIDS, use);
 	}
 
+	void PidTable::setOpenedPIDsShouldClose() {
+		for (size_t i = 0; i < MAX_PIDS; ++i) {
+			if (_data[i].state == State::Opened) {
+				setPID(i, false);
+			}
+		}
+	}
+
+	void PidTable::getChangedPIDs(std::vector<int> &closePIDs, std::vector<int> &openPIDs) {
+		// Keep the PIDs that are still pending (for ex. when opening failed),
+		// drop the ones that are handled already
+		std::size_t keep = 0;
+		for (const int pid : _changeLog) {
+			switch (_data[pid].state) {
+				case State::ShouldClose:
+					closePIDs.push_back(pid);
+					_changeLog[keep++] = pid;
+					break;
+				case State::ShouldOpen:
+					openPIDs.push_back(pid);
+					_changeLog[keep++] = pid;
+					break;
+				default:
+					_data[pid].logged = false;
+					break;
+			}
+		}
+		_changeLog.resize(keep);
+	}
+
+	void PidTable::setPIDState(const int pid, const State state) {
+		if ((_data[pid].state == State::Opened) != (state == State::Opened)) {
+			++_pidVersion;
+		}
+		_data[pid].state = state;
+	}
+
+	void PidTable::logPIDChange(const int pid) {
+		if (!_data[pid].logged) {
+			_data[pid].logged = true;
+			_changeLog.push_back(pid);
+		}
+	}
+
 } // namespace mpegts
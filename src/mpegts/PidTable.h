@@ -22,6 +22,7 @@
 
 #include <cstdint>
 #include <string>
+#include <vector>
 
 namespace mpegts {
 
@@ -57,6 +58,12 @@ namespace mpegts {
 			/// Get the CSV of all the requested PID
 			std::string getPidCSV() const;
 
+			/// Get the version of the opened PIDs, it changes every time a
+			/// PID is opened or stops being opened (so @see getPidCSV changed)
+			uint32_t getPidVersion() const {
+				return _pidVersion;
+			}
+
 			/// Set the continuity counter for pid
 			void addPIDData(int pid, uint8_t cc);
 
@@ -81,11 +88,22 @@ namespace mpegts {
 			/// Set all PID
 			void setAllPID(bool use);
 
+			/// Set all opened PIDs not used, so they will be closed
+			void setOpenedPIDsShouldClose();
+
+			/// Get the PIDs that should be closed or opened. Only the PIDs
+			/// that changed state are checked, not the whole table.
+			/// @param closePIDs will get the PIDs that should be closed
+			/// @param openPIDs will get the PIDs that should be opened
+			void getChangedPIDs(std::vector<int> &closePIDs, std::vector<int> &openPIDs);
+
 		protected:
 
+			/// Add pid to the change log, if it is not there yet
+			void logPIDChange(int pid);
+
 			/// Reset the pid data like counters etc. (Not DMX File Descriptor)
 			void resetPidData(int pid);
-
 			// ================================================================
 			//  -- Data members -----------------------------------------------
 			// ================================================================
@@ -111,10 +129,16 @@ namespace mpegts {
 				uint8_t cc;        /// continuity counter (0 - 15) of this PID
 				uint32_t cc_error; /// cc error count
 				uint32_t count;    /// the number of times this pid occurred
+				bool logged;       /// this pid is in the change log
 			};
 
+			/// Set the state of pid and update the version of the opened PIDs
+			void setPIDState(int pid, State state);
+
 			bool _changed;           /// if something changed to 'pid' array
+			uint32_t _pidVersion;    /// changes when the opened PIDs change
 			PidData _data[MAX_PIDS]; /// used pids
+			std::vector<int> _changeLog; /// PIDs that (may) have a pending state change
 
 	};
 
@@ -0,0 +1,579 @@
+/* EgressRing.cpp
+
+   Copyright (C) 2014 - 2020 Marc Postema (mpostema09 -at- gmail.com)
+
+   This program is free software; you can redistribute it and/or
+   modify it under the terms of the GNU General Public License
+   as published by the Free Software Foundation; either version 2
+   of the License, or (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program; if not, write to the Free Software
+   Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+   Or, point your browser to http://www.gnu.org/copyleft/gpl.html
+*/
+#include <output/EgressRing.h>
+
+#include <Log.h>
+#include <Utils.h>
+#include <mpegts/PacketBuffer.h>
+#include <mpegts/PacketPool.h>
+
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <thread>
+
+#include <netinet/udp.h>
+#include <sys/eventfd.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#ifdef HAS_IO_URING
+	#include <linux/io_uring.h>
+#endif
+
+#ifndef UDP_SEGMENT
+	#define UDP_SEGMENT 103
+#endif
+
+namespace output {
+
+	/// user_data of the read of the eventfd
+	static constexpr uint64_t WAKE_UP_ID = ~0ull;
+
+	// =========================================================================
+	//  -- Constructors and destructor -----------------------------------------
+	// =========================================================================
+
+	EgressRing::EgressRing(mpegts::PacketPool &pool) :
+		ThreadBase("EgressRing"),
+		_pool(pool),
+		_fd(-1),
+		_eventFD(-1),
+		_eventValue(0),
+		_wakeArmed(false),
+		_idle(false),
+		_fixedBuffers(false),
+		_fixedFiles(false),
+		_sqRing(nullptr),
+		_sqRingSize(0),
+		_cqRing(nullptr),
+		_cqRingSize(0),
+		_sqes(nullptr),
+		_sqesSize(0),
+		_sqHead(nullptr),
+		_sqTail(nullptr),
+		_sqMask(0),
+		_sqEntries(0),
+		_sqLocalTail(0),
+		_cqHead(nullptr),
+		_cqTail(nullptr),
+		_cqMask(0),
+		_cqes(nullptr),
+		_request(RING_ENTRIES),
+		_inFlight(0),
+		_files(MAX_FILES),
+		_submits(0),
+		_requests(0),
+		_rejected(0) {
+		_freeRequest.reserve(RING_ENTRIES);
+		for (std::size_t i = 0; i < RING_ENTRIES; ++i) {
+			_freeRequest.push_back(RING_ENTRIES - 1 - i);
+		}
+		for (File &file : _files) {
+			file.fd = -1;
+		}
+		if (setup()) {
+			SI_LOG_INFO("EgressRing: io_uring with %u entries (fixed buffers: %s, fixed files: %s)",
+				_sqEntries, _fixedBuffers ? "yes" : "no", _fixedFiles ? "yes" : "no");
+		} else {
+			cleanup();
+		}
+	}
+
+	EgressRing::~EgressRing() {
+		terminateThread();
+		// The kernel may still send from the buffers of the requests in flight
+		for (int i = 0; i < 100 && _fd != -1 && _inFlight > 0; ++i) {
+			enter(0, 10);
+			reapCompletions();
+		}
+		cleanup();
+	}
+
+	// =========================================================================
+	//  -- base::ThreadBase ----------------------------------------------------
+	// =========================================================================
+
+	void EgressRing::threadEntry() {
+		if (_fd == -1) {
+			return;
+		}
+		while (running()) {
+			unsigned int toSubmit;
+			bool idle;
+			{
+				base::MutexLock lock(_mutex);
+				if (!_wakeArmed) {
+					armWakeUp();
+				}
+				toSubmit = _sqLocalTail - __atomic_load_n(_sqHead, __ATOMIC_ACQUIRE);
+				// Without requests wait for a wake up, else let the sends of
+				// the streams collect until one completes or the interval ends
+				idle = (_inFlight == 0);
+				_idle = idle;
+			}
+			const int ret = enter(toSubmit, idle ? 100 : SUBMIT_INTERVAL_MS);
+			if (ret > 0 && !idle) {
+				++_submits;
+			} else if (ret == -1 && errno != ETIME && errno != EINTR &&
+					errno != EAGAIN && errno != EBUSY) {
+				PERROR("io_uring_enter");
+			}
+			reapCompletions();
+		}
+	}
+
+	// =========================================================================
+	//  -- Other member functions ----------------------------------------------
+	// =========================================================================
+
+	bool EgressRing::setup() {
+#ifdef HAS_IO_URING
+		struct io_uring_params params;
+		std::memset(&params, 0, sizeof(params));
+		_fd = ::syscall(__NR_io_uring_setup, RING_ENTRIES, &params);
+		if (_fd == -1) {
+			SI_LOG_INFO("EgressRing: io_uring not available: %s", strerror(errno));
+			return false;
+		}
+		if ((params.features & IORING_FEAT_EXT_ARG) == 0 || (params.features & IORING_FEAT_NODROP) == 0) {
+			SI_LOG_INFO("EgressRing: io_uring of this kernel is too old");
+			return false;
+		}
+		_sqRingSize = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+		_cqRingSize = params.cq_off.cqes + params.cq_entries * sizeof(struct io_uring_cqe);
+		const bool singleMap = (params.features & IORING_FEAT_SINGLE_MMAP) != 0;
+		if (singleMap && _cqRingSize > _sqRingSize) {
+			_sqRingSize = _cqRingSize;
+		}
+		void *ring = ::mmap(nullptr, _sqRingSize, PROT_READ | PROT_WRITE,
+			MAP_SHARED | MAP_POPULATE, _fd, IORING_OFF_SQ_RING);
+		if (ring == MAP_FAILED) {
+			PERROR("EgressRing: mmap SQ ring");
+			return false;
+		}
+		_sqRing = ring;
+		if (singleMap) {
+			_cqRing = _sqRing;
+		} else {
+			ring = ::mmap(nullptr, _cqRingSize, PROT_READ | PROT_WRITE,
+				MAP_SHARED | MAP_POPULATE, _fd, IORING_OFF_CQ_RING);
+			if (ring == MAP_FAILED) {
+				PERROR("EgressRing: mmap CQ ring");
+				return false;
+			}
+			_cqRing = ring;
+		}
+		_sqesSize = params.sq_entries * sizeof(struct io_uring_sqe);
+		ring = ::mmap(nullptr, _sqesSize, PROT_READ | PROT_WRITE,
+			MAP_SHARED | MAP_POPULATE, _fd, IORING_OFF_SQES);
+		if (ring == MAP_FAILED) {
+			PERROR("EgressRing: mmap SQEs");
+			return false;
+		}
+		_sqes = static_cast<io_uring_sqe *>(ring);
+
+		unsigned char *sq = static_cast<unsigned char *>(_sqRing);
+		_sqHead = reinterpret_cast<unsigned *>(sq + params.sq_off.head);
+		_sqTail = reinterpret_cast<unsigned *>(sq + params.sq_off.tail);
+		_sqMask = *reinterpret_cast<unsigned *>(sq + params.sq_off.ring_mask);
+		_sqEntries = *reinterpret_cast<unsigned *>(sq + params.sq_off.ring_entries);
+		_sqLocalTail = *_sqTail;
+		// Each queue entry always uses the submission entry with its own index
+		unsigned *array = reinterpret_cast<unsigned *>(sq + params.sq_off.array);
+		for (unsigned i = 0; i < _sqEntries; ++i) {
+			array[i] = i;
+		}
+		unsigned char *cq = static_cast<unsigned char *>(_cqRing);
+		_cqHead = reinterpret_cast<unsigned *>(cq + params.cq_off.head);
+		_cqTail = reinterpret_cast<unsigned *>(cq + params.cq_off.tail);
+		_cqMask = *reinterpret_cast<unsigned *>(cq + params.cq_off.ring_mask);
+		_cqes = reinterpret_cast<io_uring_cqe *>(cq + params.cq_off.cqes);
+
+		// Pinning the packet pool may fail on the memlock limit, then the
+		// writes just use normal buffers
+		struct iovec pool;
+		pool.iov_base = _pool.getMemory();
+		pool.iov_len = _pool.getMemorySize();
+		_fixedBuffers = ::syscall(__NR_io_uring_register, _fd, IORING_REGISTER_BUFFERS, &pool, 1) == 0;
+		if (!_fixedBuffers) {
+			SI_LOG_INFO("EgressRing: Register packet pool failed: %s (check 'ulimit -l')", strerror(errno));
+		}
+		std::vector<int> fds(MAX_FILES, -1);
+		_fixedFiles = ::syscall(__NR_io_uring_register, _fd, IORING_REGISTER_FILES, fds.data(), MAX_FILES) == 0;
+		if (!_fixedFiles) {
+			SI_LOG_INFO("EgressRing: Register file table failed: %s", strerror(errno));
+		}
+
+		_eventFD = ::eventfd(0, EFD_CLOEXEC);
+		if (_eventFD == -1) {
+			PERROR("EgressRing: eventfd");
+			return false;
+		}
+		return true;
+#else
+		SI_LOG_INFO("EgressRing: io_uring not supported by this build");
+		return false;
+#endif
+	}
+
+	void EgressRing::cleanup() {
+		if (_sqes != nullptr) {
+			::munmap(_sqes, _sqesSize);
+			_sqes = nullptr;
+		}
+		if (_cqRing != nullptr && _cqRing != _sqRing) {
+			::munmap(_cqRing, _cqRingSize);
+		}
+		_cqRing = nullptr;
+		if (_sqRing != nullptr) {
+			::munmap(_sqRing, _sqRingSize);
+			_sqRing = nullptr;
+		}
+		CLOSE_FD(_eventFD);
+		CLOSE_FD(_fd);
+	}
+
+	bool EgressRing::registerFile(const int file, int fd) {
+#ifdef HAS_IO_URING
+		struct io_uring_files_update update;
+		std::memset(&update, 0, sizeof(update));
+		update.offset = file;
+		update.fds = static_cast<uint64_t>(reinterpret_cast<uintptr_t>(&fd));
+		if (::syscall(__NR_io_uring_register, _fd, IORING_REGISTER_FILES_UPDATE, &update, 1) != 1) {
+			PERROR("EgressRing: Update file %d with fd %d", file, fd);
+			return false;
+		}
+		return true;
+#else
+		(void)file;
+		(void)fd;
+		return false;
+#endif
+	}
+
+	int EgressRing::enter(const unsigned int toSubmit, const long timeoutMS) {
+#ifdef HAS_IO_URING
+		struct __kernel_timespec ts;
+		ts.tv_sec = timeoutMS / 1000;
+		ts.tv_nsec = (timeoutMS % 1000) * 1000000;
+		struct io_uring_getevents_arg arg;
+		std::memset(&arg, 0, sizeof(arg));
+		arg.ts = static_cast<uint64_t>(reinterpret_cast<uintptr_t>(&ts));
+		return ::syscall(__NR_io_uring_enter, _fd, toSubmit, 1,
+			IORING_ENTER_GETEVENTS | IORING_ENTER_EXT_ARG, &arg, sizeof(arg));
+#else
+		(void)toSubmit;
+		(void)timeoutMS;
+		errno = ENOSYS;
+		return -1;
+#endif
+	}
+
+	unsigned int EgressRing::getFreeEntries() const {
+		const unsigned used = _sqLocalTail - __atomic_load_n(_sqHead, __ATOMIC_ACQUIRE);
+		return (used + 1 < _sqEntries) ? _sqEntries - used - 1 : 0;
+	}
+
+	io_uring_sqe *EgressRing::getSubmissionEntry(const int file) {
+#ifdef HAS_IO_URING
+		if (file != -1 && getFreeEntries() == 0) {
+			return nullptr;
+		} else if (_sqLocalTail - __atomic_load_n(_sqHead, __ATOMIC_ACQUIRE) >= _sqEntries) {
+			return nullptr;
+		}
+		io_uring_sqe *sqe = &_sqes[_sqLocalTail & _sqMask];
+		++_sqLocalTail;
+		std::memset(sqe, 0, sizeof(*sqe));
+		if (file != -1) {
+			if (_fixedFiles) {
+				sqe->fd = file;
+				sqe->flags = IOSQE_FIXED_FILE;
+			} else {
+				sqe->fd = _files[file].fd;
+			}
+		}
+		return sqe;
+#else
+		(void)file;
+		return nullptr;
+#endif
+	}
+
+	std::size_t EgressRing::holdRequest(const int file,
+			mpegts::PacketBuffer *const *buffers, const std::size_t n) {
+		const std::size_t id = _freeRequest.back();
+		_freeRequest.pop_back();
+		Request &request = _request[id];
+		request.file = file;
+		request.segmented = false;
+		request.len = 0;
+		request.n = n;
+		for (std::size_t i = 0; i < n; ++i) {
+			_pool.addRef(buffers[i]);
+			request.buffers[i] = buffers[i];
+		}
+		_files[file].held += n;
+		++_files[file].inFlight;
+		++_inFlight;
+		++_requests;
+		return id;
+	}
+
+	bool EgressRing::commit() {
+		__atomic_store_n(_sqTail, _sqLocalTail, __ATOMIC_RELEASE);
+		if (_idle) {
+			_idle = false;
+			return true;
+		}
+		return false;
+	}
+
+	void EgressRing::armWakeUp() {
+#ifdef HAS_IO_URING
+		io_uring_sqe *sqe = getSubmissionEntry(-1);
+		if (sqe == nullptr) {
+			return;
+		}
+		sqe->opcode = IORING_OP_READ;
+		sqe->fd = _eventFD;
+		sqe->addr = static_cast<uint64_t>(reinterpret_cast<uintptr_t>(&_eventValue));
+		sqe->len = sizeof(_eventValue);
+		sqe->user_data = WAKE_UP_ID;
+		__atomic_store_n(_sqTail, _sqLocalTail, __ATOMIC_RELEASE);
+		_wakeArmed = true;
+#endif
+	}
+
+	void EgressRing::wakeUp() {
+		if (::eventfd_write(_eventFD, 1) == -1) {
+			PERROR("EgressRing: eventfd_write");
+		}
+	}
+
+	void EgressRing::reapCompletions() {
+#ifdef HAS_IO_URING
+		base::MutexLock lock(_mutex);
+		_idle = false;
+		unsigned head = *_cqHead;
+		const unsigned tail = __atomic_load_n(_cqTail, __ATOMIC_ACQUIRE);
+		for (; head != tail; ++head) {
+			const io_uring_cqe &cqe = _cqes[head & _cqMask];
+			if (cqe.user_data == WAKE_UP_ID) {
+				_wakeArmed = false;
+			} else {
+				complete(cqe.user_data, cqe.res);
+			}
+		}
+		__atomic_store_n(_cqHead, head, __ATOMIC_RELEASE);
+#endif
+	}
+
+	void EgressRing::complete(const std::size_t id, int result) {
+		Request &request = _request[id];
+		File &file = _files[request.file];
+		if (result >= 0 && static_cast<std::size_t>(result) != request.len) {
+			result = -EIO;
+		}
+		if (result < 0 && file.error == 0) {
+			file.error = -result;
+			file.segmented = request.segmented;
+		}
+		for (std::size_t i = 0; i < request.n; ++i) {
+			_pool.release(request.buffers[i]);
+		}
+		file.held -= request.n;
+		--file.inFlight;
+		--_inFlight;
+		_freeRequest.push_back(id);
+	}
+
+	int EgressRing::addFile(const int fd) {
+		base::MutexLock lock(_mutex);
+		if (_fd == -1 || fd == -1) {
+			return -1;
+		}
+		for (int i = 0; i < MAX_FILES; ++i) {
+			File &file = _files[i];
+			if (file.fd != -1) {
+				continue;
+			}
+			if (_fixedFiles && !registerFile(i, fd)) {
+				return -1;
+			}
+			file.fd = fd;
+			file.held = 0;
+			file.inFlight = 0;
+			file.error = 0;
+			file.segmented = false;
+			SI_LOG_DEBUG("EgressRing: Added fd: %d as file %d", fd, i);
+			return i;
+		}
+		SI_LOG_ERROR("EgressRing: No free file for fd: %d", fd);
+		return -1;
+	}
+
+	void EgressRing::removeFile(const int file) {
+		if (file < 0 || file >= MAX_FILES) {
+			return;
+		}
+		for (;;) {
+			{
+				base::MutexLock lock(_mutex);
+				File &f = _files[file];
+				if (f.inFlight == 0) {
+					if (_fixedFiles) {
+						registerFile(file, -1);
+					}
+					SI_LOG_DEBUG("EgressRing: Removed fd: %d of file %d", f.fd, file);
+					f.fd = -1;
+					return;
+				}
+			}
+			std::this_thread::sleep_for(std::chrono::milliseconds(1));
+		}
+	}
+
+	bool EgressRing::sendTo(
+			const int file,
+			const struct sockaddr_in &addr,
+			const struct iovec *iov,
+			const std::size_t iovcnt,
+			const uint16_t segmentSize,
+			mpegts::PacketBuffer *const *buffers,
+			const std::size_t n) {
+#ifdef HAS_IO_URING
+		bool wake;
+		{
+			base::MutexLock lock(_mutex);
+			if (file < 0 || file >= MAX_FILES || _files[file].fd == -1 ||
+					iovcnt > MAX_REQUEST_BUF || n > MAX_REQUEST_BUF ||
+					_files[file].held + n > MAX_HELD_BUF || _freeRequest.empty()) {
+				++_rejected;
+				return false;
+			}
+			io_uring_sqe *sqe = getSubmissionEntry(file);
+			if (sqe == nullptr) {
+				++_rejected;
+				return false;
+			}
+			const std::size_t id = holdRequest(file, buffers, n);
+			Request &request = _request[id];
+			request.addr = addr;
+			std::memset(&request.msg, 0, sizeof(request.msg));
+			request.msg.msg_name = &request.addr;
+			request.msg.msg_namelen = sizeof(request.addr);
+			request.msg.msg_iov = request.iov;
+			request.msg.msg_iovlen = iovcnt;
+			for (std::size_t i = 0; i < iovcnt; ++i) {
+				request.iov[i] = iov[i];
+				request.len += iov[i].iov_len;
+			}
+			if (segmentSize != 0) {
+				std::memset(request.control, 0, sizeof(request.control));
+				request.msg.msg_control = request.control;
+				request.msg.msg_controllen = sizeof(request.control);
+				struct cmsghdr *cmsg = CMSG_FIRSTHDR(&request.msg);
+				cmsg->cmsg_level = SOL_UDP;
+				cmsg->cmsg_type = UDP_SEGMENT;
+				cmsg->cmsg_len = CMSG_LEN(sizeof(uint16_t));
+				std::memcpy(CMSG_DATA(cmsg), &segmentSize, sizeof(uint16_t));
+				request.segmented = true;
+			}
+			sqe->opcode = IORING_OP_SENDMSG;
+			sqe->addr = static_cast<uint64_t>(reinterpret_cast<uintptr_t>(&request.msg));
+			sqe->len = 1;
+			sqe->user_data = id;
+			wake = commit();
+		}
+		if (wake) {
+			wakeUp();
+		}
+		return true;
+#else
+		(void)file;
+		(void)addr;
+		(void)iov;
+		(void)iovcnt;
+		(void)segmentSize;
+		(void)buffers;
+		(void)n;
+		return false;
+#endif
+	}
+
+	bool EgressRing::writeTo(
+			const int file,
+			const off_t offset,
+			mpegts::PacketBuffer *const *buffers,
+			const std::size_t n) {
+#ifdef HAS_IO_URING
+		static constexpr std::size_t dataSize = mpegts::PacketBuffer::getBufferSize();
+		bool wake;
+		{
+			base::MutexLock lock(_mutex);
+			if (file < 0 || file >= MAX_FILES || _files[file].fd == -1 ||
+					_files[file].held + n > MAX_HELD_BUF || _freeRequest.size() < n ||
+					getFreeEntries() < n) {
+				++_rejected;
+				return false;
+			}
+			// One write for each buffer, so it can be from the fixed buffer
+			for (std::size_t i = 0; i < n; ++i) {
+				io_uring_sqe *sqe = getSubmissionEntry(file);
+				const std::size_t id = holdRequest(file, &buffers[i], 1);
+				_request[id].len = dataSize;
+				sqe->opcode = _fixedBuffers ? IORING_OP_WRITE_FIXED : IORING_OP_WRITE;
+				sqe->addr = static_cast<uint64_t>(reinterpret_cast<uintptr_t>(buffers[i]->getTSReadBufferPtr()));
+				sqe->len = dataSize;
+				sqe->off = offset + (i * dataSize);
+				sqe->buf_index = 0;
+				sqe->user_data = id;
+			}
+			wake = commit();
+		}
+		if (wake) {
+			wakeUp();
+		}
+		return true;
+#else
+		(void)file;
+		(void)offset;
+		(void)buffers;
+		(void)n;
+		return false;
+#endif
+	}
+
+	int EgressRing::getError(const int file, bool &segmented) {
+		base::MutexLock lock(_mutex);
+		if (file < 0 || file >= MAX_FILES) {
+			return 0;
+		}
+		File &f = _files[file];
+		const int error = f.error;
+		segmented = f.segmented;
+		f.error = 0;
+		f.segmented = false;
+		return error;
+	}
+
+} // namespace output
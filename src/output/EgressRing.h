@@ -0,0 +1,265 @@
+/* EgressRing.h
+
+   Copyright (C) 2014 - 2020 Marc Postema (mpostema09 -at- gmail.com)
+
+   This program is free software; you can redistribute it and/or
+   modify it under the terms of the GNU General Public License
+   as published by the Free Software Foundation; either version 2
+   of the License, or (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program; if not, write to the Free Software
+   Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+   Or, point your browser to http://www.gnu.org/copyleft/gpl.html
+*/
+#ifndef OUTPUT_EGRESS_RING_H_INCLUDE
+#define OUTPUT_EGRESS_RING_H_INCLUDE OUTPUT_EGRESS_RING_H_INCLUDE
+
+#include <FwDecl.h>
+#include <base/Mutex.h>
+#include <base/ThreadBase.h>
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <sys/types.h>
+#include <sys/uio.h>
+
+FW_DECL_NS1(mpegts, PacketBuffer);
+FW_DECL_NS1(mpegts, PacketPool);
+
+FW_DECL_UP_NS1(output, EgressRing);
+
+struct io_uring_sqe;
+struct io_uring_cqe;
+
+namespace output {
+
+/// The class @c EgressRing sends the data of all stream threads with one
+/// io_uring. The stream threads only queue their sends, this thread submits
+/// them for all streams with one system call and reaps the completions.
+/// The sends point into the packet pool, its buffers are kept until the
+/// kernel completed the send. The packet pool is registered as fixed buffer
+/// and the sockets and files as fixed files, when the kernel allows it.
+class EgressRing :
+	public base::ThreadBase {
+		// =====================================================================
+		//  -- Constructors and destructor -------------------------------------
+		// =====================================================================
+	public:
+
+		/// @param pool specifies the packet pool all send buffers are from
+		explicit EgressRing(mpegts::PacketPool &pool);
+
+		virtual ~EgressRing();
+
+		// =====================================================================
+		//  -- base::ThreadBase ------------------------------------------------
+		// =====================================================================
+	protected:
+
+		/// @see ThreadBase
+		virtual void threadEntry() final;
+
+		// =====================================================================
+		//  -- Other member functions ------------------------------------------
+		// =====================================================================
+	public:
+
+		/// Check if the kernel has io_uring and the ring is set up
+		bool isAvailable() const {
+			return _fd != -1;
+		}
+
+		/// Add the socket or file fd to the ring
+		/// @return the index to send with or -1 if the ring is full
+		int addFile(int fd);
+
+		/// Wait until all sends of file are completed and remove it from
+		/// the ring. The fd may be closed after this.
+		void removeFile(int file);
+
+		/// Queue the send of one datagram, or of several datagrams with
+		/// UDP GSO when segmentSize is not 0
+		/// @param iov specifies the data, it should point into buffers
+		/// @param buffers specifies the pool buffers iov points to
+		/// @return false if it could not be queued, because the ring or the
+		/// buffers kept for this file are full
+		bool sendTo(int file, const struct sockaddr_in &addr,
+			const struct iovec *iov, std::size_t iovcnt, uint16_t segmentSize,
+			mpegts::PacketBuffer *const *buffers, std::size_t n);
+
+		/// Queue the write of the TS packets of the buffers to file, one
+		/// after the other starting at offset
+		/// @return false if it could not be queued, because the ring or the
+		/// buffers kept for this file are full
+		bool writeTo(int file, off_t offset, mpegts::PacketBuffer *const *buffers,
+			std::size_t n);
+
+		/// Get and clear the first error of the completed sends of file
+		/// @param segmented is set if the failed send was an UDP GSO send
+		/// @return the errno of the failed send or 0
+		int getError(int file, bool &segmented);
+
+		/// Get the amount of system calls that submitted sends
+		unsigned long getSubmits() const {
+			return _submits;
+		}
+
+		/// Get the amount of sends and writes submitted
+		unsigned long getRequests() const {
+			return _requests;
+		}
+
+		/// Get the amount of sends and writes that could not be queued
+		unsigned long getRejected() const {
+			return _rejected;
+		}
+
+		/// Check if the packet pool is registered as fixed buffer
+		bool hasFixedBuffers() const {
+			return _fixedBuffers;
+		}
+
+		/// Check if the sockets and files are registered as fixed files
+		bool hasFixedFiles() const {
+			return _fixedFiles;
+		}
+
+	private:
+
+		/// Map the rings and register the packet pool and the file table
+		bool setup();
+
+		/// Unmap the rings and close the io_uring
+		void cleanup();
+
+		/// Set the fd of a file in the table of fixed files
+		bool registerFile(int file, int fd);
+
+		/// Submit the queued entries and wait for a completion
+		/// @return the amount of entries submitted or -1 on error
+		int enter(unsigned int toSubmit, long timeoutMS);
+
+		/// Get the amount of free submission queue entries for requests,
+		/// one stays free for @see armWakeUp. _mutex should be locked.
+		unsigned int getFreeEntries() const;
+
+		/// Get a free submission queue entry for file, or for the eventfd
+		/// when file is -1. @see commit should be called after filling it.
+		/// _mutex should be locked.
+		io_uring_sqe *getSubmissionEntry(int file);
+
+		/// Get a free request for file and keep its buffers
+		/// _mutex should be locked.
+		std::size_t holdRequest(int file, mpegts::PacketBuffer *const *buffers,
+			std::size_t n);
+
+		/// Make the filled submission queue entries visible to the kernel
+		/// and wake this thread if it is idle. _mutex should be locked.
+		/// @return true if this thread should be woken up
+		bool commit();
+
+		/// Queue the read of the eventfd that wakes this thread up.
+		/// _mutex should be locked.
+		void armWakeUp();
+
+		/// Wake this thread up, when it waits for completions
+		void wakeUp();
+
+		/// Release the buffers of the completed sends and note the errors
+		void reapCompletions();
+
+		/// Release the request with id, after its completion with result.
+		/// _mutex should be locked.
+		void complete(std::size_t id, int result);
+
+		// =====================================================================
+		// -- Data members -----------------------------------------------------
+		// =====================================================================
+	public:
+
+		/// Max buffers kept for the sends of one file, the packet pool has
+		/// these extra for each stream
+		static constexpr std::size_t MAX_HELD_BUF = 128;
+
+	private:
+
+		/// Max buffers in one request, a GSO send of 64 KB needs 49
+		static constexpr std::size_t MAX_REQUEST_BUF = 64;
+		static constexpr unsigned int RING_ENTRIES = 512;
+		static constexpr int MAX_FILES = 256;
+		/// Max msec sends wait in the submission queue, while the sends in
+		/// flight are not completed yet
+		static constexpr long SUBMIT_INTERVAL_MS = 1;
+
+		/// A queued send or write, it keeps the pool buffers until completed
+		struct Request {
+			int file;
+			bool segmented;                /// UDP GSO send
+			std::size_t len;               /// bytes to send
+			struct msghdr msg;
+			struct sockaddr_in addr;
+			struct iovec iov[MAX_REQUEST_BUF];
+			char control[CMSG_SPACE(sizeof(uint16_t))];
+			mpegts::PacketBuffer *buffers[MAX_REQUEST_BUF];
+			std::size_t n;
+		};
+
+		/// A socket or file added to the ring
+		struct File {
+			int fd;                        /// -1 if not used
+			std::size_t held;              /// buffers kept by requests in flight
+			std::size_t inFlight;          /// requests in flight
+			int error;                     /// errno of the first failed request
+			bool segmented;                /// the failed request was an UDP GSO send
+		};
+
+		base::Mutex _mutex;
+		mpegts::PacketPool &_pool;
+		int _fd;
+		int _eventFD;
+		uint64_t _eventValue;
+		bool _wakeArmed;
+		bool _idle;                        /// this thread waits for a wake up
+		bool _fixedBuffers;
+		bool _fixedFiles;
+
+		void *_sqRing;
+		std::size_t _sqRingSize;
+		void *_cqRing;
+		std::size_t _cqRingSize;
+		io_uring_sqe *_sqes;
+		std::size_t _sqesSize;
+		unsigned *_sqHead;
+		unsigned *_sqTail;
+		unsigned _sqMask;
+		unsigned _sqEntries;
+		unsigned _sqLocalTail;             /// tail including not committed entries
+		unsigned *_cqHead;
+		unsigned *_cqTail;
+		unsigned _cqMask;
+		io_uring_cqe *_cqes;
+
+		std::vector<Request> _request;
+		std::vector<std::size_t> _freeRequest;
+		std::size_t _inFlight;
+		std::vector<File> _files;
+
+		std::atomic<unsigned long> _submits;
+		std::atomic<unsigned long> _requests;
+		std::atomic<unsigned long> _rejected;
+};
+
+} // namespace output
+
+#endif // OUTPUT_EGRESS_RING_H_INCLUDE
@@ -0,0 +1,205 @@
+/* Pacer.cpp
+
+   Copyright (C) 2014 - 2020 Marc Postema (mpostema09 -at- gmail.com)
+
+   This program is free software; you can redistribute it and/or
+   modify it under the terms of the GNU General Public License
+   as published by the Free Software Foundation; either version 2
+   of the License, or (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program; if not, write to the Free Software
+   Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+   Or, point your browser to http://www.gnu.org/copyleft/gpl.html
+ */
+#include <output/Pacer.h>
+
+#include <mpegts/PacketBuffer.h>
+#include <mpegts/PCR.h>
+
+#include <cerrno>
+
+#include <time.h>
+
+namespace output {
+
+	// PCR wraps at 2^33 * 300 ticks of 27 MHz
+	static constexpr std::uint64_t PCR_WRAP = (1ULL << 33) * 300;
+	static constexpr std::uint64_t PCR_MAX_DELTA = 27000000 / 2;
+	static constexpr std::int64_t NSEC = 1000000000;
+	static constexpr std::int64_t MAX_WAIT = NSEC / 20;
+	static constexpr std::int64_t PCR_TIMEOUT = NSEC;
+	static constexpr std::int64_t BYTE_RATE_WINDOW = NSEC;
+	static constexpr double CATCH_UP_FACTOR = 1.25;
+
+	// =========================================================================
+	// -- Constructors and destructor ------------------------------------------
+	// =========================================================================
+
+	Pacer::Pacer(const std::size_t capacity) :
+		_capacity(capacity),
+		_burst(0),
+		_latencyNS(0),
+		_tNext(0),
+		_rate(0.0),
+		_pcrPID(-1),
+		_pcrPrev(0),
+		_pcrBytes(0),
+		_tLastPCR(0),
+		_windowBytes(0),
+		_tWindow(0),
+		_bitrateKbps(0),
+		_jitterUS(0),
+		_maxJitterUS(0) {}
+
+	Pacer::~Pacer() {}
+
+	// =========================================================================
+	// -- Static member functions ----------------------------------------------
+	// =========================================================================
+
+	std::int64_t Pacer::now() {
+		struct timespec ts;
+		clock_gettime(CLOCK_MONOTONIC, &ts);
+		return (ts.tv_sec * NSEC) + ts.tv_nsec;
+	}
+
+	void Pacer::sleepUntil(const std::int64_t t) {
+		struct timespec ts;
+		ts.tv_sec  = t / NSEC;
+		ts.tv_nsec = t % NSEC;
+		while (::clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, nullptr) == EINTR) {}
+	}
+
+	std::int64_t Pacer::duration(const std::size_t bytes, const double rate) {
+		return static_cast<std::int64_t>((bytes * 8 * NSEC) / rate);
+	}
+
+	// =========================================================================
+	// -- Other member functions -----------------------------------------------
+	// =========================================================================
+
+	void Pacer::reset(const unsigned int burst, const unsigned int latencyMS) {
+		_burst = burst;
+		_latencyNS = latencyMS * (NSEC / 1000);
+		_tNext = now();
+		_rate = 0.0;
+		_pcrPID = -1;
+		_pcrBytes = 0;
+		_tLastPCR = 0;
+		_windowBytes = 0;
+		_tWindow = _tNext;
+		_bitrateKbps = 0;
+		_jitterUS = 0;
+		_maxJitterUS = 0;
+	}
+
+	bool Pacer::waitForRelease() {
+		if (_burst == 0 || _rate <= 0.0) {
+			return true;
+		}
+		const std::int64_t t = now();
+		// Do not save up more credit than the burst limit, so falling behind
+		// the schedule does not result in a large burst
+		const std::int64_t credit = duration(mpegts::PacketBuffer::getBufferSize(), _rate) * _burst;
+		if (_tNext < t - credit) {
+			_tNext = t - credit;
+		}
+		if (_tNext <= t) {
+			return true;
+		}
+		if (_tNext - t > MAX_WAIT) {
+			// Do not sleep too long, so the caller stays responsive
+			sleepUntil(t + MAX_WAIT);
+			return false;
+		}
+		sleepUntil(_tNext);
+		const long late = (now() - _tNext) / 1000;
+		const long jitter = _jitterUS;
+		_jitterUS = jitter + ((late - jitter) / 16);
+		if (static_cast<unsigned long>(late) > _maxJitterUS) {
+			_maxJitterUS = late;
+		}
+		return true;
+	}
+
+	void Pacer::released(const mpegts::PacketBuffer &buffer, const std::size_t queued) {
+		const std::int64_t t = now();
+		for (std::size_t i = 0; i < mpegts::PacketBuffer::getNumberOfTSPackets(); ++i) {
+			estimateFromPCR(buffer.getTSPacketPtr(i), t);
+		}
+		const std::size_t bytes = mpegts::PacketBuffer::getBufferSize();
+		estimateFromByteRate(bytes, t);
+
+		if (_burst == 0 || _rate <= 0.0) {
+			_tNext = t;
+			return;
+		}
+		// When more is queued than the latency target (or half of the
+		// capacity), send faster to catch up
+		double rate = _rate;
+		if (static_cast<std::int64_t>(queued) * duration(bytes, _rate) > _latencyNS ||
+				queued * 2 > _capacity) {
+			rate *= CATCH_UP_FACTOR;
+		}
+		_tNext += duration(bytes, rate);
+	}
+
+	void Pacer::estimateFromPCR(const unsigned char *ts, const std::int64_t t) {
+		_pcrBytes += mpegts::PacketBuffer::TS_PACKET_SIZE;
+		std::uint64_t pcr;
+		if (!mpegts::PCR::getPCR(ts, pcr)) {
+			return;
+		}
+		const int pid = ((ts[1] & 0x1f) << 8) | ts[2];
+		if (_pcrPID != pid) {
+			// Use the first PID with PCR, or switch when it is gone
+			if (_pcrPID != -1 && t - _tLastPCR < PCR_TIMEOUT) {
+				return;
+			}
+			_pcrPID = pid;
+			_pcrPrev = pcr;
+			_pcrBytes = 0;
+			_tLastPCR = t;
+			return;
+		}
+		const std::uint64_t delta = (pcr + PCR_WRAP - _pcrPrev) % PCR_WRAP;
+		if (delta > 0 && delta <= PCR_MAX_DELTA) {
+			// bytes between the PCRs in 27 MHz ticks gives the bitrate
+			updateRate((_pcrBytes * 8 * 27000000.0) / delta, 16);
+			_tLastPCR = t;
+		}
+		// On a discontinuity just restart the measurement
+		_pcrPrev = pcr;
+		_pcrBytes = 0;
+	}
+
+	void Pacer::estimateFromByteRate(const std::size_t bytes, const std::int64_t t) {
+		_windowBytes += bytes;
+		const std::int64_t elapsed = t - _tWindow;
+		if (elapsed < BYTE_RATE_WINDOW) {
+			return;
+		}
+		// Only use the byte rate if there is no recent PCR measurement
+		if (_pcrPID == -1 || t - _tLastPCR > PCR_TIMEOUT) {
+			updateRate((_windowBytes * 8.0 * NSEC) / elapsed, 2);
+		}
+		_windowBytes = 0;
+		_tWindow = t;
+	}
+
+	void Pacer::updateRate(const double rate, const unsigned int weight) {
+		if (_rate <= 0.0) {
+			_rate = rate;
+		} else {
+			_rate += (rate - _rate) / weight;
+		}
+		_bitrateKbps = _rate / 1000;
+	}
+
+} // namespace output
@@ -0,0 +1,138 @@
+/* Pacer.h
+
+   Copyright (C) 2014 - 2020 Marc Postema (mpostema09 -at- gmail.com)
+
+   This program is free software; you can redistribute it and/or
+   modify it under the terms of the GNU General Public License
+   as published by the Free Software Foundation; either version 2
+   of the License, or (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program; if not, write to the Free Software
+   Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+   Or, point your browser to http://www.gnu.org/copyleft/gpl.html
+*/
+#ifndef OUTPUT_PACER_H_INCLUDE
+#define OUTPUT_PACER_H_INCLUDE OUTPUT_PACER_H_INCLUDE
+
+#include <FwDecl.h>
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+FW_DECL_NS1(mpegts, PacketBuffer);
+
+namespace output {
+
+/// The class @c Pacer releases the buffers of a stream on an absolute time
+/// schedule following the stream bitrate, instead of sending them in bursts
+/// as they are read from the input device. The bitrate is estimated from the
+/// PCR, or from the send byte rate if the stream has no (filtered) PCR.
+class Pacer {
+		// =====================================================================
+		//  -- Constructors and destructor -------------------------------------
+		// =====================================================================
+	public:
+
+		/// @param capacity specifies the amount of buffers that can be queued
+		explicit Pacer(std::size_t capacity);
+
+		virtual ~Pacer();
+
+		// =====================================================================
+		//  -- Other member functions ------------------------------------------
+		// =====================================================================
+	public:
+
+		/// Reset the bitrate estimation and schedule
+		/// @param burst specifies the max buffers that are send back-to-back
+		/// to catch up with the schedule, 0 disables pacing
+		/// @param latencyMS specifies the max time a buffer should be queued
+		void reset(unsigned int burst, unsigned int latencyMS);
+
+		/// Change the max buffers that are send back-to-back, but keep the
+		/// bitrate estimation and schedule
+		/// @param burst specifies the max buffers, 0 disables pacing
+		void setBurst(unsigned int burst) {
+			_burst = burst;
+		}
+
+		/// Wait until the next buffer may be send
+		/// @return true if the buffer may be send now, false if the wait is
+		/// not finished yet and this function should be called again
+		bool waitForRelease();
+
+		/// The buffer is send, update the bitrate estimation and schedule the
+		/// next buffer
+		/// @param buffer specifies the buffer that was send
+		/// @param queued specifies the amount of buffers waiting to be send
+		void released(const mpegts::PacketBuffer &buffer, std::size_t queued);
+
+		/// Get the estimated bitrate in kbit/s
+		unsigned long getBitrate() const {
+			return _bitrateKbps;
+		}
+
+		/// Get the average lateness of a paced release in usec
+		unsigned long getJitter() const {
+			return _jitterUS;
+		}
+
+		/// Get the max lateness of a paced release in usec
+		unsigned long getMaxJitter() const {
+			return _maxJitterUS;
+		}
+
+	private:
+
+		/// Get the monotonic time in nsec
+		static std::int64_t now();
+
+		/// Sleep until the monotonic time t in nsec
+		static void sleepUntil(std::int64_t t);
+
+		/// Get the time in nsec it takes to send bytes with rate (bit/s)
+		static std::int64_t duration(std::size_t bytes, double rate);
+
+		/// Estimate the bitrate from the PCR of the TS packet
+		void estimateFromPCR(const unsigned char *ts, std::int64_t t);
+
+		/// Estimate the bitrate from the send bytes
+		void estimateFromByteRate(std::size_t bytes, std::int64_t t);
+
+		/// Add a new bitrate measurement to the moving average
+		void updateRate(double rate, unsigned int weight);
+
+		// =====================================================================
+		// -- Data members -----------------------------------------------------
+		// =====================================================================
+	private:
+
+		std::size_t _capacity;
+		unsigned int _burst;
+		std::int64_t _latencyNS;
+		std::int64_t _tNext;           /// scheduled release of the next buffer
+		double _rate;                  /// estimated bitrate in bit/s, 0 unknown
+
+		int _pcrPID;                   /// PID used for estimation, -1 none yet
+		std::uint64_t _pcrPrev;        /// last PCR in 27 MHz ticks
+		std::size_t _pcrBytes;         /// bytes since the last PCR
+		std::int64_t _tLastPCR;        /// time of the last PCR estimation
+
+		std::size_t _windowBytes;      /// bytes send in the current window
+		std::int64_t _tWindow;         /// begin of the current window
+
+		std::atomic<unsigned long> _bitrateKbps;
+		std::atomic<unsigned long> _jitterUS;
+		std::atomic<unsigned long> _maxJitterUS;
+};
+
+} // namespace output
+
+#endif // OUTPUT_PACER_H_INCLUDE
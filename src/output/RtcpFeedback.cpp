@@ -0,0 +1,194 @@
+/* RtcpFeedback.cpp
+
+   Copyright (C) 2014 - 2020 Marc Postema (mpostema09 -at- gmail.com)
+
+   This program is free software; you can redistribute it and/or
+   modify it under the terms of the GNU General Public License
+   as published by the Free Software Foundation; either version 2
+   of the License, or (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program; if not, write to the Free Software
+   Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+   Or, point your browser to http://www.gnu.org/copyleft/gpl.html
+*/
+#include <output/RtcpFeedback.h>
+
+#include <base/TimeCounter.h>
+
+namespace output {
+
+	/// Get the 16 bit value in network byte order at data
+	static uint16_t get16(const uint8_t *data) {
+		return (data[0] << 8) | data[1];
+	}
+
+	/// Get the 32 bit value in network byte order at data
+	static uint32_t get32(const uint8_t *data) {
+		return (static_cast<uint32_t>(data[0]) << 24) | (data[1] << 16) | (data[2] << 8) | data[3];
+	}
+
+	// =========================================================================
+	//  -- Constructors and destructor -----------------------------------------
+	// =========================================================================
+
+	RtcpFeedback::RtcpFeedback() {
+		reset();
+	}
+
+	RtcpFeedback::~RtcpFeedback() {}
+
+	// =========================================================================
+	//  -- Other member functions ----------------------------------------------
+	// =========================================================================
+
+	void RtcpFeedback::reset() {
+		_reports = 0;
+		_extendedReports = 0;
+		_nacks = 0;
+		_fractionLost = 0;
+		_cumulativeLost = 0;
+		_jitterUS = 0;
+		_rttUS = 0;
+		_congested = false;
+	}
+
+	bool RtcpFeedback::parse(const uint8_t *data, const std::size_t len,
+			const uint32_t ssrc, const unsigned int lossThreshold,
+			std::vector<uint16_t> &nacked) {
+		nacked.clear();
+		const unsigned long reports = _reports;
+		std::size_t offset = 0;
+		while (offset + 8 <= len) {
+			const uint8_t *packet = data + offset;
+			// version: 2
+			if ((packet[0] >> 6) != 2) {
+				break;
+			}
+			const std::size_t count = packet[0] & 0x1f;
+			const std::size_t size = (get16(packet + 2) + 1) * 4;
+			if (offset + size > len) {
+				break;
+			}
+			std::size_t blocks = 0;
+			switch (packet[1]) {
+				case 200:                  // SR, report blocks after the sender info
+					blocks = 28;
+					break;
+				case 201:                  // RR
+					blocks = 8;
+					break;
+				case 205:                  // RTPFB, Generic NACK has FMT 1
+					if (count == 1) {
+						parseNack(packet + 8, size - 8, ssrc, nacked);
+					}
+					break;
+				case 207:                  // XR
+					++_extendedReports;
+					parseExtendedReport(packet + 8, size - 8, ssrc);
+					break;
+				default:
+					break;
+			}
+			if (blocks != 0) {
+				for (std::size_t i = 0; i < count &&
+						blocks + (i + 1) * REPORT_BLOCK_LEN <= size; ++i) {
+					const uint8_t *block = packet + blocks + i * REPORT_BLOCK_LEN;
+					if (get32(block) == ssrc) {
+						parseReportBlock(block);
+					}
+				}
+			}
+			offset += size;
+		}
+		if (_reports == reports) {
+			return false;
+		}
+		// Recover at half the threshold, so it does not toggle around it
+		const bool congested = _congested ?
+			(lossThreshold != 0 && _fractionLost * 2 >= lossThreshold) :
+			(lossThreshold != 0 && _fractionLost >= lossThreshold);
+		if (congested == _congested) {
+			return false;
+		}
+		_congested = congested;
+		return true;
+	}
+
+	void RtcpFeedback::parseReportBlock(const uint8_t *block) {
+		++_reports;
+		_fractionLost = (block[4] * 100) / 256;
+		// cumulative number of packets lost is a signed 24 bit value
+		long lost = (block[5] << 16) | (block[6] << 8) | block[7];
+		if (lost & 0x800000) {
+			lost -= 0x1000000;
+		}
+		_cumulativeLost = lost;
+		// interarrival jitter in 90 kHz timestamp units
+		_jitterUS = (static_cast<unsigned long>(get32(block + 12)) * 100) / 9;
+
+		// round trip time from the last SR (middle 32 bits of its NTP
+		// timestamp) and the delay since that SR, in 1/65536 sec
+		const uint32_t lsr = get32(block + 16);
+		const uint32_t dlsr = get32(block + 20);
+		if (lsr != 0) {
+			const uint64_t ntp = base::TimeCounter::getNtpTimestamp(
+				base::TimeCounter::getMonotonicMicros());
+			const uint32_t rtt = static_cast<uint32_t>(ntp >> 16) - lsr - dlsr;
+			// A negative round trip (clock of the report is off) is skipped
+			if (rtt < 0x80000000u) {
+				_rttUS = (static_cast<uint64_t>(rtt) * 1000000) >> 16;
+			}
+		}
+	}
+
+	void RtcpFeedback::parseExtendedReport(const uint8_t *data, const std::size_t len,
+			const uint32_t ssrc) {
+		std::size_t offset = 0;
+		while (offset + 4 <= len) {
+			const uint8_t *block = data + offset;
+			const std::size_t size = (get16(block + 2) + 1) * 4;
+			if (offset + size > len) {
+				break;
+			}
+			// Statistics Summary Report Block (RFC 3611), loss and jitter
+			// flags tell which fields are valid
+			if (block[0] == 6 && size >= 40 && get32(block + 4) == ssrc) {
+				if (block[1] & 0x80) {
+					_cumulativeLost = get32(block + 12);
+				}
+				if (block[1] & 0x20) {
+					_jitterUS = (static_cast<unsigned long>(get32(block + 28)) * 100) / 9;
+				}
+			}
+			offset += size;
+		}
+	}
+
+	void RtcpFeedback::parseNack(const uint8_t *data, const std::size_t len,
+			const uint32_t ssrc, std::vector<uint16_t> &nacked) {
+		// SSRC of the media source, then the FCI entries: the PID of a lost
+		// packet and a bitmask (BLP) of the lost packets following it
+		if (len < 4 || get32(data) != ssrc) {
+			return;
+		}
+		const std::size_t requested = nacked.size();
+		for (std::size_t offset = 4; offset + 4 <= len; offset += 4) {
+			const uint16_t pid = get16(data + offset);
+			const uint16_t blp = get16(data + offset + 2);
+			nacked.push_back(pid);
+			for (unsigned int i = 0; i < 16; ++i) {
+				if (blp & (1 << i)) {
+					nacked.push_back(pid + i + 1);
+				}
+			}
+		}
+		_nacks += nacked.size() - requested;
+	}
+
+} // namespace output
@@ -0,0 +1,144 @@
+/* RtcpFeedback.h
+
+   Copyright (C) 2014 - 2020 Marc Postema (mpostema09 -at- gmail.com)
+
+   This program is free software; you can redistribute it and/or
+   modify it under the terms of the GNU General Public License
+   as published by the Free Software Foundation; either version 2
+   of the License, or (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program; if not, write to the Free Software
+   Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+   Or, point your browser to http://www.gnu.org/copyleft/gpl.html
+*/
+#ifndef OUTPUT_RTCP_FEEDBACK_H_INCLUDE
+#define OUTPUT_RTCP_FEEDBACK_H_INCLUDE OUTPUT_RTCP_FEEDBACK_H_INCLUDE
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace output {
+
+/// The class @c RtcpFeedback reads the RTCP reports (RR, SR and XR) a client
+/// sends back, and keeps the loss, jitter and round trip time it reports
+/// about the stream. From the loss it decides if the client is congested,
+/// so the output can adapt to it. The packets the client reports lost with
+/// a Generic NACK (RFC 4585) are handed to the caller.
+class RtcpFeedback {
+	public:
+
+		enum class Adaptation {
+			Off      = 0, /// only keep the statistics
+			Alert    = 1, /// log when a client gets congested or recovers
+			Pacing   = 2, /// also send without bursts while congested
+			DropPIDs = 3  /// also drop the low priority PIDs while congested
+		};
+
+		// =====================================================================
+		//  -- Constructors and destructor -------------------------------------
+		// =====================================================================
+	public:
+
+		RtcpFeedback();
+
+		virtual ~RtcpFeedback();
+
+		// =====================================================================
+		//  -- Other member functions ------------------------------------------
+		// =====================================================================
+	public:
+
+		/// Clear the statistics, for ex. for a new client
+		void reset();
+
+		/// Read a compound RTCP packet of the client
+		/// @param ssrc specifies the SSRC of the stream, only the report
+		/// blocks about it are used
+		/// @param lossThreshold specifies the percentage of lost packets from
+		/// where the client is congested, 0 never
+		/// @param nacked will get the sequence numbers the client requests
+		/// again, it is cleared first
+		/// @return true if the client got congested or recovered
+		bool parse(const uint8_t *data, std::size_t len, uint32_t ssrc,
+			unsigned int lossThreshold, std::vector<uint16_t> &nacked);
+
+		/// Get the amount of report blocks about the stream
+		unsigned long getReports() const {
+			return _reports;
+		}
+
+		/// Get the amount of extended reports (XR) of the client
+		unsigned long getExtendedReports() const {
+			return _extendedReports;
+		}
+
+		/// Get the amount of packets the client requested again with a NACK
+		unsigned long getNacks() const {
+			return _nacks;
+		}
+
+		/// Get the percentage of packets lost since the previous report
+		unsigned int getFractionLost() const {
+			return _fractionLost;
+		}
+
+		/// Get the total amount of packets lost
+		long getCumulativeLost() const {
+			return _cumulativeLost;
+		}
+
+		/// Get the interarrival jitter in usec
+		unsigned long getJitter() const {
+			return _jitterUS;
+		}
+
+		/// Get the round trip time in usec, 0 if unknown
+		unsigned long getRtt() const {
+			return _rttUS;
+		}
+
+		/// Check if the client reports more loss than the threshold
+		bool isCongested() const {
+			return _congested;
+		}
+
+	private:
+
+		/// Read a report block (of a RR or SR) about the stream
+		void parseReportBlock(const uint8_t *block);
+
+		/// Read the report blocks of an XR about the stream
+		void parseExtendedReport(const uint8_t *data, std::size_t len, uint32_t ssrc);
+
+		/// Read the lost packets of a Generic NACK about the stream
+		void parseNack(const uint8_t *data, std::size_t len, uint32_t ssrc,
+			std::vector<uint16_t> &nacked);
+
+		// =====================================================================
+		// -- Data members -----------------------------------------------------
+		// =====================================================================
+	private:
+
+		static constexpr std::size_t REPORT_BLOCK_LEN = 24;
+
+		std::atomic<unsigned long> _reports;
+		std::atomic<unsigned long> _extendedReports;
+		std::atomic<unsigned long> _nacks;
+		std::atomic<unsigned int> _fractionLost;
+		std::atomic<long> _cumulativeLost;
+		std::atomic<unsigned long> _jitterUS;
+		std::atomic<unsigned long> _rttUS;
+		std::atomic<bool> _congested;
+};
+
+} // namespace output
+
+#endif // OUTPUT_RTCP_FEEDBACK_H_INCLUDE
@@ -0,0 +1,118 @@
+/* RtcpService.cpp
+
+   Copyright (C) 2014 - 2020 Marc Postema (mpostema09 -at- gmail.com)
+
+   This program is free software; you can redistribute it and/or
+   modify it under the terms of the GNU General Public License
+   as published by the Free Software Foundation; either version 2
+   of the License, or (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program; if not, write to the Free Software
+   Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+   Or, point your browser to http://www.gnu.org/copyleft/gpl.html
+*/
+#include <output/RtcpService.h>
+
+#include <output/StreamThreadRtcpBase.h>
+
+#include <algorithm>
+#include <chrono>
+#include <thread>
+
+namespace output {
+
+	constexpr std::size_t RtcpService::SLOTS;
+	constexpr long RtcpService::SLOT_MS;
+
+	// =========================================================================
+	//  -- Constructors and destructor -----------------------------------------
+	// =========================================================================
+
+	RtcpService::RtcpService() :
+		ThreadBase("RtcpService"),
+		_sessions(0),
+		_reports(0) {}
+
+	RtcpService::~RtcpService() {
+		terminateThread();
+	}
+
+	// =========================================================================
+	//  -- base::ThreadBase ----------------------------------------------------
+	// =========================================================================
+
+	void RtcpService::threadEntry() {
+		std::size_t slot = 0;
+		auto next = std::chrono::steady_clock::now();
+		while (running()) {
+			if (_sessions == 0) {
+				std::this_thread::sleep_for(std::chrono::milliseconds(100));
+				next = std::chrono::steady_clock::now();
+				continue;
+			}
+			{
+				// Keep the lock while sending, so 'remove' can not return
+				// while that session is still receiving or sending a report
+				base::MutexLock lock(_mutex);
+				// Receive every slot, so a NACK is answered within SLOT_MS
+				for (std::size_t i = 0; i < SLOTS; ++i) {
+					for (StreamThreadRtcpBase *session : _slot[i]) {
+						session->receiveReports();
+					}
+				}
+				for (StreamThreadRtcpBase *session : _slot[slot]) {
+					session->sendReport();
+				}
+				_reports += _slot[slot].size();
+			}
+			slot = (slot + 1) % SLOTS;
+			next += std::chrono::milliseconds(SLOT_MS);
+			const auto now = std::chrono::steady_clock::now();
+			if (next < now) {
+				// Too late, so do not try to catch up with a burst
+				next = now;
+			} else {
+				std::this_thread::sleep_until(next);
+			}
+		}
+	}
+
+	// =========================================================================
+	//  -- Other member functions ----------------------------------------------
+	// =========================================================================
+
+	void RtcpService::add(StreamThreadRtcpBase &session) {
+		base::MutexLock lock(_mutex);
+		std::size_t least = 0;
+		for (std::size_t i = 0; i < SLOTS; ++i) {
+			if (std::find(_slot[i].begin(), _slot[i].end(), &session) != _slot[i].end()) {
+				return;
+			}
+			if (_slot[i].size() < _slot[least].size()) {
+				least = i;
+			}
+		}
+		// Use the slot with the least sessions, to spread the reports
+		_slot[least].push_back(&session);
+		++_sessions;
+	}
+
+	void RtcpService::remove(StreamThreadRtcpBase &session) {
+		base::MutexLock lock(_mutex);
+		for (std::size_t i = 0; i < SLOTS; ++i) {
+			const auto it = std::find(_slot[i].begin(), _slot[i].end(), &session);
+			if (it != _slot[i].end()) {
+				_slot[i].erase(it);
+				--_sessions;
+				return;
+			}
+		}
+	}
+
+} // namespace output
@@ -0,0 +1,100 @@
+/* RtcpService.h
+
+   Copyright (C) 2014 - 2020 Marc Postema (mpostema09 -at- gmail.com)
+
+   This program is free software; you can redistribute it and/or
+   modify it under the terms of the GNU General Public License
+   as published by the Free Software Foundation; either version 2
+   of the License, or (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program; if not, write to the Free Software
+   Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+   Or, point your browser to http://www.gnu.org/copyleft/gpl.html
+*/
+#ifndef OUTPUT_RTCP_SERVICE_H_INCLUDE
+#define OUTPUT_RTCP_SERVICE_H_INCLUDE OUTPUT_RTCP_SERVICE_H_INCLUDE
+
+#include <FwDecl.h>
+#include <base/Mutex.h>
+#include <base/ThreadBase.h>
+
+#include <atomic>
+#include <cstddef>
+#include <vector>
+
+FW_DECL_NS1(output, StreamThreadRtcpBase);
+
+FW_DECL_UP_NS1(output, RtcpService);
+
+namespace output {
+
+/// The class @c RtcpService sends the RTCP reports of all sessions from one
+/// thread, instead of a thread for each session. The sessions are spread
+/// over the slots of a timer wheel, so the reports of one report interval
+/// are not all send at the same moment.
+class RtcpService :
+	public base::ThreadBase {
+		// =====================================================================
+		//  -- Constructors and destructor -------------------------------------
+		// =====================================================================
+	public:
+
+		RtcpService();
+
+		virtual ~RtcpService();
+
+		// =====================================================================
+		//  -- base::ThreadBase ------------------------------------------------
+		// =====================================================================
+	protected:
+
+		/// @see ThreadBase
+		virtual void threadEntry() final;
+
+		// =====================================================================
+		//  -- Other member functions ------------------------------------------
+		// =====================================================================
+	public:
+
+		/// Start sending the reports of session, every report interval.
+		/// Adding a session that is already added does nothing.
+		void add(StreamThreadRtcpBase &session);
+
+		/// Stop sending the reports of session. When this function returns
+		/// the session is not sending a report anymore.
+		void remove(StreamThreadRtcpBase &session);
+
+		/// Get the amount of sessions that send reports
+		std::size_t getSessions() const {
+			return _sessions;
+		}
+
+		/// Get the amount of reports send
+		unsigned long getReports() const {
+			return _reports;
+		}
+
+		// =====================================================================
+		// -- Data members -----------------------------------------------------
+		// =====================================================================
+	private:
+
+		/// The report interval is SLOTS * SLOT_MS
+		static constexpr std::size_t SLOTS = 10;
+		static constexpr long SLOT_MS = 20;
+
+		base::Mutex _mutex;
+		std::vector<StreamThreadRtcpBase *> _slot[SLOTS];
+		std::atomic<std::size_t> _sessions;
+		std::atomic<unsigned long> _reports;
+};
+
+} // namespace output
+
+#endif // OUTPUT_RTCP_SERVICE_H_INCLUDE
@@ -0,0 +1,183 @@
+/* RtpRetransmitter.cpp
+
+   Copyright (C) 2014 - 2020 Marc Postema (mpostema09 -at- gmail.com)
+
+   This program is free software; you can redistribute it and/or
+   modify it under the terms of the GNU General Public License
+   as published by the Free Software Foundation; either version 2
+   of the License, or (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program; if not, write to the Free Software
+   Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+   Or, point your browser to http://www.gnu.org/copyleft/gpl.html
+*/
+#include <output/RtpRetransmitter.h>
+
+#include <base/TimeCounter.h>
+#include <mpegts/PacketBuffer.h>
+#include <socket/SocketAttr.h>
+
+#include <cstring>
+#include <random>
+
+#include <sys/uio.h>
+
+namespace output {
+
+	// =========================================================================
+	//  -- Constructors and destructor -----------------------------------------
+	// =========================================================================
+
+	RtpRetransmitter::RtpRetransmitter() :
+		_enabled(false),
+		_mask(0),
+		_packetSize(0),
+		_windowUS(0),
+		_ratePercent(0),
+		_credit(0.0),
+		_maxCredit(0.0),
+		_ssrc(0),
+		_cseq(0),
+		_memoryKB(0),
+		_requested(0),
+		_sent(0),
+		_expired(0),
+		_rateLimited(0) {}
+
+	RtpRetransmitter::~RtpRetransmitter() {}
+
+	// =========================================================================
+	//  -- Other member functions ----------------------------------------------
+	// =========================================================================
+
+	void RtpRetransmitter::reset(const bool enable, const unsigned int windowMS,
+			const unsigned int memoryKB, const unsigned int ratePercent,
+			const std::size_t packetSize) {
+		base::MutexLock lock(_mutex);
+		_enabled = false;
+		_windowUS = windowMS * 1000ull;
+		_ratePercent = ratePercent;
+		_credit = 0.0;
+		if (!enable || packetSize == 0) {
+			std::vector<uint8_t>().swap(_memory);
+			std::vector<Entry>().swap(_entry);
+			_memoryKB = 0;
+			return;
+		}
+		// The ring size is a power of two within the memory cap, so the slot
+		// of a sequence number is a mask
+		std::size_t entries = MIN_ENTRIES;
+		while (entries * 2 * packetSize <= memoryKB * 1024ul && entries * 2 <= 0x10000) {
+			entries *= 2;
+		}
+		_packetSize = packetSize;
+		_mask = entries - 1;
+		_memory.assign(entries * packetSize, 0);
+		_entry.assign(entries, Entry{0, 0, 0, 0});
+		_memoryKB = _memory.size() / 1024;
+		// Do not let the credit of a quiet moment be spend at once
+		_maxCredit = (entries * packetSize * ratePercent) / 100.0;
+
+		std::random_device rd;
+		_ssrc = rd();
+		_cseq = rd() & 0xffff;
+		_enabled = true;
+	}
+
+	void RtpRetransmitter::add(const struct mmsghdr *msgs, const unsigned int vlen) {
+		if (!_enabled) {
+			return;
+		}
+		const uint64_t now = base::TimeCounter::getMonotonicMicros();
+		base::MutexLock lock(_mutex);
+		// A reset() may have freed the memory after the check above
+		if (!_enabled || _entry.empty()) {
+			return;
+		}
+		for (unsigned int i = 0; i < vlen; ++i) {
+			const struct msghdr &msg = msgs[i].msg_hdr;
+			// The first buffer starts with the RTP header
+			const uint8_t *header = static_cast<const uint8_t *>(msg.msg_iov[0].iov_base);
+			const uint16_t seq = (header[2] << 8) | header[3];
+			const std::size_t slot = seq & _mask;
+			uint8_t *copy = _memory.data() + slot * _packetSize;
+			std::size_t len = 0;
+			for (std::size_t j = 0; j < msg.msg_iovlen && len + msg.msg_iov[j].iov_len <= _packetSize; ++j) {
+				std::memcpy(copy + len, msg.msg_iov[j].iov_base, msg.msg_iov[j].iov_len);
+				len += msg.msg_iov[j].iov_len;
+			}
+			Entry &entry = _entry[slot];
+			entry.time = now;
+			entry.len = len;
+			entry.seq = seq;
+			entry.repairs = 0;
+			// What is send earns the credit to send again
+			_credit += (len * _ratePercent) / 100.0;
+		}
+		if (_credit > _maxCredit) {
+			_credit = _maxCredit;
+		}
+	}
+
+	void RtpRetransmitter::retransmit(const std::vector<uint16_t> &seqs, SocketAttr &rtp) {
+		static constexpr std::size_t headerLen = mpegts::PacketBuffer::RTP_HEADER_LEN;
+		if (!_enabled) {
+			return;
+		}
+		const uint64_t now = base::TimeCounter::getMonotonicMicros();
+		base::MutexLock lock(_mutex);
+		for (const uint16_t seq : seqs) {
+			++_requested;
+			if (_entry.empty()) {
+				++_expired;
+				continue;
+			}
+			Entry &entry = _entry[seq & _mask];
+			if (entry.len <= headerLen || entry.seq != seq || now - entry.time > _windowUS) {
+				++_expired;
+				continue;
+			}
+			if (entry.repairs >= MAX_REPAIRS || _credit < entry.len) {
+				++_rateLimited;
+				continue;
+			}
+			const uint8_t *packet = _memory.data() + (seq & _mask) * _packetSize;
+
+			// The RTP header of the original packet with the SSRC, sequence and
+			// payload type of the retransmission stream, then the original
+			// sequence number (OSN) and payload
+			++_cseq;
+			uint8_t header[headerLen + 2];
+			std::memcpy(header, packet, headerLen);
+			header[0]  = 0x80;                                // version: 2
+			header[1]  = (packet[1] & 0x80) | RTX_PAYLOAD_TYPE; // keep the marker
+			header[2]  = (_cseq >> 8) & 0xff;                 // sequence number
+			header[3]  = (_cseq >> 0) & 0xff;                 // sequence number
+			header[8]  = (_ssrc >> 24) & 0xff;                // synchronization source
+			header[9]  = (_ssrc >> 16) & 0xff;                // synchronization source
+			header[10] = (_ssrc >>  8) & 0xff;                // synchronization source
+			header[11] = (_ssrc >>  0) & 0xff;                // synchronization source
+			header[12] = packet[2];                           // original sequence number
+			header[13] = packet[3];                           // original sequence number
+
+			struct iovec iov[2];
+			iov[0].iov_base = header;
+			iov[0].iov_len = sizeof(header);
+			iov[1].iov_base = const_cast<uint8_t *>(packet + headerLen);
+			iov[1].iov_len = entry.len - headerLen;
+			if (!rtp.sendDataTo(iov, 2, MSG_DONTWAIT)) {
+				break;
+			}
+			_credit -= entry.len;
+			++entry.repairs;
+			++_sent;
+		}
+	}
+
+} // namespace output
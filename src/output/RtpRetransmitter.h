@@ -0,0 +1,146 @@
+/* RtpRetransmitter.h
+
+   Copyright (C) 2014 - 2020 Marc Postema (mpostema09 -at- gmail.com)
+
+   This program is free software; you can redistribute it and/or
+   modify it under the terms of the GNU General Public License
+   as published by the Free Software Foundation; either version 2
+   of the License, or (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program; if not, write to the Free Software
+   Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+   Or, point your browser to http://www.gnu.org/copyleft/gpl.html
+*/
+#ifndef OUTPUT_RTP_RETRANSMITTER_H_INCLUDE
+#define OUTPUT_RTP_RETRANSMITTER_H_INCLUDE OUTPUT_RTP_RETRANSMITTER_H_INCLUDE
+
+#include <FwDecl.h>
+#include <base/Mutex.h>
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include <sys/socket.h>
+
+FW_DECL_NS0(SocketAttr);
+
+namespace output {
+
+/// The class @c RtpRetransmitter keeps a copy of the RTP packets send to a
+/// client for a short time, in a ring indexed by sequence number. The packets
+/// the client reports lost with a Generic NACK (RFC 4585) are send again in
+/// the retransmission format of RFC 4588, on their own SSRC and payload type.
+class RtpRetransmitter {
+		// =====================================================================
+		//  -- Constructors and destructor -------------------------------------
+		// =====================================================================
+	public:
+
+		RtpRetransmitter();
+
+		virtual ~RtpRetransmitter();
+
+		// =====================================================================
+		//  -- Other member functions ------------------------------------------
+		// =====================================================================
+	public:
+
+		/// Setup an empty history, the memory is only allocated when enabled
+		/// @param enable specifies if packets should be kept and retransmitted
+		/// @param windowMS specifies how long a packet is kept
+		/// @param memoryKB specifies the max memory of the history
+		/// @param ratePercent specifies the max retransmission rate, as a
+		/// percentage of the send rate
+		/// @param packetSize specifies the max size of a RTP packet
+		void reset(bool enable, unsigned int windowMS, unsigned int memoryKB,
+			unsigned int ratePercent, std::size_t packetSize);
+
+		/// Check if packets are kept and retransmitted
+		bool isEnabled() const {
+			return _enabled;
+		}
+
+		/// Keep a copy of the RTP packets that are send
+		/// @param msgs specifies the RTP packets, each starts with its RTP header
+		void add(const struct mmsghdr *msgs, unsigned int vlen);
+
+		/// Send the requested packets again, when they are still kept and the
+		/// rate limit allows it
+		/// @param seqs specifies the sequence numbers of the lost packets
+		/// @param rtp specifies the socket the RTP packets are send with
+		void retransmit(const std::vector<uint16_t> &seqs, SocketAttr &rtp);
+
+		/// Get the amount of packets the client requested again
+		unsigned long getRequested() const {
+			return _requested;
+		}
+
+		/// Get the amount of packets that where send again
+		unsigned long getSent() const {
+			return _sent;
+		}
+
+		/// Get the amount of requested packets that where not kept anymore
+		unsigned long getExpired() const {
+			return _expired;
+		}
+
+		/// Get the amount of requested packets not send, because of the rate limit
+		unsigned long getRateLimited() const {
+			return _rateLimited;
+		}
+
+		/// Get the memory of the history in KBytes
+		std::size_t getMemory() const {
+			return _memoryKB;
+		}
+
+		// =====================================================================
+		// -- Data members -----------------------------------------------------
+		// =====================================================================
+	private:
+
+		/// RFC 4588 payload type, as announced in the DESCRIBE reply
+		static constexpr uint8_t RTX_PAYLOAD_TYPE = 97;
+		/// Times a packet is send again, when the repair got lost as well
+		static constexpr unsigned int MAX_REPAIRS = 3;
+		/// Least amount of packets kept
+		static constexpr std::size_t MIN_ENTRIES = 16;
+
+		struct Entry {
+			uint64_t time;            /// monotonic time in usec it was send
+			std::size_t len;          /// 0 if the slot is empty
+			uint16_t seq;
+			unsigned int repairs;
+		};
+
+		base::Mutex _mutex;
+		std::atomic<bool> _enabled;
+		std::vector<uint8_t> _memory;  /// the copies, packetSize for each entry
+		std::vector<Entry> _entry;
+		std::size_t _mask;             /// entries - 1, entries is a power of two
+		std::size_t _packetSize;
+		uint64_t _windowUS;
+		unsigned int _ratePercent;
+		double _credit;                /// bytes that may be send again
+		double _maxCredit;
+		uint32_t _ssrc;                /// SSRC of the retransmission stream
+		uint16_t _cseq;                /// sequence of the retransmission stream
+		std::atomic<std::size_t> _memoryKB;
+		std::atomic<unsigned long> _requested;
+		std::atomic<unsigned long> _sent;
+		std::atomic<unsigned long> _expired;
+		std::atomic<unsigned long> _rateLimited;
+};
+
+} // namespace output
+
+#endif // OUTPUT_RTP_RETRANSMITTER_H_INCLUDE
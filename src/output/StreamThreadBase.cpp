@@ -24,12 +24,19 @@
 #include <StreamClient.h>
 #include <StringConverter.h>
 #include <Log.h>
+#include <Utils.h>
 #include <input/Device.h>
+#include <input/IngestReactor.h>
+#include <mpegts/PacketPool.h>
+#include <output/RtcpFeedback.h>
 #ifdef LIBDVBCSA
 	#include <decrypt/dvbapi/Client.h>
 #endif
 
 #include <chrono>
+#include <cstdlib>
+#include <functional>
+#include <new>
 #include <thread>
 
 namespace output {
@@ -45,18 +52,45 @@ StreamThreadBase::StreamThreadBase(const std::string &protocol, StreamInterface
 	_state(State::Paused),
 	_clientID(0),
 	_cseq(0),
+	_pool(stream.getPacketPool()),
 	_writeIndex(0),
 	_readIndex(0),
-	_sendInterval(100) {
-	// Initialize all TS packets
+	_dropping(false),
+	_droppedPackets(0),
+	_ingestThread(
+		StringConverter::getFormattedString("Ingest%d", stream.getStreamID()),
+		std::bind(&StreamThreadBase::ingestThreadExecute, this)),
+	_ingestStarted(false),
+	_ingestState(State::Paused),
+	_pacer(MAX_BUF),
+	_congested(false),
+	_buffersPerSend(1),
+	_holdTime(0),
+	_holding(false),
+	_sendBatches(0),
+	_sendBatchBuffers(0),
+	_sendBatchMax(0),
+	_sendBatchTimeouts(0),
+	_ingestReactor(nullptr),
+	_ingestFD(-1),
+	_ingestGeneration(0),
+	_ingestToken(input::IngestReactor::NO_TOKEN),
+	_splicing(false) {
+	ASSERT(_pool != nullptr);
+	// The ring gets its buffers from the packet pool when filling
+	for (size_t i = 0; i < MAX_BUF; ++i) {
+		_tsBuffer[i] = nullptr;
+	}
 	uint32_t ssrc = _stream.getSSRC();
 	long timestamp = _stream.getTimestamp();
-	for (size_t i = 0; i < MAX_BUF; ++i) {
-		_tsBuffer[i].initialize(ssrc, timestamp);
+	for (size_t i = 0; i < MAX_DROP_BUF; ++i) {
+		_dropBuffer[i].initialize(ssrc, timestamp);
+		_dropBufferPtr[i] = &_dropBuffer[i];
 	}
 }
 
 StreamThreadBase::~StreamThreadBase() {
+	releaseBuffers();
 #ifdef LIBDVBCSA
 	decrypt::dvbapi::SpClient decrypt = _stream.getDecryptDevice();
 	if (decrypt != nullptr) {
@@ -65,15 +99,32 @@ StreamThreadBase::~StreamThreadBase() {
 #endif
 }
 
+void *StreamThreadBase::operator new(const std::size_t size) {
+	void *memory = nullptr;
+	if (::posix_memalign(&memory, CACHE_LINE_SIZE, size) != 0) {
+		throw std::bad_alloc();
+	}
+	return memory;
+}
+
+void StreamThreadBase::operator delete(void *ptr) {
+	::free(ptr);
+}
+
 // =============================================================================
 //  -- base::ThreadBase --------------------------------------------------------
 // =============================================================================
 
 void StreamThreadBase::threadEntry() {
 	StreamClient &client = _stream.getStreamClient(_clientID);
+	_ingestState = State::Paused;
+	_sendLoad.reset();
 	while (running()) {
+		_sendLoad.update();
 		switch (_state) {
 			case State::Pause:
+				unwatchInputDevice();
+				pauseIngest();
 				_state = State::Paused;
 				break;
 			case State::Paused:
@@ -81,7 +132,22 @@ void StreamThreadBase::threadEntry() {
 				std::this_thread::sleep_for(std::chrono::milliseconds(50));
 				break;
 			case State::Running:
-				readDataFromInputDevice(client);
+				if (spliceFromInputDevice(client)) {
+					break;
+				}
+				if (!watchInputDevice()) {
+					resumeIngest();
+				}
+				if (sendToOutputDevice(client) || flushOutputDevice(client)) {
+					break;
+				}
+				if (_readIndex != _writeIndex) {
+					// Waiting on decryption or the output device
+					std::this_thread::sleep_for(std::chrono::milliseconds(1));
+				} else {
+					// Nothing to send, so park until a buffer is filled
+					_dataEvent.wait([this]() { return _readIndex != _writeIndex; }, 100);
+				}
 				break;
 			default:
 				PERROR("Wrong State");
@@ -89,6 +155,11 @@ void StreamThreadBase::threadEntry() {
 				break;
 		}
 	}
+	unwatchInputDevice();
+	if (_ingestStarted) {
+		_ingestThread.terminateThread();
+		_ingestStarted = false;
+	}
 }
 
 // =========================================================================
@@ -103,9 +174,13 @@ bool StreamThreadBase::startStreaming(const int clientID) {
 	doStartStreaming(clientID);
 
 	_cseq = 0x0000;
-	_writeIndex = 0;
-	_readIndex = 0;
-	_tsBuffer[_writeIndex].reset();
+	_ingestReactor = _stream.getIngestReactor();
+	releaseBuffers();
+	_dropping = false;
+	_splicing = false;
+	_pacer.reset(_stream.getPacingBurst(), _stream.getPacingLatency());
+	_congested = false;
+	updateBuffersPerSend();
 
 	if (!startThread()) {
 		SI_LOG_ERROR("Stream: %d, Start %s Start stream to %s:%d ERROR", streamID, _protocol.c_str(),
@@ -115,9 +190,6 @@ bool StreamThreadBase::startStreaming(const int clientID) {
 	// Set priority above normal for this Thread
 	setPriority(Priority::AboveNormal);
 
-	// set begin timestamp
-	_t1 = std::chrono::steady_clock::now();
-
 	_state = State::Running;
 	SI_LOG_INFO("Stream: %d, Start %s stream to %s:%d", streamID, _protocol.c_str(),
 		client.getIPAddressOfStream().c_str(), getStreamSocketPort(clientID));
@@ -166,9 +238,18 @@ bool StreamThreadBase::restartStreaming(const int clientID) {
 	// Check if thread is running
 	if (running()) {
 		doRestartStreaming(clientID);
-		_writeIndex = 0;
-		_readIndex  = 0;
-		_tsBuffer[_writeIndex].reset();
+		// Let this thread stop the ingest thread or IngestReactor filling
+		// the buffers, before resetting them
+		_state = State::Pause;
+		for (auto timeout = 0; _state != State::Paused && timeout < 50; ++timeout) {
+			std::this_thread::sleep_for(std::chrono::milliseconds(50));
+		}
+		releaseBuffers();
+		_dropping = false;
+		_splicing = false;
+		_pacer.reset(_stream.getPacingBurst(), _stream.getPacingLatency());
+		_congested = false;
+		updateBuffersPerSend();
 		_state = State::Running;
 		SI_LOG_INFO("Stream: %d, Restart %s stream to %s:%d", _stream.getStreamID(),
 				_protocol.c_str(), _stream.getStreamClient(clientID).getIPAddressOfStream().c_str(),
@@ -177,40 +258,339 @@ bool StreamThreadBase::restartStreaming(const int clientID) {
 	return true;
 }
 
-void StreamThreadBase::readDataFromInputDevice(StreamClient &client) {
-	const input::SpDevice inputDevice = _stream.getInputDevice();
+bool StreamThreadBase::ingestThreadExecute() {
+	_ingestLoad.update();
+	switch (_ingestState) {
+		case State::Pause:
+			_ingestState = State::Paused;
+			break;
+		case State::Paused:
+			// Park until resumed, the timeout lets the thread stop
+			_ingestEvent.wait([this]() { return _ingestState != State::Paused; }, 100);
+			break;
+		case State::Running:
+			if (_stream.getInputDevice()->isDataAvailable()) {
+				fillFromInputDevice();
+			}
+			break;
+		default:
+			PERROR("Wrong State");
+			std::this_thread::sleep_for(std::chrono::milliseconds(50));
+			break;
+	}
+	return true;
+}
+
+void StreamThreadBase::resumeIngest() {
+	// The ingest thread reads the input device, so a blocking output
+	// device never stalls reading it
+	if (!_ingestStarted) {
+		if (!_ingestThread.startThread()) {
+			SI_LOG_ERROR("Stream: %d, Start ingest thread failed", _stream.getStreamID());
+			return;
+		}
+		_ingestThread.setPriority(base::Thread::Priority::High);
+		_ingestStarted = true;
+	}
+	State state = State::Paused;
+	if (_ingestState.compare_exchange_strong(state, State::Running)) {
+		_ingestEvent.signal();
+	}
+}
+
+void StreamThreadBase::pauseIngest() {
+	State state = State::Running;
+	if (_ingestState.compare_exchange_strong(state, State::Pause)) {
+		for (auto timeout = 0; _ingestState != State::Paused && timeout < 500; ++timeout) {
+			std::this_thread::sleep_for(std::chrono::milliseconds(5));
+		}
+	}
+}
+
+size_t StreamThreadBase::getAvailableSize() const {
 	size_t availableSize = (MAX_BUF - (_writeIndex - _readIndex));
 	if (availableSize > MAX_BUF) {
 		availableSize %= MAX_BUF;
 	}
-//		SI_LOG_DEBUG("Stream: %d, PacketBuffer MAX %d W %d R %d  S %d", _stream.getStreamID(), MAX_BUF, _writeIndex, _readIndex, availableSize);
-	if (inputDevice->isDataAvailable() && availableSize > 1) {
-		if (inputDevice->readFullTSPacket(_tsBuffer[_writeIndex])) {
-#ifdef LIBDVBCSA
-			decrypt::dvbapi::SpClient decrypt = _stream.getDecryptDevice();
-			if (decrypt != nullptr) {
-				decrypt->decrypt(_stream.getStreamID(), _tsBuffer[_writeIndex]);
+	return availableSize;
+}
+
+bool StreamThreadBase::allocateBuffer(const size_t index) {
+	if (_tsBuffer[index] == nullptr) {
+		mpegts::PacketBuffer *buffer = _pool->allocate();
+		if (buffer == nullptr) {
+			return false;
+		}
+		buffer->initialize(_stream.getSSRC(), _stream.getTimestamp());
+		buffer->reset();
+		_tsBuffer[index] = buffer;
+	}
+	return true;
+}
+
+void StreamThreadBase::releaseBuffers() {
+	for (size_t i = 0; i < MAX_BUF; ++i) {
+		if (_tsBuffer[i] != nullptr) {
+			_pool->release(_tsBuffer[i]);
+			_tsBuffer[i] = nullptr;
+		}
+	}
+	_writeIndex = 0;
+	_readIndex = 0;
+}
+
+void StreamThreadBase::updateBuffersPerSend() {
+	const size_t n = getTSPacketsPerSend() / mpegts::PacketBuffer::getNumberOfTSPackets();
+	_buffersPerSend = (n < 1) ? 1 : (n > MAX_SEND_BUF) ? MAX_SEND_BUF : n;
+	_holdTime = std::chrono::milliseconds(getSendHoldTime());
+	_holding = false;
+	SI_LOG_DEBUG("Stream: %d, %s send %zu TS packets in one go", _stream.getStreamID(),
+		_protocol.c_str(), _buffersPerSend * mpegts::PacketBuffer::getNumberOfTSPackets());
+}
+
+bool StreamThreadBase::fillFromInputDevice() {
+	const input::SpDevice inputDevice = _stream.getInputDevice();
+	const size_t writeIndex = _writeIndex;
+	const size_t availableSize = getAvailableSize();
+//		SI_LOG_DEBUG("Stream: %d, PacketBuffer MAX %d W %d R %d  S %d", _stream.getStreamID(), MAX_BUF, writeIndex, _readIndex.load(), availableSize);
+	// Fill as many consecutive free buffers as possible, but keep one
+	// free so the write index does not overtake the read index
+	std::size_t freeSize = (availableSize > 1) ? availableSize - 1 : 0;
+	if (freeSize > MAX_BUF - writeIndex) {
+		freeSize = MAX_BUF - writeIndex;
+	}
+	// The first buffer may still contain a partial read, so keep it
+	for (std::size_t i = 0; i < freeSize; ++i) {
+		if (_tsBuffer[writeIndex + i] == nullptr) {
+			if (!allocateBuffer(writeIndex + i)) {
+				// Packet pool exhausted, so handle it like a full ring
+				freeSize = i;
+				break;
 			}
+		} else if (i > 0) {
+			_tsBuffer[writeIndex + i]->reset();
+		}
+	}
+	if (freeSize == 0) {
+		if (inputDevice->isLiveSource()) {
+			// The output device does not keep up, so drop the data instead
+			// of letting the input device overflow
+			dropFromInputDevice();
+		} else {
+			// The input device can wait, so park until a buffer is send
+			_spaceEvent.wait([this]() { return getAvailableSize() > 1; }, 100);
+		}
+		return true;
+	}
+	if (_dropping) {
+		// Continue with the partial read of the drop buffer
+		*_tsBuffer[writeIndex] = _dropBuffer[0];
+		_dropping = false;
+		SI_LOG_INFO("Stream: %d, %s output recovered, dropped %lu TS packets",
+			_stream.getStreamID(), _protocol.c_str(), _droppedPackets);
+	}
+	const std::size_t full = inputDevice->readTSPackets(&_tsBuffer[writeIndex], freeSize);
+#ifdef LIBDVBCSA
+	decrypt::dvbapi::SpClient decrypt = _stream.getDecryptDevice();
+	if (decrypt != nullptr) {
+		for (std::size_t i = 0; i < full; ++i) {
+			decrypt->decrypt(_stream.getStreamID(), *_tsBuffer[writeIndex + i]);
+		}
+	}
 #endif
-			// goto next, so inc write index
-			++_writeIndex;
-			_writeIndex %= MAX_BUF;
+	// goto next, so inc write index
+	const size_t nextIndex = (writeIndex + full) % MAX_BUF;
+	// reset next, only if it was not (partially) filled by this read
+	if (full == freeSize && _tsBuffer[nextIndex] != nullptr) {
+		_tsBuffer[nextIndex]->reset();
+	}
+	_writeIndex = nextIndex;
+	_dataEvent.signal();
+	return true;
+}
 
-			// reset next
-			_tsBuffer[_writeIndex].reset();
+void StreamThreadBase::dropFromInputDevice() {
+	const input::SpDevice inputDevice = _stream.getInputDevice();
+	if (!_dropping) {
+		// Keep the partial read, so the TS packets stay aligned
+		if (_tsBuffer[_writeIndex] != nullptr) {
+			_dropBuffer[0] = *_tsBuffer[_writeIndex];
+		} else {
+			_dropBuffer[0].reset();
+		}
+		_dropping = true;
+		_droppedPackets = 0;
+		SI_LOG_ERROR("Stream: %d, %s output too slow, dropping TS packets",
+			_stream.getStreamID(), _protocol.c_str());
+	}
+	for (std::size_t i = 1; i < MAX_DROP_BUF; ++i) {
+		_dropBuffer[i].reset();
+	}
+	const std::size_t full = inputDevice->readTSPackets(_dropBufferPtr, MAX_DROP_BUF);
+	if (full > 0) {
+		const uint32_t packets = full * mpegts::PacketBuffer::getNumberOfTSPackets();
+		_droppedPackets += packets;
+		_stream.addDroppedPackets(packets);
+		// Keep the partial read of the last buffer, if any
+		if (full < MAX_DROP_BUF) {
+			_dropBuffer[0] = _dropBuffer[full];
+		} else {
+			_dropBuffer[0].reset();
 		}
 	}
-	// calculate interval
-	_t2 = std::chrono::steady_clock::now();
-	const unsigned long interval = std::chrono::duration_cast<std::chrono::microseconds>(_t2 - _t1).count();
-	if (interval > _sendInterval && _tsBuffer[_readIndex].isReadyToSend()) {
-		_t1 = _t2;
-		if (writeDataToOutputDevice(_tsBuffer[_readIndex], client)) {
-			// inc read index only when send is successful
-			++_readIndex;
-			_readIndex %= MAX_BUF;
+}
+
+void StreamThreadBase::adaptToFeedback() {
+	const RtcpFeedback *feedback = getRtcpFeedback();
+	const bool congested = feedback != nullptr && feedback->isCongested() &&
+		_stream.getRtcpAdaptation() >= static_cast<unsigned int>(RtcpFeedback::Adaptation::Pacing);
+	if (congested != _congested) {
+		_congested = congested;
+		_pacer.setBurst(congested ? 1 : _stream.getPacingBurst());
+	}
+}
+
+bool StreamThreadBase::sendToOutputDevice(StreamClient &client) {
+	adaptToFeedback();
+	bool send = false;
+	while (_state == State::Running && running()) {
+		const size_t readIndex = _readIndex;
+		const size_t writeIndex = _writeIndex;
+		// Collect the ready buffers to send in one go, the ring may wrap
+		mpegts::PacketBuffer *buffers[MAX_SEND_BUF];
+		size_t n = 0;
+		for (size_t i = readIndex; i != writeIndex && n < _buffersPerSend; i = (i + 1) % MAX_BUF) {
+			if (!_tsBuffer[i]->isReadyToSend()) {
+				break;
+			}
+			buffers[n++] = _tsBuffer[i];
+		}
+		if (n == 0) {
+			break;
+		}
+		bool timeout = false;
+		if (n < _buffersPerSend && _holdTime.count() > 0) {
+			// Hold a partial batch for more buffers, but not too long
+			const std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+			if (!_holding) {
+				_holding = true;
+				_tHold = now;
+			}
+			if (now - _tHold < _holdTime) {
+				break;
+			}
+			timeout = true;
+		}
+		if (!_pacer.waitForRelease()) {
+			// Not released yet, but keep waiting on the pacer
+			return true;
 		}
+		if (!writeDataToOutputDevice(buffers, n, client)) {
+			break;
+		}
+		_holding = false;
+		++_sendBatches;
+		_sendBatchBuffers += n;
+		if (n > _sendBatchMax) {
+			_sendBatchMax = n;
+		}
+		if (timeout) {
+			++_sendBatchTimeouts;
+		}
+		// The pacer reads the send buffers, so this is done before the slots
+		// are handed back to the producer, which may refill them right away
+		const size_t queued = (writeIndex + MAX_BUF - readIndex) % MAX_BUF;
+		for (size_t i = 0; i < n; ++i) {
+			_pacer.released(*buffers[i], queued - i - 1);
+			// Return the buffer to the pool, before handing the slot back
+			_tsBuffer[(readIndex + i) % MAX_BUF] = nullptr;
+			_pool->release(buffers[i]);
+		}
+		// inc read index only when send is successful
+		_readIndex = (readIndex + n) % MAX_BUF;
+		_spaceEvent.signal();
+		send = true;
+	}
+	if (send) {
+		_tLastSend = std::chrono::steady_clock::now();
+	}
+	return send;
+}
+
+bool StreamThreadBase::spliceFromInputDevice(StreamClient &client) {
+	const input::SpDevice inputDevice = _stream.getInputDevice();
+	if (!_splicing) {
+		// Check once in a while, because switching stops the ingest
+		const std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+		if (now < _tSpliceCheck) {
+			return false;
+		}
+		_tSpliceCheck = now + std::chrono::seconds(1);
+		if (!canSpliceToOutputDevice(*inputDevice)) {
+			return false;
+		}
+		unwatchInputDevice();
+		pauseIngest();
+		// Try again later when the ring is not empty, the ingest is resumed
+		// by the caller
+		const mpegts::PacketBuffer *buffer = _tsBuffer[_writeIndex];
+		if (_readIndex != _writeIndex || (buffer != nullptr && !buffer->empty())) {
+			return false;
+		}
+		_splicing = true;
+		SI_LOG_INFO("Stream: %d, %s splice input device to %s", _stream.getStreamID(),
+			_protocol.c_str(), client.getIPAddressOfStream().c_str());
+	}
+	if (spliceToOutputDevice(*inputDevice, client)) {
+		return true;
+	}
+	_splicing = false;
+	SI_LOG_INFO("Stream: %d, %s stopped splicing, continue with the buffers",
+		_stream.getStreamID(), _protocol.c_str());
+	return false;
+}
+
+bool StreamThreadBase::watchInputDevice() {
+	if (_ingestReactor == nullptr) {
+		return false;
+	}
+	// Read the generation first, it is incremented after the fd is opened
+	const input::SpDevice inputDevice = _stream.getInputDevice();
+	const unsigned long generation = inputDevice->getDataFDGeneration();
+	const int fd = inputDevice->getDataFD();
+	if (fd == _ingestFD && generation == _ingestGeneration) {
+		const std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+		if (_ingestFD == -1 || now - _tLastSend <= std::chrono::milliseconds(100)) {
+			return _ingestFD != -1;
+		}
+		// Nothing send for a while, re-arm in case the readable function
+		// suspended watching because the ring was full
+		_tLastSend = now;
+		if (_ingestReactor->resume(_ingestToken)) {
+			return true;
+		}
+		// The fd was closed under the registration, so register again
+	}
+	unwatchInputDevice();
+	// Only one producer may fill the ring
+	pauseIngest();
+	_ingestGeneration = generation;
+	if (fd != -1) {
+		_ingestToken = _ingestReactor->add(fd, [this]() { return fillFromInputDevice(); });
+		if (_ingestToken != input::IngestReactor::NO_TOKEN) {
+			_ingestFD = fd;
+			_tLastSend = std::chrono::steady_clock::now();
+		}
+	}
+	return _ingestFD != -1;
+}
+
+void StreamThreadBase::unwatchInputDevice() {
+	if (_ingestReactor != nullptr && _ingestToken != input::IngestReactor::NO_TOKEN) {
+		_ingestReactor->remove(_ingestToken);
 	}
+	_ingestToken = input::IngestReactor::NO_TOKEN;
+	_ingestFD = -1;
 }
 
 } // namespace output
@@ -22,14 +22,26 @@
 
 #include <FwDecl.h>
 #include <Unused.h>
+#include <base/CPULoad.h>
+#include <base/Thread.h>
 #include <base/ThreadBase.h>
+#include <base/WaitEvent.h>
 #include <mpegts/PacketBuffer.h>
+#include <output/Pacer.h>
 
 #include <atomic>
 #include <chrono>
+#include <cstddef>
+#include <cstdint>
 
 FW_DECL_NS0(StreamClient);
 FW_DECL_NS0(StreamInterface);
+FW_DECL_NS1(input, Device);
+FW_DECL_NS1(input, IngestReactor);
+FW_DECL_NS1(mpegts, PacketPool);
+FW_DECL_NS1(output, RtcpFeedback);
+FW_DECL_NS1(output, RtpRetransmitter);
+FW_DECL_NS1(output, TcpSink);
 
 FW_DECL_UP_NS1(output, StreamThreadBase);
 
@@ -49,6 +61,12 @@ class StreamThreadBase :
 
 		virtual ~StreamThreadBase();
 
+		/// The ring indices are aligned to a cache line, plain new does not
+		/// guarantee that before C++17
+		static void *operator new(std::size_t size);
+
+		static void operator delete(void *ptr);
+
 		// =====================================================================
 		//  -- base::ThreadBase ------------------------------------------------
 		// =====================================================================
@@ -77,13 +95,128 @@ class StreamThreadBase :
 		/// @return true if stream is restarted else false on error
 		bool restartStreaming(int clientID);
 
+		/// Add a client that shares the input device of this stream, it will
+		/// receive only the TS packets of the PIDs it requested
+		/// @param clientID specifies which client should be added
+		/// @return true if the client is added, false if this stream type can
+		/// not be shared
+		virtual bool addSharedClient(int UNUSED(clientID)) { return false; }
+
+		/// Remove a client that shares the input device of this stream
+		/// @param clientID specifies which client should be removed
+		virtual void removeSharedClient(int UNUSED(clientID)) {}
+
+		/// Get the pacer of this stream, for its statistics
+		const Pacer &getPacer() const {
+			return _pacer;
+		}
+
+		/// Get the TCP sink of this stream, for its statistics
+		/// @return nullptr if this output does not write to a TCP client
+		virtual const TcpSink *getTcpSink() const {
+			return nullptr;
+		}
+
+		/// Get the reports the client sends back about this stream
+		/// @return nullptr if this output does not receive RTCP reports
+		virtual const RtcpFeedback *getRtcpFeedback() const {
+			return nullptr;
+		}
+
+		/// Get the retransmission history of this stream, for its statistics
+		/// @return nullptr if this output can not retransmit
+		virtual const RtpRetransmitter *getRtpRetransmitter() const {
+			return nullptr;
+		}
+
+		/// Process the RTCP packet a client send interleaved on its RTSP
+		/// connection
+		/// @param clientID specifies which client send it
+		virtual void processRtcpReport(int UNUSED(clientID),
+			const uint8_t *UNUSED(data),
+			std::size_t UNUSED(len)) {}
+
+		/// Get the amount of writes to the output device
+		unsigned long getSendBatches() const {
+			return _sendBatches;
+		}
+
+		/// Get the average TS packets send per write to the output device
+		double getSendBatchAverage() const {
+			const unsigned long batches = _sendBatches;
+			return (batches == 0) ? 0.0 :
+				(_sendBatchBuffers * mpegts::PacketBuffer::getNumberOfTSPackets()) / static_cast<double>(batches);
+		}
+
+		/// Get the max TS packets send in one write to the output device
+		unsigned long getSendBatchMax() const {
+			return _sendBatchMax * mpegts::PacketBuffer::getNumberOfTSPackets();
+		}
+
+		/// Get the amount of writes that where send partial, because the
+		/// hold time expired
+		unsigned long getSendBatchTimeouts() const {
+			return _sendBatchTimeouts;
+		}
+
+		/// Check if the input device is spliced to the output device
+		bool isSplicing() const {
+			return _splicing;
+		}
+
+		/// Get the busy time of the sending thread in percent
+		double getSendLoad() const {
+			return _sendLoad.getLoad();
+		}
+
+		/// Get the busy time of the ingest thread in percent
+		double getIngestLoad() const {
+			return _ingestLoad.getLoad();
+		}
+
 	protected:
 
-		/// Send the TS packets to an output device
+		/// Send the TS packets of consecutive buffers to an output device
+		/// @param buffers specifies the buffers to send in one go
+		/// @param n specifies the amount of buffers, at most @see MAX_SEND_BUF
 		virtual bool writeDataToOutputDevice(
-			mpegts::PacketBuffer &UNUSED(buffer),
+			mpegts::PacketBuffer *const *UNUSED(buffers),
+			std::size_t UNUSED(n),
 			StreamClient &UNUSED(client)) { return false; };
 
+		/// Continue writing the data the output device could not take at once,
+		/// it may wait shortly until the output device takes more
+		/// @return true if the output device still has a backlog
+		virtual bool flushOutputDevice(StreamClient &UNUSED(client)) {
+			return false;
+		}
+
+		/// Check if the data of the input device can be moved to the output
+		/// device with @see spliceToOutputDevice, bypassing the ring
+		virtual bool canSpliceToOutputDevice(const input::Device &UNUSED(inputDevice)) const {
+			return false;
+		}
+
+		/// Move the available data of the input device to the output device,
+		/// without copying it to user space
+		/// @return false if it should continue with the ring
+		virtual bool spliceToOutputDevice(input::Device &UNUSED(inputDevice),
+				StreamClient &UNUSED(client)) {
+			return false;
+		}
+
+		/// Get the amount of TS packets this output wants to send in one go,
+		/// it is rounded down to whole buffers
+		virtual unsigned int getTSPacketsPerSend() const {
+			return mpegts::PacketBuffer::getNumberOfTSPackets();
+		}
+
+		/// Get the max time in msec to hold less buffers then
+		/// @see getTSPacketsPerSend, waiting for more. 0 sends what is ready.
+		virtual unsigned int getSendHoldTime() const {
+			return 0;
+		}
+
 		/// Returns the socket port for the specified client
 		/// @param clientID specifies which client the port id requested
 		/// @return the socket port for ex. to data send to
@@ -100,15 +233,80 @@ class StreamThreadBase :
 		/// Specialization for @see restartStreaming
 		virtual void doRestartStreaming(int UNUSED(clientID)) {}
 
-		/// This function will read data from the input device
+		/// Thread execute function of the ingest thread @see base::Thread,
+		/// it reads the input device when it is not watched by the
+		/// @c IngestReactor
+		bool ingestThreadExecute();
+
+		/// Let the ingest thread read the input device, it is started the
+		/// first time, so it does not exist when the @c IngestReactor reads it
+		void resumeIngest();
+
+		/// Stop the ingest thread reading the input device, and wait until
+		/// it does not touch the ring anymore
+		void pauseIngest();
+
+		/// Read the available data from the input device into the free buffers
+		/// of the ring. When the ring is full the data of a live input device
+		/// is dropped, else it waits until there is room.
+		/// @return always true, the input device should never wait on the output
+		bool fillFromInputDevice();
+
+		/// Get the amount of free buffers in the ring
+		size_t getAvailableSize() const;
+
+		/// Make sure the ring slot has a buffer from the packet pool
+		/// @param index specifies the ring slot
+		/// @return false if the packet pool is exhausted
+		bool allocateBuffer(size_t index);
+
+		/// Return all buffers of the ring to the packet pool
+		void releaseBuffers();
+
+		/// Update the amount of buffers to send in one go and the hold time,
+		/// from what this output wants
+		void updateBuffersPerSend();
+
+		/// Read the available data from the input device and drop it, because
+		/// the output device can not keep up
+		void dropFromInputDevice();
+
+		/// Send paced without bursts while the client reports congestion,
+		/// when the stream settings want it
+		void adaptToFeedback();
+
+		/// Send the full buffers in the ring to the output device, when the
+		/// pacer releases them
 		/// @param client specifies were it should be sended to
-		void readDataFromInputDevice(StreamClient &client);
+		/// @return true if a buffer was send or is waiting on the pacer
+		bool sendToOutputDevice(StreamClient &client);
+
+		/// Splice the input device to the output device instead of using the
+		/// ring, when the output wants it. It switches when the ring is empty
+		/// up to a buffer boundary, so the TS packets stay in order.
+		/// @return true if it is splicing
+		bool spliceFromInputDevice(StreamClient &client);
+
+		/// Let the @c IngestReactor watch the data fd of the input device,
+		/// this will follow the fd when the input device reopens it
+		/// @return true if the input device is watched by the reactor
+		bool watchInputDevice();
+
+		/// Stop the @c IngestReactor from watching the input device
+		void unwatchInputDevice();
 
 		// =====================================================================
 		// -- Data members -----------------------------------------------------
 		// =====================================================================
+	public:
+
+		static constexpr size_t MAX_BUF = 100;
+
 	protected:
 
+		/// Max buffers send in one go, all buffers of the ring
+		static constexpr size_t MAX_SEND_BUF = MAX_BUF;
+
 		enum class State {
 			Running,
 			Pause,
@@ -123,13 +321,50 @@ class StreamThreadBase :
 
 	private:
 
-		static constexpr size_t MAX_BUF = 100;
-		mpegts::PacketBuffer _tsBuffer[MAX_BUF];
-		size_t _writeIndex;
-		size_t _readIndex;
-		unsigned long _sendInterval;
-		std::chrono::steady_clock::time_point _t1;
-		std::chrono::steady_clock::time_point _t2;
+		static constexpr size_t CACHE_LINE_SIZE = 64;
+		static constexpr size_t MAX_DROP_BUF = 16;
+
+		// Single producer (ingest thread or IngestReactor) single consumer
+		// (this thread) ring of buffers from the packet pool. The indices
+		// are on their own cache line, so the producer and consumer do not
+		// invalidate each others cache.
+		mpegts::PacketPool *_pool;
+		mpegts::PacketBuffer *_tsBuffer[MAX_BUF]; /// nullptr if the slot has no buffer
+		alignas(CACHE_LINE_SIZE) std::atomic<size_t> _writeIndex;
+		alignas(CACHE_LINE_SIZE) std::atomic<size_t> _readIndex;
+
+		// Producer side
+		alignas(CACHE_LINE_SIZE) mpegts::PacketBuffer _dropBuffer[MAX_DROP_BUF]; /// index 0 keeps a partial read
+		mpegts::PacketBuffer *_dropBufferPtr[MAX_DROP_BUF];
+		bool _dropping;                     /// ring is full, input data is dropped
+		unsigned long _droppedPackets;      /// TS packets dropped since the ring was full
+		base::Thread _ingestThread;
+		bool _ingestStarted;                /// _ingestThread is started
+		std::atomic<State> _ingestState;
+		base::WaitEvent _ingestEvent;       /// signaled when the ingest is resumed
+		base::CPULoad _ingestLoad;
+		base::WaitEvent _spaceEvent;        /// signaled when a buffer is send
+
+		// Consumer side
+		Pacer _pacer;
+		bool _congested;                    /// pacing is adapted to the feedback
+		size_t _buffersPerSend;
+		std::chrono::milliseconds _holdTime;
+		bool _holding;                      /// a partial batch is held
+		std::chrono::steady_clock::time_point _tHold;
+		std::atomic<unsigned long> _sendBatches;
+		std::atomic<unsigned long> _sendBatchBuffers;
+		std::atomic<unsigned long> _sendBatchMax;
+		std::atomic<unsigned long> _sendBatchTimeouts;
+		base::CPULoad _sendLoad;
+		base::WaitEvent _dataEvent;         /// signaled when a buffer is filled
+		input::IngestReactor *_ingestReactor;
+		int _ingestFD;
+		unsigned long _ingestGeneration;    /// data fd generation of _ingestFD
+		uint64_t _ingestToken;              /// registration at the IngestReactor
+		std::chrono::steady_clock::time_point _tLastSend;
+		std::atomic<bool> _splicing;        /// input device is spliced to the output
+		std::chrono::steady_clock::time_point _tSpliceCheck;
 
 };
 
@@ -24,6 +24,10 @@
 #include <StreamInterface.h>
 #include <StreamClient.h>
 #include <base/TimeCounter.h>
+#include <input/Device.h>
+#ifdef LIBDVBCSA
+	#include <decrypt/dvbapi/Client.h>
+#endif
 
 #include <chrono>
 #include <thread>
@@ -36,7 +40,9 @@ namespace output {
 
 StreamThreadHttp::StreamThreadHttp(
 	StreamInterface &stream) :
-	StreamThreadBase("HTTP", stream) {}
+	StreamThreadBase("HTTP", stream),
+	_sink(stream, "HTTP", 0),
+	_splice(false) {}
 
 StreamThreadHttp::~StreamThreadHttp() {
 	terminateThread();
@@ -60,6 +66,9 @@ void StreamThreadHttp::doStartStreaming(const int clientID) {
 	SI_LOG_INFO("Stream: %d, %s set network buffer size: %d KBytes", streamID,
 		_protocol.c_str(), bufferSize / 1024);
 
+	_sink.reset(client, _stream.isHttpZeroCopyEnabled());
+	_splice = _stream.isHttpSpliceEnabled();
+
 //		client.setSocketTimeoutInSec(2);
 }
 
@@ -67,26 +76,60 @@ int StreamThreadHttp::getStreamSocketPort(const int clientID) const {
 	return _stream.getStreamClient(clientID).getHttpSocketPort();
 }
 
-bool StreamThreadHttp::writeDataToOutputDevice(mpegts::PacketBuffer &buffer, StreamClient &client) {
-	static constexpr unsigned int dataSize = buffer.getBufferSize();
-	const long timestamp = base::TimeCounter::getTicks() * 90;
+bool StreamThreadHttp::writeDataToOutputDevice(
+		mpegts::PacketBuffer *const *buffers,
+		const std::size_t n,
+		StreamClient &client) {
+	const long timestamp = base::TimeCounter::getRtpTimestamp();
+
+	// Each buffer is a packet for the sink, so it can drop whole buffers
+	iovec iov[MAX_SEND_BUF * mpegts::PacketBuffer::getNumberOfTSPackets()];
+	std::size_t packetSize[MAX_SEND_BUF];
+	std::size_t iovcnt = 0;
+	std::size_t len = 0;
+	for (std::size_t i = 0; i < n; ++i) {
+		packetSize[i] = _sink.addTSPackets(*buffers[i], iov, iovcnt);
+		len += packetSize[i];
+	}
 
 	// RTP packet octet count (Bytes)
-	_stream.addRtpData(dataSize, timestamp);
-
-	iovec iov[1];
-	iov[0].iov_base = buffer.getTSReadBufferPtr();
-	iov[0].iov_len = dataSize;
+	_stream.addRtpData(1, len, timestamp);
 
 	// send the HTTP packet
-	if (!client.writeHttpData(iov, 1)) {
-		if (!client.isSelfDestructing()) {
-			SI_LOG_ERROR("Stream: %d, Error sending HTTP Stream Data to %s", _stream.getStreamID(),
-				client.getIPAddressOfStream().c_str());
-			client.selfDestruct();
-		}
+	_sink.write(client, iov, iovcnt, packetSize, n, buffers, n);
+	return true;
+}
+
+bool StreamThreadHttp::flushOutputDevice(StreamClient &client) {
+	return _sink.flush(client, 1);
+}
+
+bool StreamThreadHttp::canSpliceToOutputDevice(const input::Device &inputDevice) const {
+	if (!_splice || !_sink.isSpliceable() || _sink.getBacklog() != 0 ||
+		!inputDevice.isSpliceable()) {
+		return false;
+	}
+#ifdef LIBDVBCSA
+	// Scrambled TS packets need the decrypt stage
+	const decrypt::dvbapi::SpClient decrypt = _stream.getDecryptDevice();
+	if (decrypt != nullptr && decrypt->canDecrypt()) {
+		return false;
 	}
+#endif
 	return true;
 }
 
+bool StreamThreadHttp::spliceToOutputDevice(input::Device &inputDevice, StreamClient &client) {
+	const ssize_t bytes = _sink.splice(client, inputDevice);
+	if (bytes > 0) {
+		// RTP packet octet count (Bytes)
+		_stream.addRtpData(1, bytes, base::TimeCounter::getRtpTimestamp());
+	}
+	return bytes != -1;
+}
+
+unsigned int StreamThreadHttp::getTSPacketsPerSend() const {
+	return _stream.getHttpTSPackets();
+}
+
 } // namespace output
@@ -22,6 +22,7 @@
 
 #include <FwDecl.h>
 #include <output/StreamThreadBase.h>
+#include <output/TcpSink.h>
 
 FW_DECL_NS0(StreamClient);
 FW_DECL_NS0(StreamInterface);
@@ -41,6 +42,16 @@ class StreamThreadHttp :
 
 		virtual ~StreamThreadHttp();
 
+		// =====================================================================
+		//  -- output::StreamThreadBase ----------------------------------------
+		// =====================================================================
+	public:
+
+		/// @see StreamThreadBase
+		virtual const TcpSink *getTcpSink() const final {
+			return &_sink;
+		}
+
 		// =====================================================================
 		//  -- output::StreamThreadBase ----------------------------------------
 		// =====================================================================
@@ -48,9 +59,23 @@ class StreamThreadHttp :
 
 		/// @see StreamThreadBase
 		virtual bool writeDataToOutputDevice(
-			mpegts::PacketBuffer &buffer,
+			mpegts::PacketBuffer *const *buffers,
+			std::size_t n,
+			StreamClient &client) final;
+
+		/// @see StreamThreadBase
+		virtual bool flushOutputDevice(StreamClient &client) final;
+
+		/// @see StreamThreadBase
+		virtual bool canSpliceToOutputDevice(const input::Device &inputDevice) const final;
+
+		/// @see StreamThreadBase
+		virtual bool spliceToOutputDevice(input::Device &inputDevice,
 			StreamClient &client) final;
 
+		/// @see StreamThreadBase
+		virtual unsigned int getTSPacketsPerSend() const final;
+
 		/// @see StreamThreadBase
 		virtual int getStreamSocketPort(int clientID) const final;
 
@@ -64,6 +89,8 @@ class StreamThreadHttp :
 		// =====================================================================
 	private:
 
+		TcpSink _sink;
+		bool _splice;   /// splice the input device to the client, when possible
 };
 
 } // namespace output
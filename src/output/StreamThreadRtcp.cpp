@@ -22,8 +22,7 @@
 #include <StreamClient.h>
 #include <Stream.h>
 #include <Log.h>
-
-#include <cstring>
+#include <output/RtpRetransmitter.h>
 
 namespace output {
 
@@ -31,11 +30,13 @@ namespace output {
 // -- Constructors and destructor ------------------------------------------
 // =========================================================================
 
-StreamThreadRtcp::StreamThreadRtcp(StreamInterface &stream) :
-		StreamThreadRtcpBase("RTCP/UDP", stream) {}
+StreamThreadRtcp::StreamThreadRtcp(StreamInterface &stream,
+	RtpRetransmitter &retransmitter) :
+		StreamThreadRtcpBase("RTCP/UDP", stream),
+		_retransmitter(retransmitter) {}
 
 StreamThreadRtcp::~StreamThreadRtcp() {
-	_thread.terminateThread();
+	unschedule();
 	const int streamID = _stream.getStreamID();
 	const StreamClient &client = _stream.getStreamClient(_clientID);
 	SI_LOG_INFO("Stream: %d, Destroy %s stream to %s:%d", streamID,
@@ -61,23 +62,41 @@ int StreamThreadRtcp::getStreamSocketPort(const int clientID) const {
 }
 
 void StreamThreadRtcp::doSendDataToClient(const int clientID,
-	uint8_t *sr, const std::size_t srlen,
-	uint8_t *sdes, const std::size_t sdeslen,
-	uint8_t *app, const std::size_t applen) {
+	const uint8_t *data, const std::size_t len) {
 	StreamClient &client = _stream.getStreamClient(clientID);
 
-	const std::size_t len = srlen + sdeslen + applen;
-	uint8_t data[len];
-
-	std::memcpy(data, sr, srlen);
-	std::memcpy(data + srlen, sdes, sdeslen);
-	std::memcpy(data + srlen + sdeslen, app, applen);
-
-	// send the RTCP/UDP packet
-	if (!client.getRtcpSocketAttr().sendDataTo(data, len, 0)) {
+	// send the RTCP/UDP packet, without waiting so a full socket buffer
+	// of one client does not delay the reports of the other sessions
+	if (!client.getRtcpSocketAttr().sendDataTo(data, len, MSG_DONTWAIT)) {
 		SI_LOG_ERROR("Stream: %d, Error sending %s data to %s:%d", _stream.getStreamID(),
 			_protocol.c_str(), client.getIPAddressOfStream().c_str(), getStreamSocketPort(clientID));
 	}
 }
 
+void StreamThreadRtcp::doReceiveReports(const int clientID) {
+	SocketAttr &rtcp = _stream.getStreamClient(clientID).getRtcpSocketAttr();
+	if (rtcp.getFD() == -1) {
+		return;
+	}
+	// The client sends its reports to the port our reports come from
+	const in_addr_t addr = rtcp.getSocketAddress().sin_addr.s_addr;
+	uint8_t data[MAX_RECEIVE_LEN];
+	for (std::size_t i = 0; i < MAX_RECEIVE; ++i) {
+		struct sockaddr_in from;
+		const ssize_t size = rtcp.recvDatafrom(data, sizeof(data), MSG_DONTWAIT, from);
+		if (size <= 0) {
+			break;
+		}
+		// Only the client of this session may report about it
+		if (from.sin_addr.s_addr == addr) {
+			processReport(data, size);
+		}
+	}
+}
+
+void StreamThreadRtcp::doRetransmit(const int clientID, const std::vector<uint16_t> &seqs) {
+	// The repairs go to the RTP port of the client, on their own SSRC
+	_retransmitter.retransmit(seqs, _stream.getStreamClient(clientID).getRtpSocketAttr());
+}
+
 }
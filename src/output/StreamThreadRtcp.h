@@ -24,6 +24,7 @@
 #include <output/StreamThreadRtcpBase.h>
 
 FW_DECL_NS0(StreamInterface);
+FW_DECL_NS1(output, RtpRetransmitter);
 
 namespace output {
 
@@ -35,7 +36,9 @@ class StreamThreadRtcp :
 		// =====================================================================
 	public:
 
-		StreamThreadRtcp(StreamInterface &stream);
+		/// @param retransmitter specifies the packets send to the client, to
+		/// send again when the client reports them lost
+		StreamThreadRtcp(StreamInterface &stream, RtpRetransmitter &retransmitter);
 
 		virtual ~StreamThreadRtcp();
 
@@ -54,12 +57,27 @@ class StreamThreadRtcp :
 
 		/// @see StreamThreadRtcpBase
 		virtual void doSendDataToClient(int clientID,
-			uint8_t *sr,
-			std::size_t srlen,
-			uint8_t *sdes,
-			std::size_t sdeslen,
-			uint8_t *app,
-			std::size_t applen) final;
+			const uint8_t *data,
+			std::size_t len) final;
+
+		/// @see StreamThreadRtcpBase
+		virtual void doReceiveReports(int clientID) final;
+
+		/// @see StreamThreadRtcpBase
+		virtual void doRetransmit(int clientID,
+			const std::vector<uint16_t> &seqs) final;
+
+		// =====================================================================
+		//  -- Data members ----------------------------------------------------
+		// =====================================================================
+	private:
+
+		/// Max reports read in one go, the rest waits for the next interval
+		static constexpr std::size_t MAX_RECEIVE = 16;
+		/// Max size of a received compound RTCP packet
+		static constexpr std::size_t MAX_RECEIVE_LEN = 1500;
+
+		RtpRetransmitter &_retransmitter;
 
 };
 
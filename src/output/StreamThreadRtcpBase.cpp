@@ -20,10 +20,11 @@
 #include <output/StreamThreadRtcpBase.h>
 
 #include <Log.h>
-#include <Stream.h>
-#include <Utils.h>
+#include <StreamClient.h>
+#include <StreamInterface.h>
+#include <base/TimeCounter.h>
+#include <output/RtcpService.h>
 
-#include <chrono>
 #include <cstring>
 
 namespace output {
@@ -38,11 +39,13 @@ StreamThreadRtcpBase::StreamThreadRtcpBase(
 		_clientID(0),
 		_protocol(protocol),
 		_stream(stream),
- 		_thread(
-			"RtcpThread",
-			std::bind(&StreamThreadRtcpBase::threadExecuteFunction, this)) {}
+		_service(nullptr),
+		_appLen(0),
+		_describeVersion(0) {}
 
-StreamThreadRtcpBase::~StreamThreadRtcpBase() {}
+StreamThreadRtcpBase::~StreamThreadRtcpBase() {
+	unschedule();
+}
 
 // =========================================================================
 //  -- Other member functions ----------------------------------------------
@@ -54,20 +57,26 @@ bool StreamThreadRtcpBase::startStreaming(const int clientID) {
 
 	const StreamClient &client = _stream.getStreamClient(clientID);
 
-	if (!_thread.startThread()) {
+	// Render the description again for this session
+	_appLen = 0;
+	_feedback.reset();
+	_service = _stream.getRtcpService();
+	if (_service == nullptr) {
 		SI_LOG_ERROR("Stream: %d, Start %s stream to %s:%d ERROR", _stream.getStreamID(),
 			_protocol.c_str(), client.getIPAddressOfStream().c_str(), getStreamSocketPort(clientID));
 		return false;
 	}
+	_service->add(*this);
 	SI_LOG_INFO("Stream: %d, Start %s stream to %s:%d", _stream.getStreamID(),
 		_protocol.c_str(), client.getIPAddressOfStream().c_str(), getStreamSocketPort(clientID));
 
-	_mon_update = 0;
 	return true;
 }
 
 bool StreamThreadRtcpBase::pauseStreaming(const int clientID) {
-	_thread.pauseThread();
+	if (_service != nullptr) {
+		_service->remove(*this);
+	}
 
 	doPauseStreaming(clientID);
 
@@ -78,7 +87,9 @@ bool StreamThreadRtcpBase::pauseStreaming(const int clientID) {
 }
 
 bool StreamThreadRtcpBase::restartStreaming(const int clientID) {
-	_thread.restartThread();
+	if (_service != nullptr) {
+		_service->add(*this);
+	}
 
 	doRestartStreaming(clientID);
 
@@ -88,88 +99,103 @@ bool StreamThreadRtcpBase::restartStreaming(const int clientID) {
 	return true;
 }
 
-bool StreamThreadRtcpBase::threadExecuteFunction() {
-	// check do we need to update Device monitor signals
-	if (_mon_update == 0) {
-		_stream.getInputDevice()->monitorSignal(false);
-
-		_mon_update = _stream.getRtcpSignalUpdateFrequency();
-	} else {
-		--_mon_update;
+void StreamThreadRtcpBase::unschedule() {
+	if (_service != nullptr) {
+		_service->remove(*this);
+		_service = nullptr;
 	}
+}
+
+void StreamThreadRtcpBase::sendReport() {
+	// The Device monitor signals are updated by the signal monitor thread
+	// of StreamManager, so here we only read the last snapshot
+	const uint32_t ssrc = _stream.getSSRC();
 
 	// RTCP compound packets must start with a SR, SDES then APP
-	std::size_t srlen   = 0;
-	std::size_t sdeslen = 0;
-	std::size_t applen  = 0;
-	uint8_t *sr   = get_sr_packet(&srlen);
-	uint8_t *sdes = get_sdes_packet(&sdeslen);
-	uint8_t *app  = get_app_packet(&applen);
-
-	if (sr != nullptr && sdes != nullptr && app != nullptr) {
-		doSendDataToClient(_clientID, sr, srlen, sdes, sdeslen, app, applen);
-	}
-	DELETE_ARRAY(sr);
-	DELETE_ARRAY(sdes);
-	DELETE_ARRAY(app);
-	std::this_thread::sleep_for(std::chrono::milliseconds(200));
+	updateSRPacket(ssrc);
+	updateSDESPacket(ssrc);
+	updateAPPPacket(ssrc);
 
-	return true;
+	doSendDataToClient(_clientID, _report, APP_OFFSET + _appLen);
+}
+
+void StreamThreadRtcpBase::receiveReports() {
+	doReceiveReports(_clientID);
 }
 
-uint8_t *StreamThreadRtcpBase::get_app_packet(std::size_t *len) {
-	uint8_t app[1024 * 2];
-
-	uint32_t ssrc = _stream.getSSRC();
-
-	// Application Defined packet  (APP Packet)
-	app[0]  = 0x80;                // version: 2, padding: 0, subtype: 0
-	app[1]  = 204;                 // payload type: 204 (0xcc) (APP)
-	app[2]  = 0;                   // length (total in 32-bit words minus one)
-	app[3]  = 0;                   // length (total in 32-bit words minus one)
-	app[4]  = (ssrc >> 24) & 0xff; // synchronization source
-	app[5]  = (ssrc >> 16) & 0xff; // synchronization source
-	app[6]  = (ssrc >>  8) & 0xff; // synchronization source
-	app[7]  = (ssrc >>  0) & 0xff; // synchronization source
-	app[8]  = 'S';                 // name
-	app[9]  = 'E';                 // name
-	app[10] = 'S';                 // name
-	app[11] = '1';                 // name
-	app[12] = 0;                   // identifier (0000)
-	app[13] = 0;                   // identifier
-	app[14] = 0;                   // string length
-	app[15] = 0;                   // string length
-	                               // Now the App defined data is added
-
-	const std::string desc = _stream.attributeDescribeString();
-	const char *attr_desc_str = desc.c_str();
-	std::memcpy(app + 16, attr_desc_str, desc.size());
-
-	// total length and align on 32 bits
-	*len = 16 + desc.size();
-	if ((*len % 4) != 0) {
-		*len += 4 - (*len % 4);
+void StreamThreadRtcpBase::processReport(const uint8_t *data, const std::size_t len) {
+	const bool changed = _feedback.parse(data, len, _stream.getSSRC(),
+		_stream.getRtcpLossThreshold(), _nacked);
+	if (!_nacked.empty()) {
+		doRetransmit(_clientID, _nacked);
 	}
+	if (!changed) {
+		return;
+	}
+	if (_stream.getRtcpAdaptation() >= static_cast<unsigned int>(RtcpFeedback::Adaptation::Alert)) {
+		const StreamClient &client = _stream.getStreamClient(_clientID);
+		if (_feedback.isCongested()) {
+			SI_LOG_INFO("Stream: %d, %s client %s is congested, %u%% lost, jitter %lu us",
+				_stream.getStreamID(), _protocol.c_str(), client.getIPAddressOfStream().c_str(),
+				_feedback.getFractionLost(), _feedback.getJitter());
+		} else {
+			SI_LOG_INFO("Stream: %d, %s client %s recovered, %u%% lost", _stream.getStreamID(),
+				_protocol.c_str(), client.getIPAddressOfStream().c_str(), _feedback.getFractionLost());
+		}
+	}
+}
 
-	// Alloc and copy data and adjust length
-	uint8_t *appPtr = new uint8_t[*len];
-	if (appPtr != nullptr) {
-		std::memcpy(appPtr, app, *len);
-		int ws = (*len / 4) - 1;
-		appPtr[2] = (ws >> 8) & 0xff;
-		appPtr[3] = (ws >> 0) & 0xff;
-		int ss = *len - 16;
-		appPtr[14] = (ss >> 8) & 0xff;
-		appPtr[15] = (ss >> 0) & 0xff;
+void StreamThreadRtcpBase::updateAPPPacket(const uint32_t ssrc) {
+	uint8_t *app = _report + APP_OFFSET;
+
+	const uint64_t version = _stream.getDescribeVersion();
+	if (_appLen == 0 || version != _describeVersion) {
+		// Application Defined packet  (APP Packet)
+		app[0]  = 0x80;                // version: 2, padding: 0, subtype: 0
+		app[1]  = 204;                 // payload type: 204 (0xcc) (APP)
+		app[8]  = 'S';                 // name
+		app[9]  = 'E';                 // name
+		app[10] = 'S';                 // name
+		app[11] = '1';                 // name
+		app[12] = 0;                   // identifier (0000)
+		app[13] = 0;                   // identifier
+		                               // Now the App defined data is added
+
+		const std::string desc = _stream.attributeDescribeString();
+		std::size_t size = desc.size();
+		if (size > MAX_APP_LEN - APP_HEADER_LEN) {
+			size = MAX_APP_LEN - APP_HEADER_LEN;
+		}
+		std::memcpy(app + APP_HEADER_LEN, desc.data(), size);
+
+		// total length and align on 32 bits
+		std::size_t len = APP_HEADER_LEN + size;
+		while ((len % 4) != 0) {
+			app[len++] = 0;
+		}
+		const std::size_t ws = (len / 4) - 1;
+		app[2]  = (ws >> 8) & 0xff;    // length (total in 32-bit words minus one)
+		app[3]  = (ws >> 0) & 0xff;    // length (total in 32-bit words minus one)
+		const std::size_t ss = len - APP_HEADER_LEN;
+		app[14] = (ss >> 8) & 0xff;    // string length
+		app[15] = (ss >> 0) & 0xff;    // string length
+
+		_appLen = len;
+		_describeVersion = version;
 	}
-	return appPtr;
+	app[4]  = (ssrc >> 24) & 0xff;     // synchronization source
+	app[5]  = (ssrc >> 16) & 0xff;     // synchronization source
+	app[6]  = (ssrc >>  8) & 0xff;     // synchronization source
+	app[7]  = (ssrc >>  0) & 0xff;     // synchronization source
 }
 
-uint8_t *StreamThreadRtcpBase::get_sr_packet(std::size_t *len) {
-	uint8_t sr[28];
+void StreamThreadRtcpBase::updateSRPacket(const uint32_t ssrc) {
+	uint8_t *sr = _report + SR_OFFSET;
 
-	long timestamp = _stream.getTimestamp();
-	uint32_t ssrc = _stream.getSSRC();
+	// The NTP and RTP timestamp are of the same moment, from the same clock
+	const uint64_t now = base::TimeCounter::getMonotonicMicros();
+	const uint64_t ntp = base::TimeCounter::getNtpTimestamp(now);
+	const uint32_t timestamp = base::TimeCounter::getRtpTimestamp(now);
 	uint32_t spc = _stream.getSPC();
 	uint32_t soc = _stream.getSOC();
 
@@ -177,23 +203,22 @@ uint8_t *StreamThreadRtcpBase::get_sr_packet(std::size_t *len) {
 	sr[0]  = 0x80;                         // version: 2, padding: 0, sr blocks: 0
 	sr[1]  = 200;                          // payload type: 200 (0xc8) (SR)
 	sr[2]  = 0;                            // length (total in 32-bit words minus one)
-	sr[3]  = 0;                            // length (total in 32-bit words minus one)
+	sr[3]  = (SR_LEN / 4) - 1;             // length (total in 32-bit words minus one)
 	sr[4]  = (ssrc >> 24) & 0xff;          // synchronization source
 	sr[5]  = (ssrc >> 16) & 0xff;          // synchronization source
 	sr[6]  = (ssrc >>  8) & 0xff;          // synchronization source
 	sr[7]  = (ssrc >>  0) & 0xff;          // synchronization source
 
-	const std::time_t ntp = std::time(nullptr);
 	                                       // NTP integer part
-	sr[8]  = (ntp >> 24) & 0xff;           // NTP most sign word
-	sr[9]  = (ntp >> 16) & 0xff;           // NTP most sign word
-	sr[10] = (ntp >>  8) & 0xff;           // NTP most sign word
-	sr[11] = (ntp >>  0) & 0xff;           // NTP most sign word
+	sr[8]  = (ntp >> 56) & 0xff;           // NTP most sign word
+	sr[9]  = (ntp >> 48) & 0xff;           // NTP most sign word
+	sr[10] = (ntp >> 40) & 0xff;           // NTP most sign word
+	sr[11] = (ntp >> 32) & 0xff;           // NTP most sign word
 	                                       // NTP fractional part
-	sr[12] = 0;                            // NTP least sign word
-	sr[13] = 0;                            // NTP least sign word
-	sr[14] = 0;                            // NTP least sign word
-	sr[15] = 0;                            // NTP least sign word
+	sr[12] = (ntp >> 24) & 0xff;           // NTP least sign word
+	sr[13] = (ntp >> 16) & 0xff;           // NTP least sign word
+	sr[14] = (ntp >>  8) & 0xff;           // NTP least sign word
+	sr[15] = (ntp >>  0) & 0xff;           // NTP least sign word
 
 	sr[16] = (timestamp >> 24) & 0xff;     // RTP timestamp RTS
 	sr[17] = (timestamp >> 16) & 0xff;     // RTP timestamp RTS
@@ -207,29 +232,16 @@ uint8_t *StreamThreadRtcpBase::get_sr_packet(std::size_t *len) {
 	sr[25] = (soc >> 16) & 0xff;           // sender's octet count SOC
 	sr[26] = (soc >>  8) & 0xff;           // sender's octet count SOC
 	sr[27] = (soc >>  0) & 0xff;           // sender's octet count SOC
-
-	*len = sizeof(sr);
-
-	// Alloc and copy data and adjust length
-	uint8_t *srPtr = new uint8_t[*len];
-	if (srPtr != nullptr) {
-		std::memcpy(srPtr, sr, sizeof(sr));
-		int ws = (*len / 4) - 1;
-		srPtr[2] = (ws >> 8) & 0xff;
-		srPtr[3] = (ws >> 0) & 0xff;
-	}
-	return srPtr;
 }
 
-uint8_t *StreamThreadRtcpBase::get_sdes_packet(std::size_t *len) {
-	uint8_t sdes[20];
-	uint32_t ssrc = _stream.getSSRC();
+void StreamThreadRtcpBase::updateSDESPacket(const uint32_t ssrc) {
+	uint8_t *sdes = _report + SDES_OFFSET;
 
 	// Source Description (SDES Packet)
 	sdes[0]  = 0x81;                           // version: 2, padding: 0, sc blocks: 1
 	sdes[1]  = 202;                            // payload type: 202 (0xca) (SDES)
 	sdes[2]  = 0;                              // length (total in 32-bit words minus one)
-	sdes[3]  = 3;                              // length (total in 32-bit words minus one)
+	sdes[3]  = (SDES_LEN / 4) - 1;             // length (total in 32-bit words minus one)
 
 	sdes[4]  = (ssrc >> 24) & 0xff;            // synchronization source
 	sdes[5]  = (ssrc >> 16) & 0xff;            // synchronization source
@@ -250,18 +262,6 @@ uint8_t *StreamThreadRtcpBase::get_sdes_packet(std::size_t *len) {
 	sdes[17] = 0;                              // data
 	sdes[18] = 0;                              // data
 	sdes[19] = 0;                              // data
-
-	*len = sizeof(sdes);
-
-	// Alloc and copy data and adjust length
-	uint8_t *sdesPtr = new uint8_t[*len];
-	if (sdesPtr != nullptr) {
-		std::memcpy(sdesPtr, sdes, sizeof(sdes));
-		int ws = (*len / 4) - 1;
-		sdesPtr[2] = (ws >> 8) & 0xff;
-		sdesPtr[3] = (ws >> 0) & 0xff;
-	}
-	return sdesPtr;
 }
 
 }
@@ -22,15 +22,20 @@
 
 #include <FwDecl.h>
 #include <Unused.h>
-#include <base/Thread.h>
+#include <output/RtcpFeedback.h>
 
+#include <cstddef>
 #include <cstdint>
+#include <string>
+#include <vector>
 
 FW_DECL_NS0(StreamInterface);
+FW_DECL_NS1(output, RtcpService);
 
 namespace output {
 
-/// The base class for RTCP Server
+/// The base class for RTCP Server. The reports are send by the
+/// @c RtcpService, they are composed in a buffer of this session.
 class StreamThreadRtcpBase {
 		// =====================================================================
 		//  -- Constructors and destructor -------------------------------------
@@ -63,21 +68,44 @@ class StreamThreadRtcpBase {
 		/// @return true if stream is restarted else false on error
 		bool restartStreaming(int clientID);
 
+		/// Compose the compound RTCP report (SR, SDES and APP) and send it to
+		/// the client, this is called by the @c RtcpService every report interval
+		void sendReport();
+
+		/// Receive the RTCP reports the client send back, this is called by
+		/// the @c RtcpService every slot of the report interval
+		void receiveReports();
+
+		/// Process a compound RTCP packet the client send back
+		void processReport(const uint8_t *data, std::size_t len);
+
+		/// Get the reports the client send back about this stream
+		const RtcpFeedback &getFeedback() const {
+			return _feedback;
+		}
+
 	protected:
 
-		/// Thread execute function @see base::Thread should @return true to
-		/// keep thread running a @return false will stop and then terminate this thread
-		bool threadExecuteFunction();
+		/// Stop sending reports, derived classes should call this before
+		/// they close their socket
+		void unschedule();
 
 		/// Returns the socket port for the specified client
 		/// @param clientID specifies which client the port id requested
 		/// @return the socket port for ex. to data send to
 		virtual int getStreamSocketPort(int UNUSED(clientID)) const { return 0; }
 
-		///
-		uint8_t *get_app_packet(std::size_t *len);
-		uint8_t *get_sdes_packet(std::size_t *len);
-		uint8_t *get_sr_packet(std::size_t *len);
+	private:
+
+		/// Update the Sender Report in the report buffer
+		void updateSRPacket(uint32_t ssrc);
+
+		/// Update the Source Description in the report buffer
+		void updateSDESPacket(uint32_t ssrc);
+
+		/// Update the Application Defined packet in the report buffer, the
+		/// description is only rendered again when it may have changed
+		void updateAPPPacket(uint32_t ssrc);
 
 	private:
 
@@ -90,25 +118,53 @@ class StreamThreadRtcpBase {
 		/// Specialization for @see restartStreaming
 		virtual void doRestartStreaming(int UNUSED(clientID)) {}
 
-		/// Specialization for @see threadExecuteFunction to send data to client
+		/// Specialization for @see sendReport to send the report to client
+		/// @param data specifies the compound RTCP report, it is only valid
+		/// during this call
 		virtual void doSendDataToClient(int UNUSED(clientID),
-			uint8_t *UNUSED(sr),
-			std::size_t UNUSED(srlen),
-			uint8_t *UNUSED(sdes),
-			std::size_t UNUSED(sdeslen),
-			uint8_t *UNUSED(app),
-			std::size_t UNUSED(applen)) {}
+			const uint8_t *UNUSED(data),
+			std::size_t UNUSED(len)) {}
+
+		/// Specialization for @see receiveReports to read the reports of
+		/// client, without waiting, and pass them to @see processReport
+		virtual void doReceiveReports(int UNUSED(clientID)) {}
+
+		/// Specialization for @see processReport to send the packets the
+		/// client reported lost again
+		/// @param seqs specifies the sequence numbers of the lost packets
+		virtual void doRetransmit(int UNUSED(clientID),
+			const std::vector<uint16_t> &UNUSED(seqs)) {}
 
 		// =====================================================================
 		//  -- Data members ----------------------------------------------------
 		// =====================================================================
+	private:
+
+		static constexpr std::size_t SR_LEN = 28;
+		static constexpr std::size_t SDES_LEN = 20;
+		static constexpr std::size_t APP_HEADER_LEN = 16;
+		static constexpr std::size_t MAX_APP_LEN = 2048;
+		static constexpr std::size_t SR_OFFSET = 0;
+		static constexpr std::size_t SDES_OFFSET = SR_OFFSET + SR_LEN;
+		static constexpr std::size_t APP_OFFSET = SDES_OFFSET + SDES_LEN;
+
 	protected:
 
+		/// Max size of a compound RTCP report
+		static constexpr std::size_t MAX_REPORT_LEN = APP_OFFSET + MAX_APP_LEN;
+
 		int _clientID;
 		std::string _protocol;
 		StreamInterface &_stream;
-		int _mon_update;
-		base::Thread _thread;
+
+	private:
+
+		RtcpService *_service;           /// the service sending the reports, if started
+		uint8_t _report[MAX_REPORT_LEN]; /// RTCP compound packets SR, SDES then APP
+		std::size_t _appLen;             /// 0 when the APP packet is not rendered yet
+		uint64_t _describeVersion;       /// version of the rendered description
+		RtcpFeedback _feedback;
+		std::vector<uint16_t> _nacked;   /// lost packets of the last report
 };
 
 }
@@ -22,6 +22,9 @@
 #include <StreamClient.h>
 #include <Stream.h>
 #include <Log.h>
+#include <output/TcpSink.h>
+
+#include <cstring>
 
 #include <sys/uio.h>
 
@@ -32,10 +35,11 @@ namespace output {
 // =============================================================================
 
 StreamThreadRtcpTcp::StreamThreadRtcpTcp(StreamInterface &stream) :
-		StreamThreadRtcpBase("RTCP/TCP", stream) {}
+		StreamThreadRtcpBase("RTCP/TCP", stream),
+		_packetLen(0) {}
 
 StreamThreadRtcpTcp::~StreamThreadRtcpTcp() {
-	_thread.terminateThread();
+	unschedule();
 	const int streamID = _stream.getStreamID();
 	const StreamClient &client = _stream.getStreamClient(_clientID);
 	SI_LOG_INFO("Stream: %d, Destroy %s stream to %s:%d", streamID,
@@ -50,35 +54,40 @@ int StreamThreadRtcpTcp::getStreamSocketPort(const int clientID) const {
 	return  _stream.getStreamClient(clientID).getHttpSocketPort();
 }
 
-void StreamThreadRtcpTcp::doSendDataToClient(const int clientID,
-	uint8_t *sr, const std::size_t srlen,
-	uint8_t *sdes, const std::size_t sdeslen,
-	uint8_t *app, const std::size_t applen) {
-	StreamClient &client = _stream.getStreamClient(clientID);
-
-	const std::size_t len = srlen + sdeslen + applen;
-
-	unsigned char header[4];
-	header[0] = 0x24;
-	header[1] = 0x01;
-	header[2] = (len >> 8) & 0xFF;
-	header[3] = (len >> 0) & 0xFF;
-
-	iovec iov[4];
-	iov[0].iov_base = header;
-	iov[0].iov_len = 4;
-	iov[1].iov_base = sr;
-	iov[1].iov_len = srlen;
-	iov[2].iov_base = sdes;
-	iov[2].iov_len = sdeslen;
-	iov[3].iov_base = app;
-	iov[3].iov_len = applen;
+void StreamThreadRtcpTcp::doSendDataToClient(const int UNUSED(clientID),
+	const uint8_t *data, const std::size_t len) {
+	base::MutexLock lock(_mutex);
+	_packet[0] = 0x24;
+	_packet[1] = 0x01;
+	_packet[2] = (len >> 8) & 0xFF;
+	_packet[3] = (len >> 0) & 0xFF;
+	std::memcpy(_packet + 4, data, len);
+	_packetLen = len + 4;
+}
+
+// =============================================================================
+//  -- Other member functions --------------------------------------------------
+// =============================================================================
+
+bool StreamThreadRtcpTcp::writeReport(TcpSink &sink, StreamClient &client) {
+	base::MutexLock lock(_mutex);
+	if (_packetLen == 0) {
+		return true;
+	}
+	iovec iov;
+	iov.iov_base = _packet;
+	iov.iov_len = _packetLen;
+	const std::size_t packetSize = _packetLen;
+	_packetLen = 0;
 
 	// send the RTCP/TCP packet
-	if (!client.writeHttpData(iov, 4)) {
+	// It is copied to the backlog if the client can not take it now
+	if (!sink.write(client, &iov, 1, &packetSize, 1, nullptr, 0)) {
 		SI_LOG_ERROR("Stream: %d, Error sending %s Stream Data to %s",
 			_stream.getStreamID(), _protocol.c_str(), client.getIPAddressOfStream().c_str());
+		return false;
 	}
+	return true;
 }
 
 }
@@ -21,13 +21,18 @@
 #define OUTPUT_STREAMTHREADRTCP_TCP_H_INCLUDE OUTPUT_STREAMTHREADRTCP_TCP_H_INCLUDE
 
 #include <FwDecl.h>
+#include <base/Mutex.h>
 #include <output/StreamThreadRtcpBase.h>
 
+FW_DECL_NS0(StreamClient);
 FW_DECL_NS0(StreamInterface);
+FW_DECL_NS1(output, TcpSink);
 
 namespace output {
 
-/// RTCP Server over TCP
+/// RTCP Server over TCP. The report is written by the RTP/TCP stream
+/// thread with @see writeReport, so it is interleaved between complete
+/// RTP packets and the @c RtcpService never waits on a slow client.
 class StreamThreadRtcpTcp :
 	public StreamThreadRtcpBase {
 		// =====================================================================
@@ -39,6 +44,16 @@ class StreamThreadRtcpTcp :
 
 		virtual ~StreamThreadRtcpTcp();
 
+		// =====================================================================
+		//  -- Other member functions ------------------------------------------
+		// =====================================================================
+	public:
+
+		/// Write the last report, if it is not written yet, to the client
+		/// @param sink specifies the sink the RTP/TCP packets are written with
+		/// @return false if the client has an error or is disconnected
+		bool writeReport(TcpSink &sink, StreamClient &client);
+
 		// =====================================================================
 		//  -- output::StreamThreadRtcpBase ------------------------------------
 		// =====================================================================
@@ -51,13 +66,17 @@ class StreamThreadRtcpTcp :
 
 		/// @see StreamThreadRtcpBase
 		virtual void doSendDataToClient(int clientID,
-			uint8_t *sr,
-			std::size_t srlen,
-			uint8_t *sdes,
-			std::size_t sdeslen,
-			uint8_t *app,
-			std::size_t applen) final;
+			const uint8_t *data,
+			std::size_t len) final;
+
+		// =====================================================================
+		//  -- Data members ----------------------------------------------------
+		// =====================================================================
+	private:
 
+		base::Mutex _mutex;
+		unsigned char _packet[4 + MAX_REPORT_LEN]; /// interleave header and report
+		std::size_t _packetLen;                    /// 0 if there is no report to write
 };
 
 }
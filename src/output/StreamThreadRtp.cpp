@@ -24,16 +24,37 @@
 #include <StreamInterface.h>
 #include <InterfaceAttr.h>
 #include <base/TimeCounter.h>
+#include <mpegts/PidTable.h>
+#include <output/EgressRing.h>
+
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <sstream>
+
+#include <sys/uio.h>
 
 namespace output {
 
+/// A full socket buffer drops the datagram, like the network would
+static bool isSocketBufferFull(const int err) {
+	return err == EAGAIN || err == EWOULDBLOCK || err == ENOBUFS;
+}
+
 // =============================================================================
 // -- Constructors and destructor ----------------------------------------------
 // =============================================================================
 
 StreamThreadRtp::StreamThreadRtp(StreamInterface &stream) :
 	StreamThreadBase("RTP/UDP", stream),
-	_rtcp(stream) {}
+	_rtcp(stream, _retransmitter),
+	_datagramBuffers(1),
+	_batchSize(1),
+	_gso(false),
+	_lowPriorityPIDs(mpegts::PidTable::MAX_PIDS, false),
+	_ring(nullptr),
+	_ringFile(-1) {}
 
 StreamThreadRtp::~StreamThreadRtp() {
 	terminateThread();
@@ -41,13 +62,62 @@ StreamThreadRtp::~StreamThreadRtp() {
 	StreamClient &client = _stream.getStreamClient(_clientID);
 	SI_LOG_INFO("Stream: %d, Destroy %s stream to %s:%d", streamID, _protocol.c_str(),
 		client.getIPAddressOfStream().c_str(), getStreamSocketPort(_clientID));
+	if (_ringFile != -1) {
+		_ring->removeFile(_ringFile);
+	}
 	client.getRtpSocketAttr().closeFD();
+	for (const SharedClient &shared : _sharedClients) {
+		_stream.getStreamClient(shared.clientID).getRtpSocketAttr().closeFD();
+	}
 }
 
 // =============================================================================
 //  -- output::StreamThreadBase ------------------------------------------------
 // =============================================================================
 
+bool StreamThreadRtp::addSharedClient(const int clientID) {
+	base::MutexLock lock(_sharedMutex);
+	for (const SharedClient &shared : _sharedClients) {
+		if (shared.clientID == clientID) {
+			return true;
+		}
+	}
+	const int streamID = _stream.getStreamID();
+	StreamClient &client = _stream.getStreamClient(clientID);
+	SocketAttr &rtp = client.getRtpSocketAttr();
+	if (!rtp.setupSocketHandle(SOCK_DGRAM, IPPROTO_UDP)) {
+		SI_LOG_ERROR("Stream: %d, Get RTP handle for StreamClient[%d] failed", streamID, clientID);
+		return false;
+	}
+	rtp.setNetworkSendBufferSize(rtp.getNetworkSendBufferSize() * 20);
+
+	// Each shared client is its own RTP session, so give it an own SSRC
+	std::random_device rd;
+	SharedClient shared;
+	shared.clientID = clientID;
+	shared.cseq = 0;
+	mpegts::PacketBuffer::initializeRTPHeader(shared.header, rd(), 0);
+	_sharedClients.push_back(shared);
+
+	SI_LOG_INFO("Stream: %d, Start shared %s stream to %s:%d", streamID, _protocol.c_str(),
+		client.getIPAddressOfStream().c_str(), rtp.getSocketPort());
+	return true;
+}
+
+void StreamThreadRtp::removeSharedClient(const int clientID) {
+	base::MutexLock lock(_sharedMutex);
+	for (std::vector<SharedClient>::iterator it = _sharedClients.begin(); it != _sharedClients.end(); ++it) {
+		if (it->clientID == clientID) {
+			SocketAttr &rtp = _stream.getStreamClient(clientID).getRtpSocketAttr();
+			SI_LOG_INFO("Stream: %d, Stop shared %s stream to %s:%d", _stream.getStreamID(),
+				_protocol.c_str(), rtp.getIPAddressOfSocket().c_str(), rtp.getSocketPort());
+			rtp.closeFD();
+			_sharedClients.erase(it);
+			return;
+		}
+	}
+}
+
 void StreamThreadRtp::doStartStreaming(const int clientID) {
 	const int streamID = _stream.getStreamID();
 	SocketAttr &rtp = _stream.getStreamClient(clientID).getRtpSocketAttr();
@@ -63,6 +133,18 @@ void StreamThreadRtp::doStartStreaming(const int clientID) {
 	SI_LOG_INFO("Stream: %d, %s set network buffer size: %d KBytes", streamID,
 		_protocol.c_str(), bufferSize / 1024);
 
+	updateBatchSize();
+
+	// Queue the sends on the io_uring of all streams, if there is one
+	_ring = _stream.getEgressRing();
+	if (_ring != nullptr && _ringFile == -1) {
+		_ringFile = _ring->addFile(rtp.getFD());
+		if (_ringFile == -1) {
+			SI_LOG_ERROR("Stream: %d, %s add to EgressRing failed, sending without it",
+				streamID, _protocol.c_str());
+		}
+	}
+
 	// RTCP
 	_rtcp.startStreaming(clientID);
 }
@@ -73,6 +155,8 @@ void StreamThreadRtp::doPauseStreaming(const int clientID) {
 }
 
 void StreamThreadRtp::doRestartStreaming(const int clientID) {
+	updateBatchSize();
+
 	// RTCP
 	_rtcp.restartStreaming(clientID);
 }
@@ -81,29 +165,334 @@ int StreamThreadRtp::getStreamSocketPort(const int clientID) const {
 	return  _stream.getStreamClient(clientID).getRtpSocketAttr().getSocketPort();
 }
 
-bool StreamThreadRtp::writeDataToOutputDevice(mpegts::PacketBuffer &buffer, StreamClient &client) {
-	// update sequence number and timestamp
-	const long timestamp = base::TimeCounter::getTicks() * 90;
-	++_cseq;
-	buffer.tagRTPHeaderWith(_cseq, timestamp);
+bool StreamThreadRtp::writeDataToOutputDevice(
+		mpegts::PacketBuffer *const *buffers,
+		const std::size_t n,
+		StreamClient &client) {
+	// update timestamp, once for the whole batch
+	const long timestamp = base::TimeCounter::getRtpTimestamp();
 
-	static constexpr size_t dataSize = buffer.getBufferSize();
-	static constexpr size_t len = dataSize + mpegts::PacketBuffer::RTP_HEADER_LEN;
+	static constexpr size_t dataSize = mpegts::PacketBuffer::getBufferSize();
 
-	// RTP packet octet count (Bytes)
-	_stream.addRtpData(dataSize, timestamp);
+	// Each datagram is the RTP header of its first buffer followed by the
+	// TS packets of its buffers
+	struct iovec iov[MAX_SEND_BUF];
+	struct mmsghdr msgs[MAX_SEND_BUF];
+	unsigned int vlen = 0;
+	for (std::size_t i = 0; i < n; i += _datagramBuffers) {
+		const std::size_t count = (n - i < _datagramBuffers) ? n - i : _datagramBuffers;
+		++_cseq;
+		buffers[i]->tagRTPHeaderWith(_cseq, timestamp);
+		iov[i].iov_base = buffers[i]->getReadBufferPtr();
+		iov[i].iov_len = dataSize + mpegts::PacketBuffer::RTP_HEADER_LEN;
+		for (std::size_t j = 1; j < count; ++j) {
+			iov[i + j].iov_base = buffers[i + j]->getTSReadBufferPtr();
+			iov[i + j].iov_len = dataSize;
+		}
+		std::memset(&msgs[vlen], 0, sizeof(msgs[vlen]));
+		msgs[vlen].msg_hdr.msg_iov = &iov[i];
+		msgs[vlen].msg_hdr.msg_iovlen = count;
+		++vlen;
+	}
 
-	// send the RTP/UDP packet
-	const unsigned char *rtpBuffer = buffer.getReadBufferPtr();
+	// The device delivers the PIDs of the shared clients as well, so the
+	// owner then only gets the ones it requested
+	bool shared;
+	{
+		base::MutexLock lock(_sharedMutex);
+		shared = !_sharedClients.empty();
+	}
 	SocketAttr &rtp = client.getRtpSocketAttr();
-	if (!rtp.sendDataTo(rtpBuffer, len, MSG_DONTWAIT)) {
+	bool error = false;
+	const bool dropping = isDroppingPIDs();
+	if (dropping || shared) {
+		error = !writeReducedData(client, buffers, n, timestamp, dropping);
+	} else {
+		// RTP packet octet count (Bytes)
+		_stream.addRtpData(vlen, dataSize * n, timestamp);
+		// keep a copy, to send again when the client reports it lost
+		_retransmitter.add(msgs, vlen);
+		if (_ringFile != -1) {
+			// queue the RTP/UDP packets, what does not fit is dropped like a
+			// full socket buffer would
+			const std::size_t queued = writeDataToRing(rtp, buffers, iov, n, vlen, error) * _datagramBuffers;
+			if (!error && queued < n) {
+				_stream.addDroppedPackets((n - queued) * mpegts::PacketBuffer::getNumberOfTSPackets());
+			}
+		} else {
+			// send the RTP/UDP packets, what GSO did not send goes with sendmmsg
+			unsigned int send = 0;
+			if (_gso) {
+				send = writeSegmentedData(rtp, iov, n, vlen, error);
+			}
+			if (!error && send < vlen) {
+				const int sent = rtp.sendDataTo(&msgs[send], vlen - send, MSG_DONTWAIT);
+				if (sent == -1) {
+					error = true;
+				} else if (send + sent < vlen) {
+					_stream.addDroppedPackets((n - (send + sent) * _datagramBuffers) *
+						mpegts::PacketBuffer::getNumberOfTSPackets());
+				}
+			}
+		}
+	}
+	if (error) {
 		if (!client.isSelfDestructing()) {
 			SI_LOG_ERROR("Stream: %d, Error sending RTP/UDP data to %s:%d", _stream.getStreamID(),
 				rtp.getIPAddressOfSocket().c_str(), rtp.getSocketPort());
 			client.selfDestruct();
 		}
 	}
+	for (std::size_t i = 0; i < n; ++i) {
+		writeDataToSharedClients(*buffers[i], timestamp);
+	}
 	return true;
 }
 
+unsigned int StreamThreadRtp::getTSPacketsPerSend() const {
+	return _datagramBuffers * _batchSize * mpegts::PacketBuffer::getNumberOfTSPackets();
+}
+
+unsigned int StreamThreadRtp::getSendHoldTime() const {
+	return _stream.getRtpBatchHold();
+}
+
+// =============================================================================
+//  -- Other member functions --------------------------------------------------
+// =============================================================================
+
+void StreamThreadRtp::updateBatchSize() {
+	const std::size_t buffers = _stream.getRtpTSPackets() / mpegts::PacketBuffer::getNumberOfTSPackets();
+	_datagramBuffers = (buffers < 1) ? 1 : (buffers > MAX_DATAGRAM_BUF) ? MAX_DATAGRAM_BUF : buffers;
+	const std::size_t batchSize = _stream.getRtpBatchSize();
+	_batchSize = (batchSize < 1) ? 1 : batchSize;
+	_gso = _stream.isRtpGSOEnabled();
+
+	_retransmitter.reset(_stream.isRtpRetransmitEnabled(), _stream.getRtpRetransmitWindow(),
+		_stream.getRtpRetransmitMemory(), _stream.getRtpRetransmitRate(), getSegmentSize());
+
+	_lowPriorityPIDs.assign(mpegts::PidTable::MAX_PIDS, false);
+	std::istringstream pids(_stream.getRtcpLowPriorityPIDs());
+	std::string pid;
+	while (std::getline(pids, pid, ',')) {
+		const int p = std::atoi(pid.c_str());
+		if (p >= 0 && p < static_cast<int>(mpegts::PidTable::ALL_PIDS)) {
+			_lowPriorityPIDs[p] = true;
+		}
+	}
+}
+
+bool StreamThreadRtp::isDroppingPIDs() const {
+	return _rtcp.getFeedback().isCongested() &&
+		_stream.getRtcpAdaptation() >= static_cast<unsigned int>(RtcpFeedback::Adaptation::DropPIDs);
+}
+
+bool StreamThreadRtp::writeReducedData(
+		StreamClient &client,
+		mpegts::PacketBuffer *const *buffers,
+		const std::size_t n,
+		const long timestamp,
+		const bool dropping) {
+	static constexpr std::size_t numberOfPackets = mpegts::PacketBuffer::getNumberOfTSPackets();
+	static constexpr std::size_t packetSize = mpegts::PacketBuffer::TS_PACKET_SIZE;
+
+	// Each datagram keeps its RTP header, also when all its TS packets are
+	// dropped, so the client does not see the dropped PIDs as lost packets
+	struct iovec iov[MAX_SEND_BUF * (numberOfPackets + 1)];
+	struct mmsghdr msgs[MAX_SEND_BUF];
+	std::size_t iovcnt = 0;
+	std::size_t bytes = 0;
+	uint32_t dropped = 0;
+	unsigned int vlen = 0;
+	for (std::size_t i = 0; i < n; i += _datagramBuffers) {
+		const std::size_t count = (n - i < _datagramBuffers) ? n - i : _datagramBuffers;
+		const std::size_t first = iovcnt;
+		iov[iovcnt].iov_base = buffers[i]->getReadBufferPtr();
+		iov[iovcnt].iov_len = mpegts::PacketBuffer::RTP_HEADER_LEN;
+		++iovcnt;
+		for (std::size_t j = 0; j < count; ++j) {
+			for (std::size_t k = 0; k < numberOfPackets; ++k) {
+				unsigned char *ts = buffers[i + j]->getTSPacketPtr(k);
+				const int pid = ((ts[1] & 0x1f) << 8) | ts[2];
+				if (!client.isPIDRequested(pid)) {
+					continue;
+				}
+				if (dropping && _lowPriorityPIDs[pid]) {
+					++dropped;
+					continue;
+				}
+				bytes += packetSize;
+				// Join with the previous entry when it ends at this TS packet
+				if (static_cast<unsigned char *>(iov[iovcnt - 1].iov_base) + iov[iovcnt - 1].iov_len == ts) {
+					iov[iovcnt - 1].iov_len += packetSize;
+				} else {
+					iov[iovcnt].iov_base = ts;
+					iov[iovcnt].iov_len = packetSize;
+					++iovcnt;
+				}
+			}
+		}
+		std::memset(&msgs[vlen], 0, sizeof(msgs[vlen]));
+		msgs[vlen].msg_hdr.msg_iov = &iov[first];
+		msgs[vlen].msg_hdr.msg_iovlen = iovcnt - first;
+		++vlen;
+	}
+	_stream.addRtpData(vlen, bytes, timestamp);
+	_retransmitter.add(msgs, vlen);
+	const int sent = client.getRtpSocketAttr().sendDataTo(msgs, vlen, MSG_DONTWAIT);
+	if (sent == -1) {
+		return false;
+	}
+	// The TS packets of the datagrams that did not fit the socket buffer
+	for (unsigned int i = sent; i < vlen; ++i) {
+		const struct msghdr &msg = msgs[i].msg_hdr;
+		std::size_t len = 0;
+		for (std::size_t j = 0; j < msg.msg_iovlen; ++j) {
+			len += msg.msg_iov[j].iov_len;
+		}
+		dropped += (len - mpegts::PacketBuffer::RTP_HEADER_LEN) / packetSize;
+	}
+	if (dropped > 0) {
+		_stream.addDroppedPackets(dropped);
+	}
+	return true;
+}
+
+unsigned int StreamThreadRtp::writeSegmentedData(
+		SocketAttr &rtp,
+		const struct iovec *iov,
+		const std::size_t n,
+		const unsigned int vlen,
+		bool &error) {
+	const std::size_t segmentSize = getSegmentSize();
+	const unsigned int maxSegments = getMaxSegments();
+	unsigned int send = 0;
+	while (send < vlen) {
+		const unsigned int segments = (vlen - send < maxSegments) ? vlen - send : maxSegments;
+		const std::size_t first = send * _datagramBuffers;
+		const std::size_t last = (send + segments) * _datagramBuffers;
+		const std::size_t iovcnt = ((last < n) ? last : n) - first;
+		if (!rtp.sendSegmentedDataTo(&iov[first], iovcnt, segmentSize, MSG_DONTWAIT)) {
+			if (isSocketBufferFull(errno)) {
+				// Drop this segment group and go on with the next one
+				_stream.addDroppedPackets(iovcnt * mpegts::PacketBuffer::getNumberOfTSPackets());
+				send += segments;
+				continue;
+			} else if (errno == EINVAL || errno == EIO || errno == ENOPROTOOPT || errno == EOPNOTSUPP) {
+				// Kernel, route or NIC can not do it, so never try again
+				SI_LOG_INFO("Stream: %d, %s GSO rejected: %s, fall back to sendmmsg",
+					_stream.getStreamID(), _protocol.c_str(), strerror(errno));
+				_gso = false;
+			} else {
+				PERROR("sendmsg GSO");
+				error = true;
+			}
+			break;
+		}
+		send += segments;
+	}
+	return send;
+}
+
+unsigned int StreamThreadRtp::writeDataToRing(
+		SocketAttr &rtp,
+		mpegts::PacketBuffer *const *buffers,
+		const struct iovec *iov,
+		const std::size_t n,
+		const unsigned int vlen,
+		bool &error) {
+	// The sends queued before completed in the mean time
+	bool segmented;
+	const int ringError = _ring->getError(_ringFile, segmented);
+	if (ringError != 0) {
+		if (segmented && (ringError == EINVAL || ringError == EIO ||
+				ringError == ENOPROTOOPT || ringError == EOPNOTSUPP)) {
+			SI_LOG_INFO("Stream: %d, %s GSO rejected: %s, fall back to single datagrams",
+				_stream.getStreamID(), _protocol.c_str(), strerror(ringError));
+			_gso = false;
+		} else {
+			SI_LOG_ERROR("Stream: %d, %s EgressRing send failed: %s",
+				_stream.getStreamID(), _protocol.c_str(), strerror(ringError));
+			error = true;
+			return 0;
+		}
+	}
+	const std::size_t segmentSize = getSegmentSize();
+	const unsigned int maxSegments = _gso ? getMaxSegments() : 1;
+	const struct sockaddr_in &addr = rtp.getSocketAddress();
+	unsigned int send = 0;
+	while (send < vlen) {
+		const unsigned int segments = (vlen - send < maxSegments) ? vlen - send : maxSegments;
+		const std::size_t first = send * _datagramBuffers;
+		const std::size_t last = (send + segments) * _datagramBuffers;
+		const std::size_t iovcnt = ((last < n) ? last : n) - first;
+		if (!_ring->sendTo(_ringFile, addr, &iov[first], iovcnt,
+				(segments > 1) ? segmentSize : 0, &buffers[first], iovcnt)) {
+			break;
+		}
+		send += segments;
+	}
+	return send;
+}
+
+std::size_t StreamThreadRtp::getSegmentSize() const {
+	// All datagrams have the same size, only the last one may be smaller
+	return _datagramBuffers * mpegts::PacketBuffer::getBufferSize() +
+		mpegts::PacketBuffer::RTP_HEADER_LEN;
+}
+
+unsigned int StreamThreadRtp::getMaxSegments() const {
+	const std::size_t fit = MAX_GSO_SIZE / getSegmentSize();
+	return (fit < MAX_GSO_SEGMENTS) ? fit : MAX_GSO_SEGMENTS;
+}
+
+void StreamThreadRtp::writeDataToSharedClients(mpegts::PacketBuffer &buffer, const long timestamp) {
+	base::MutexLock lock(_sharedMutex);
+	static constexpr std::size_t numberOfPackets = mpegts::PacketBuffer::getNumberOfTSPackets();
+	static constexpr std::size_t packetSize = mpegts::PacketBuffer::TS_PACKET_SIZE;
+	for (SharedClient &shared : _sharedClients) {
+		StreamClient &client = _stream.getStreamClient(shared.clientID);
+		// Point into the TS packets of the buffer, joining consecutive
+		// packets of requested PIDs, so nothing is copied
+		struct iovec iov[numberOfPackets + 1];
+		iov[0].iov_base = shared.header;
+		iov[0].iov_len = mpegts::PacketBuffer::RTP_HEADER_LEN;
+		int iovcnt = 1;
+		uint32_t packets = 0;
+		bool previous = false;
+		for (std::size_t i = 0; i < numberOfPackets; ++i) {
+			unsigned char *ts = buffer.getTSPacketPtr(i);
+			const int pid = ((ts[1] & 0x1f) << 8) | ts[2];
+			if (!client.isPIDRequested(pid)) {
+				previous = false;
+				continue;
+			}
+			++packets;
+			if (previous) {
+				iov[iovcnt - 1].iov_len += packetSize;
+			} else {
+				iov[iovcnt].iov_base = ts;
+				iov[iovcnt].iov_len = packetSize;
+				++iovcnt;
+				previous = true;
+			}
+		}
+		if (iovcnt == 1) {
+			continue;
+		}
+		++shared.cseq;
+		mpegts::PacketBuffer::tagRTPHeader(shared.header, shared.cseq, timestamp);
+		SocketAttr &rtp = client.getRtpSocketAttr();
+		if (!rtp.sendDataTo(iov, iovcnt, MSG_DONTWAIT)) {
+			if (isSocketBufferFull(errno)) {
+				_stream.addDroppedPackets(packets);
+			} else if (!client.isSelfDestructing()) {
+				SI_LOG_ERROR("Stream: %d, Error sending RTP/UDP data to %s:%d", _stream.getStreamID(),
+					rtp.getIPAddressOfSocket().c_str(), rtp.getSocketPort());
+				client.selfDestruct();
+			}
+		}
+	}
+}
+
 } // namespace output
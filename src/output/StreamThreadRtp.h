@@ -21,11 +21,20 @@
 #define OUTPUT_STREAMTHREADRTP_H_INCLUDE OUTPUT_STREAMTHREADRTP_H_INCLUDE
 
 #include <FwDecl.h>
+#include <base/Mutex.h>
+#include <mpegts/PacketBuffer.h>
+#include <output/RtpRetransmitter.h>
 #include <output/StreamThreadBase.h>
 #include <output/StreamThreadRtcp.h>
 
+#include <vector>
+
+#include <sys/uio.h>
+
+FW_DECL_NS0(SocketAttr);
 FW_DECL_NS0(StreamClient);
 FW_DECL_NS0(StreamInterface);
+FW_DECL_NS1(output, EgressRing);
 
 FW_DECL_UP_NS1(output, StreamThreadRtp);
 
@@ -47,13 +56,38 @@ class StreamThreadRtp :
 		// =====================================================================
 		//  -- output::StreamThreadBase ----------------------------------------
 		// =====================================================================
+	public:
+
+		/// @see StreamThreadBase
+		virtual bool addSharedClient(int clientID) final;
+
+		/// @see StreamThreadBase
+		virtual void removeSharedClient(int clientID) final;
+
+		/// @see StreamThreadBase
+		virtual const RtcpFeedback *getRtcpFeedback() const final {
+			return &_rtcp.getFeedback();
+		}
+
+		/// @see StreamThreadBase
+		virtual const RtpRetransmitter *getRtpRetransmitter() const final {
+			return &_retransmitter;
+		}
+
 	protected:
 
 		/// @see StreamThreadBase
 		virtual bool writeDataToOutputDevice(
-			mpegts::PacketBuffer &buffer,
+			mpegts::PacketBuffer *const *buffers,
+			std::size_t n,
 			StreamClient &client) final;
 
+		/// @see StreamThreadBase
+		virtual unsigned int getTSPacketsPerSend() const final;
+
+		/// @see StreamThreadBase
+		virtual unsigned int getSendHoldTime() const final;
+
 		/// @see StreamThreadBase
 		virtual int getStreamSocketPort(int clientID) const final;
 
@@ -68,12 +102,84 @@ class StreamThreadRtp :
 		/// @see StreamThreadBase
 		virtual void doRestartStreaming(int clientID) final;
 
+		// =====================================================================
+		//  -- Other member functions ------------------------------------------
+		// =====================================================================
+	private:
+
+		/// Send the TS packets of the requested PIDs to the shared clients
+		void writeDataToSharedClients(mpegts::PacketBuffer &buffer, long timestamp);
+
+		/// Get the datagram and batch size and the retransmission history from
+		/// the stream settings
+		void updateBatchSize();
+
+		/// Check if the low priority PIDs should be dropped, because the
+		/// client reports congestion
+		bool isDroppingPIDs() const;
+
+		/// Send the datagrams with only the TS packets of the PIDs the client
+		/// requested, and without the low priority PIDs when dropping them
+		/// @param buffers specifies the buffers, the RTP headers are tagged
+		/// @param dropping specifies if the low priority PIDs are dropped
+		/// @return false if sending failed, what does not fit the socket buffer
+		/// is counted as dropped
+		bool writeReducedData(StreamClient &client, mpegts::PacketBuffer *const *buffers,
+			std::size_t n, long timestamp, bool dropping);
+
+		/// Send the datagrams with UDP GSO, as few sends as possible. When GSO
+		/// is rejected it is disabled, so the caller can send the rest.
+		/// @param iov specifies the buffers of all datagrams after each other
+		/// @param n specifies the amount of buffers
+		/// @param vlen specifies the amount of datagrams
+		/// @param error is set when sending failed, not because of GSO or a
+		/// full socket buffer (then the datagrams are counted as dropped)
+		/// @return the amount of datagrams send or dropped
+		unsigned int writeSegmentedData(SocketAttr &rtp, const struct iovec *iov,
+			std::size_t n, unsigned int vlen, bool &error);
+
+		/// Queue the datagrams on the EgressRing, with UDP GSO when enabled
+		/// @param buffers specifies the buffers iov points to
+		/// @param error is set when a send queued before failed
+		/// @return the amount of datagrams queued, the rest did not fit
+		unsigned int writeDataToRing(SocketAttr &rtp, mpegts::PacketBuffer *const *buffers,
+			const struct iovec *iov, std::size_t n, unsigned int vlen, bool &error);
+
+		/// Get the size of each UDP GSO segment, one datagram
+		std::size_t getSegmentSize() const;
+
+		/// Get the max datagrams in one UDP GSO send
+		unsigned int getMaxSegments() const;
+
 		// =====================================================================
 		// -- Data members -----------------------------------------------------
 		// =====================================================================
 	private:
 
+		/// A client sharing this stream has its own RTP sequence and SSRC
+		struct SharedClient {
+			int clientID;
+			uint16_t cseq;
+			unsigned char header[mpegts::PacketBuffer::RTP_HEADER_LEN];
+		};
+
+		/// Max buffers in one datagram, 42 TS packets fit a 9000 MTU
+		static constexpr std::size_t MAX_DATAGRAM_BUF = 6;
+
+		/// Max datagrams and payload the kernel accepts in one GSO send
+		static constexpr unsigned int MAX_GSO_SEGMENTS = 64;
+		static constexpr std::size_t MAX_GSO_SIZE = 65507;
+
+		RtpRetransmitter _retransmitter; /// before _rtcp, it answers the NACKs
 		StreamThreadRtcp _rtcp;
+		std::size_t _datagramBuffers; /// buffers joined in one datagram
+		std::size_t _batchSize;       /// datagrams send with one sendmmsg
+		bool _gso;                    /// send the batch with UDP GSO
+		std::vector<bool> _lowPriorityPIDs; /// dropped for a congested client
+		EgressRing *_ring;            /// sends for this thread, nullptr if not used
+		int _ringFile;                /// the socket in _ring, -1 if not added
+		base::Mutex _sharedMutex;
+		std::vector<SharedClient> _sharedClients;
 
 };
 
@@ -33,7 +33,9 @@ namespace output {
 
 StreamThreadRtpTcp::StreamThreadRtpTcp(StreamInterface &stream) :
 	StreamThreadBase("RTP/TCP", stream),
-	_rtcp(stream) {
+	_rtcp(stream),
+	_sink(stream, "RTP/TCP", 4 + mpegts::PacketBuffer::RTP_HEADER_LEN),
+	_packetBuffers(1) {
 }
 
 StreamThreadRtpTcp::~StreamThreadRtpTcp() {
@@ -57,6 +59,9 @@ void StreamThreadRtpTcp::doStartStreaming(const int clientID) {
 	client.setHttpNetworkSendBufferSize(bufferSize);
 	SI_LOG_INFO("Stream: %d, %s set network buffer size: %d KBytes", streamID, _protocol.c_str(), bufferSize / 1024);
 
+	updatePacketSize();
+	_sink.reset(client, false);
+
 	// RTCP/TCP
 	_rtcp.startStreaming(clientID);
 }
@@ -67,47 +72,101 @@ void StreamThreadRtpTcp::doPauseStreaming(const int clientID) {
 }
 
 void StreamThreadRtpTcp::doRestartStreaming(const int clientID) {
+	updatePacketSize();
+
 	// RTCP/TCP
 	_rtcp.restartStreaming(clientID);
 }
 
+void StreamThreadRtpTcp::processRtcpReport(const int clientID,
+		const uint8_t *data, const std::size_t len) {
+	// Only the owner of this stream has a RTCP session
+	if (clientID == _clientID) {
+		_rtcp.processReport(data, len);
+	}
+}
+
 int StreamThreadRtpTcp::getStreamSocketPort(const int clientID) const {
 	return  _stream.getStreamClient(clientID).getHttpSocketPort();
 }
 
-bool StreamThreadRtpTcp::writeDataToOutputDevice(mpegts::PacketBuffer &buffer, StreamClient &client) {
-	// update sequence number and timestamp
-	const long timestamp = base::TimeCounter::getTicks() * 90;
-	++_cseq;
-	buffer.tagRTPHeaderWith(_cseq, timestamp);
-
-	static constexpr size_t dataSize = buffer.getBufferSize();
-	static constexpr size_t len = dataSize + mpegts::PacketBuffer::RTP_HEADER_LEN;
-
-	// RTP packet octet count (Bytes)
-	_stream.addRtpData(dataSize, timestamp);
-
-	unsigned char header[4];
-	header[0] = 0x24;
-	header[1] = 0x00;
-	header[2] = (len >> 8) & 0xFF;
-	header[3] = (len >> 0) & 0xFF;
-
-	iovec iov[2];
-	iov[0].iov_base = header;
-	iov[0].iov_len = 4;
-	iov[1].iov_base = buffer.getReadBufferPtr();
-	iov[1].iov_len = len;
-
-	// send the RTP/TCP packet
-	if (!client.writeHttpData(iov, 2)) {
-		if (!client.isSelfDestructing()) {
-			SI_LOG_ERROR("Stream: %d, Error sending RTP/TCP Stream Data to %s", _stream.getStreamID(),
-				client.getIPAddressOfStream().c_str());
-			client.selfDestruct();
+bool StreamThreadRtpTcp::writeDataToOutputDevice(
+		mpegts::PacketBuffer *const *buffers,
+		const std::size_t n,
+		StreamClient &client) {
+	// RTCP/TCP report in between the RTP packets
+	_rtcp.writeReport(_sink, client);
+
+	// update timestamp, once for all packets
+	const long timestamp = base::TimeCounter::getRtpTimestamp();
+
+	// Each RTP/TCP packet is an interleave header, the RTP header of its
+	// first buffer and the TS packets of its buffers. All packets are
+	// written with one writev.
+	unsigned char header[MAX_SEND_BUF][4];
+	iovec iov[MAX_SEND_BUF * (mpegts::PacketBuffer::getNumberOfTSPackets() + 2)];
+	std::size_t packetSize[MAX_SEND_BUF];
+	std::size_t iovcnt = 0;
+	std::size_t packets = 0;
+	std::size_t payload = 0;
+	for (std::size_t i = 0; i < n; i += _packetBuffers) {
+		const std::size_t count = (n - i < _packetBuffers) ? n - i : _packetBuffers;
+		const std::size_t first = iovcnt;
+		iov[iovcnt].iov_base = header[packets];
+		iov[iovcnt].iov_len = 4;
+		++iovcnt;
+		iov[iovcnt].iov_base = buffers[i]->getReadBufferPtr();
+		iov[iovcnt].iov_len = mpegts::PacketBuffer::RTP_HEADER_LEN;
+		++iovcnt;
+		std::size_t dataSize = 0;
+		for (std::size_t j = 0; j < count; ++j) {
+			dataSize += _sink.addTSPackets(*buffers[i + j], iov, iovcnt);
+		}
+		if (dataSize == 0) {
+			// Nothing left of this packet by the reduced PID set
+			iovcnt = first;
+			continue;
 		}
+		const size_t len = dataSize + mpegts::PacketBuffer::RTP_HEADER_LEN;
+		++_cseq;
+		buffers[i]->tagRTPHeaderWith(_cseq, timestamp);
+
+		header[packets][0] = 0x24;
+		header[packets][1] = 0x00;
+		header[packets][2] = (len >> 8) & 0xFF;
+		header[packets][3] = (len >> 0) & 0xFF;
+		packetSize[packets] = len + 4;
+		payload += dataSize;
+		++packets;
 	}
+
+	// RTP packet octet count (Bytes)
+	_stream.addRtpData(packets, payload, timestamp);
+
+	// send the RTP/TCP packets
+	// The headers are not in the pool buffers, so never with zero copy
+	_sink.write(client, iov, iovcnt, packetSize, packets, nullptr, 0);
 	return true;
 }
 
+bool StreamThreadRtpTcp::flushOutputDevice(StreamClient &client) {
+	// Also when there are no RTP packets to write
+	_rtcp.writeReport(_sink, client);
+	return _sink.flush(client, 1);
+}
+
+unsigned int StreamThreadRtpTcp::getTSPacketsPerSend() const {
+	// Gather all ready buffers, they are split in RTP packets when writing
+	return MAX_SEND_BUF * mpegts::PacketBuffer::getNumberOfTSPackets();
+}
+
+// =============================================================================
+//  -- Other member functions --------------------------------------------------
+// =============================================================================
+
+void StreamThreadRtpTcp::updatePacketSize() {
+	const std::size_t buffers = _stream.getRtpTcpTSPackets() / mpegts::PacketBuffer::getNumberOfTSPackets();
+	_packetBuffers = (buffers < 1) ? 1 : (buffers > MAX_PACKET_BUF) ? MAX_PACKET_BUF : buffers;
+}
+
 } // namespace output
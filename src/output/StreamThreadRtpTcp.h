@@ -22,6 +22,7 @@
 
 #include <FwDecl.h>
 #include <output/StreamThreadBase.h>
+#include <output/TcpSink.h>
 #include <output/StreamThreadRtcpTcp.h>
 
 FW_DECL_NS0(StreamClient);
@@ -43,6 +44,25 @@ class StreamThreadRtpTcp :
 
 		virtual ~StreamThreadRtpTcp();
 
+		// =====================================================================
+		//  -- output::StreamThreadBase ----------------------------------------
+		// =====================================================================
+	public:
+
+		/// @see StreamThreadBase
+		virtual const TcpSink *getTcpSink() const final {
+			return &_sink;
+		}
+
+		/// @see StreamThreadBase
+		virtual const RtcpFeedback *getRtcpFeedback() const final {
+			return &_rtcp.getFeedback();
+		}
+
+		/// @see StreamThreadBase
+		virtual void processRtcpReport(int clientID, const uint8_t *data,
+			std::size_t len) final;
+
 		// =====================================================================
 		//  -- output::StreamThreadBase ----------------------------------------
 		// =====================================================================
@@ -50,9 +70,16 @@ class StreamThreadRtpTcp :
 
 		/// @see StreamThreadBase
 		virtual bool writeDataToOutputDevice(
-			mpegts::PacketBuffer &buffer,
+			mpegts::PacketBuffer *const *buffers,
+			std::size_t n,
 			StreamClient &client) final;
 
+		/// @see StreamThreadBase
+		virtual bool flushOutputDevice(StreamClient &client) final;
+
+		/// @see StreamThreadBase
+		virtual unsigned int getTSPacketsPerSend() const final;
+
 		/// @see StreamThreadBase
 		virtual int getStreamSocketPort(int clientID) const final;
 
@@ -67,12 +94,26 @@ class StreamThreadRtpTcp :
 		/// @see StreamThreadBase
 		virtual void doRestartStreaming(int clientID) final;
 
+		// =====================================================================
+		//  -- Other member functions ------------------------------------------
+		// =====================================================================
+	private:
+
+		/// Get the RTP packet size from the stream settings
+		void updatePacketSize();
+
 		// =====================================================================
 		// -- Data members -----------------------------------------------------
 		// =====================================================================
 	private:
 
+		/// Max buffers in one RTP/TCP packet, 343 TS packets (64484 Bytes)
+		/// fit the 16 bit length of an interleaved packet
+		static constexpr std::size_t MAX_PACKET_BUF = 49;
+
 		StreamThreadRtcpTcp _rtcp;
+		TcpSink _sink;
+		std::size_t _packetBuffers; /// buffers joined in one RTP/TCP packet
 };
 
 } // namespace output
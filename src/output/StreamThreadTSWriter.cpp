@@ -24,11 +24,18 @@
 #include <StreamInterface.h>
 #include <StreamClient.h>
 #include <Unused.h>
+#include <Utils.h>
 #include <base/TimeCounter.h>
+#include <output/EgressRing.h>
 
+#include <cerrno>
 #include <chrono>
+#include <cstring>
 #include <thread>
 
+#include <fcntl.h>
+#include <unistd.h>
+
 namespace output {
 
 // =============================================================================
@@ -39,10 +46,18 @@ StreamThreadTSWriter::StreamThreadTSWriter(
 	StreamInterface &stream,
 	const std::string &file) :
 	StreamThreadBase("TSWRITER", stream),
-	_filePath(file) {}
+	_filePath(file),
+	_ring(nullptr),
+	_fd(-1),
+	_ringFile(-1),
+	_offset(0) {}
 
 StreamThreadTSWriter::~StreamThreadTSWriter() {
 	terminateThread();
+	if (_ringFile != -1) {
+		_ring->removeFile(_ringFile);
+	}
+	CLOSE_FD(_fd);
 }
 
 // =============================================================================
@@ -50,24 +65,64 @@ StreamThreadTSWriter::~StreamThreadTSWriter() {
 // =============================================================================
 
 void StreamThreadTSWriter::doStartStreaming(int UNUSED(clientID)) {
+	// Queue the writes on the io_uring of all streams, if there is one
+	_ring = _stream.getEgressRing();
+	if (_ring != nullptr) {
+		if (_fd == -1) {
+			_fd = ::open(_filePath.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+			if (_fd == -1) {
+				PERROR("open %s", _filePath.c_str());
+				return;
+			}
+			_offset = 0;
+			_ringFile = _ring->addFile(_fd);
+		}
+		return;
+	}
 	_file.open(_filePath, std::ofstream::binary);
 }
 
-bool StreamThreadTSWriter::writeDataToOutputDevice(mpegts::PacketBuffer &buffer, StreamClient &UNUSED(client)) {
-	const unsigned char *tsBuffer = buffer.getTSReadBufferPtr();
-
-	static constexpr size_t dataSize = buffer.getBufferSize();
+bool StreamThreadTSWriter::writeDataToOutputDevice(
+		mpegts::PacketBuffer *const *buffers,
+		const std::size_t n,
+		StreamClient &UNUSED(client)) {
+	static constexpr size_t dataSize = mpegts::PacketBuffer::getBufferSize();
 
-	const long timestamp = base::TimeCounter::getTicks() * 90;
+	const long timestamp = base::TimeCounter::getRtpTimestamp();
 
 	// RTP packet octet count (Bytes)
-	_stream.addRtpData(dataSize, timestamp);
-
-	// write TS packets to file
-	if (_file.is_open()) {
-		_file.write(reinterpret_cast<const char *>(tsBuffer), dataSize);
+	_stream.addRtpData(1, dataSize * n, timestamp);
+
+	// queue the writes, when the ring is full write them here
+	if (_fd != -1) {
+		bool segmented;
+		const int error = (_ringFile != -1) ? _ring->getError(_ringFile, segmented) : 0;
+		if (error != 0) {
+			SI_LOG_ERROR("Stream: %d, Error writing %s: %s", _stream.getStreamID(),
+				_filePath.c_str(), strerror(error));
+		}
+		if (_ringFile == -1 || !_ring->writeTo(_ringFile, _offset, buffers, n)) {
+			for (std::size_t i = 0; i < n; ++i) {
+				if (::pwrite(_fd, buffers[i]->getTSReadBufferPtr(), dataSize, _offset + (i * dataSize)) == -1) {
+					PERROR("pwrite %s", _filePath.c_str());
+					break;
+				}
+			}
+		}
+		_offset += n * dataSize;
+	} else if (_file.is_open()) {
+		// write TS packets to file
+		for (std::size_t i = 0; i < n; ++i) {
+			const unsigned char *tsBuffer = buffers[i]->getTSReadBufferPtr();
+			_file.write(reinterpret_cast<const char *>(tsBuffer), dataSize);
+		}
 	}
 	return true;
 }
 
+unsigned int StreamThreadTSWriter::getTSPacketsPerSend() const {
+	// The file stream buffers itself, so take as many as possible
+	return MAX_SEND_BUF * mpegts::PacketBuffer::getNumberOfTSPackets();
+}
+
 } // namespace output
@@ -25,8 +25,11 @@
 
 #include <fstream>
 
+#include <sys/types.h>
+
 FW_DECL_NS0(StreamClient);
 FW_DECL_NS0(StreamInterface);
+FW_DECL_NS1(output, EgressRing);
 
 FW_DECL_UP_NS1(output, StreamThreadRtp);
 
@@ -53,9 +56,13 @@ class StreamThreadTSWriter :
 
 		/// @see StreamThreadBase
 		virtual bool writeDataToOutputDevice(
-			mpegts::PacketBuffer &buffer,
+			mpegts::PacketBuffer *const *buffers,
+			std::size_t n,
 			StreamClient &client) final;
 
+		/// @see StreamThreadBase
+		virtual unsigned int getTSPacketsPerSend() const final;
+
 	private:
 
 		/// @see StreamThreadBase
@@ -68,6 +75,10 @@ class StreamThreadTSWriter :
 
 		std::ofstream _file;
 		std::string _filePath;
+		EgressRing *_ring;            /// writes for this thread, nullptr if not used
+		int _fd;                      /// file written with _ring
+		int _ringFile;                /// _fd in _ring, -1 if not added
+		off_t _offset;                /// offset of the next write to _fd
 
 };
 
@@ -0,0 +1,598 @@
+/* TcpSink.cpp
+
+   Copyright (C) 2014 - 2020 Marc Postema (mpostema09 -at- gmail.com)
+
+   This program is free software; you can redistribute it and/or
+   modify it under the terms of the GNU General Public License
+   as published by the Free Software Foundation; either version 2
+   of the License, or (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program; if not, write to the Free Software
+   Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+   Or, point your browser to http://www.gnu.org/copyleft/gpl.html
+ */
+#include <output/TcpSink.h>
+
+#include <Log.h>
+#include <StreamClient.h>
+#include <StreamInterface.h>
+#include <input/Device.h>
+#include <mpegts/PacketBuffer.h>
+#include <mpegts/PacketPool.h>
+#include <mpegts/PidTable.h>
+
+#include <cerrno>
+#include <cstring>
+#include <sstream>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#ifndef MSG_ZEROCOPY
+	#define MSG_ZEROCOPY 0x4000000
+#endif
+
+namespace output {
+
+	static constexpr int SEND_FLAGS = MSG_DONTWAIT | MSG_NOSIGNAL;
+
+	/// Stop zero copy when the kernel copies this many sends in a row, like
+	/// for loopback or a NIC without scatter-gather
+	static constexpr unsigned int MAX_COPIED_IN_ROW = 32;
+
+	/// Size to try for the splice pipe
+	static constexpr int PIPE_SIZE = 1024 * 1024;
+
+	static bool wouldBlock(const int err) {
+		return err == EAGAIN || err == EWOULDBLOCK || err == EINTR;
+	}
+
+	// =========================================================================
+	// -- Constructors and destructor ------------------------------------------
+	// =========================================================================
+
+	TcpSink::TcpSink(StreamInterface &stream, const std::string &protocol,
+			const std::size_t headerSize) :
+		_stream(stream),
+		_protocol(protocol),
+		_headerSize(headerSize),
+		_policy(Policy::DropOldest),
+		_maxTime(1000),
+		_deadline(5000),
+		_reducedPIDs(mpegts::PidTable::MAX_PIDS, false),
+		_reduced(false),
+		_overloaded(false),
+		_epollFD(-1),
+		_fd(-1),
+		_blocked(false),
+		_head(0),
+		_size(0),
+		_backlogBytes(0),
+		_maxBacklogBytes(0),
+		_blockedWrites(0),
+		_droppedPackets(0),
+		_reductions(0),
+		_disconnects(0),
+		_sendQueue(0),
+		_rtt(0),
+		_retransmits(0),
+		_pool(nullptr),
+		_zeroCopy(false),
+		_zeroCopyID(0),
+		_copiedInRow(0),
+		_zeroCopySends(0),
+		_zeroCopyCopied(0),
+		_pipeSize(0),
+		_pipeBytes(0),
+		_spliceOffset(0),
+		_spliceable(true),
+		_splicedBytes(0) {
+		_pipe[0] = -1;
+		_pipe[1] = -1;
+	}
+
+	TcpSink::~TcpSink() {
+		releaseZeroCopyBuffers();
+		if (_epollFD != -1) {
+			::close(_epollFD);
+		}
+		if (_pipe[0] != -1) {
+			::close(_pipe[0]);
+			::close(_pipe[1]);
+		}
+	}
+
+	// =========================================================================
+	//  -- Other member functions ----------------------------------------------
+	// =========================================================================
+
+	void TcpSink::reset(StreamClient &client, const bool zeroCopy) {
+		_policy = static_cast<Policy>(_stream.getSinkPolicy());
+		_maxTime = std::chrono::milliseconds(_stream.getSinkQueueTime());
+		_deadline = std::chrono::milliseconds(_stream.getSinkDeadline());
+		_backlog.resize(_stream.getSinkQueueSize() * 1024);
+		_head = 0;
+		_size = 0;
+		_packets.clear();
+		_backlogBytes = 0;
+		_reduced = false;
+		_overloaded = false;
+		_blocked = false;
+
+		// The buffers of the last client may still be send by the kernel,
+		// but that connection is gone, so do not wait for them
+		releaseZeroCopyBuffers();
+		_pool = _stream.getPacketPool();
+		_zeroCopyID = 0;
+		_copiedInRow = 0;
+		_zeroCopy = zeroCopy && client.setHttpZeroCopy();
+
+		// Throw away what is left in the pipe
+		if (_pipe[0] != -1) {
+			unsigned char data[4096];
+			while (::read(_pipe[0], data, sizeof(data)) > 0) {}
+		}
+		_pipeBytes = 0;
+		_spliceOffset = 0;
+		_spliceable = true;
+
+		_reducedPIDs.assign(mpegts::PidTable::MAX_PIDS, false);
+		std::istringstream pids(_stream.getSinkReducedPIDs());
+		std::string pid;
+		while (std::getline(pids, pid, ',')) {
+			const int p = std::atoi(pid.c_str());
+			if (p >= 0 && p < static_cast<int>(mpegts::PidTable::ALL_PIDS)) {
+				_reducedPIDs[p] = true;
+			}
+		}
+
+		// Watch the socket for writability, when it has a backlog
+		if (_epollFD == -1) {
+			_epollFD = ::epoll_create1(EPOLL_CLOEXEC);
+			if (_epollFD == -1) {
+				PERROR("epoll_create1");
+			}
+		}
+		if (_epollFD != -1) {
+			if (_fd != -1) {
+				::epoll_ctl(_epollFD, EPOLL_CTL_DEL, _fd, nullptr);
+			}
+			_fd = client.getHttpSocketFD();
+			struct epoll_event ev;
+			std::memset(&ev, 0, sizeof(ev));
+			ev.events = EPOLLOUT;
+			if (_fd != -1 && ::epoll_ctl(_epollFD, EPOLL_CTL_ADD, _fd, &ev) == -1) {
+				PERROR("epoll_ctl");
+				_fd = -1;
+			}
+		}
+	}
+
+	std::size_t TcpSink::addTSPackets(mpegts::PacketBuffer &buffer,
+			struct iovec *iov, std::size_t &iovcnt) const {
+		static constexpr std::size_t numberOfPackets = mpegts::PacketBuffer::getNumberOfTSPackets();
+		static constexpr std::size_t packetSize = mpegts::PacketBuffer::TS_PACKET_SIZE;
+		std::size_t bytes = 0;
+		for (std::size_t i = 0; i < numberOfPackets; ++i) {
+			unsigned char *ts = buffer.getTSPacketPtr(i);
+			if (_reduced) {
+				const int pid = ((ts[1] & 0x1f) << 8) | ts[2];
+				if (!_reducedPIDs[pid]) {
+					continue;
+				}
+			}
+			// Join with the previous entry when it ends at this TS packet
+			if (iovcnt > 0 &&
+				static_cast<unsigned char *>(iov[iovcnt - 1].iov_base) + iov[iovcnt - 1].iov_len == ts) {
+				iov[iovcnt - 1].iov_len += packetSize;
+			} else {
+				iov[iovcnt].iov_base = ts;
+				iov[iovcnt].iov_len = packetSize;
+				++iovcnt;
+			}
+			bytes += packetSize;
+		}
+		return bytes;
+	}
+
+	bool TcpSink::write(StreamClient &client, const struct iovec *iov, const std::size_t iovcnt,
+			const std::size_t *packetSize, const std::size_t packets,
+			mpegts::PacketBuffer *const *buffers, const std::size_t n) {
+		updateTcpInfo(client);
+		reapZeroCopyCompletions(client);
+		if (_pipeBytes > 0) {
+			queuePipe();
+		}
+		if (_size > 0 && !writeBacklog(client)) {
+			failed(client);
+			return false;
+		}
+		std::size_t written = 0;
+		if (_size == 0) {
+			// No backlog, so try to write it directly without copying
+			std::size_t len = 0;
+			for (std::size_t i = 0; i < packets; ++i) {
+				len += packetSize[i];
+			}
+			// Zero copy only while the pool can spare the buffers
+			const bool zeroCopy = _zeroCopy && buffers != nullptr &&
+				_zeroCopyBuffers.size() + n <= MAX_ZERO_COPY_BUF;
+			ssize_t ret = client.sendHttpData(iov, static_cast<int>(iovcnt),
+				zeroCopy ? (SEND_FLAGS | MSG_ZEROCOPY) : SEND_FLAGS);
+			if (ret == -1 && zeroCopy && errno == ENOBUFS) {
+				// No memory left to pin the pages, so copy this time
+				ret = client.sendHttpData(iov, static_cast<int>(iovcnt), SEND_FLAGS);
+			} else if (ret > 0 && zeroCopy) {
+				holdZeroCopyBuffers(buffers, n);
+			}
+			if (ret == -1) {
+				if (!wouldBlock(errno)) {
+					failed(client);
+					return false;
+				}
+			} else {
+				written = ret;
+			}
+			if (written == len) {
+				return true;
+			}
+			++_blockedWrites;
+			_blocked = true;
+		}
+		queue(iov, iovcnt, written, packetSize, packets);
+		return checkBacklog(client);
+	}
+
+	bool TcpSink::flush(StreamClient &client, const int timeoutMS) {
+		reapZeroCopyCompletions(client);
+		if (_size == 0) {
+			return false;
+		}
+		updateTcpInfo(client);
+		if (_blocked && _fd != -1) {
+			struct epoll_event ev;
+			if (::epoll_wait(_epollFD, &ev, 1, timeoutMS) <= 0) {
+				return checkBacklog(client) && _size > 0;
+			}
+		}
+		if (!writeBacklog(client)) {
+			failed(client);
+			return false;
+		}
+		return checkBacklog(client) && _size > 0;
+	}
+
+	ssize_t TcpSink::splice(StreamClient &client, input::Device &inputDevice) {
+		updateTcpInfo(client);
+		reapZeroCopyCompletions(client);
+		if (!_spliceable || _size > 0 || (_pipe[0] == -1 && !openPipe())) {
+			return -1;
+		}
+		// Only whole TS packets from the input device, so it can continue
+		// with the buffers at any time
+		static constexpr std::size_t packetSize = mpegts::PacketBuffer::TS_PACKET_SIZE;
+		const std::size_t room = (_pipeBytes < _pipeSize) ?
+			((_pipeSize - _pipeBytes) / packetSize) * packetSize : 0;
+		if (room > 0 && inputDevice.isDataAvailable()) {
+			const ssize_t ret = inputDevice.spliceTSPackets(_pipe[1], room);
+			if (ret == -1) {
+				if (errno == EINVAL) {
+					SI_LOG_INFO("Stream: %d, %s input device can not splice, use buffers",
+						_stream.getStreamID(), _protocol.c_str());
+				} else {
+					PERROR("splice input device");
+				}
+				_spliceable = false;
+				return -1;
+			}
+			_pipeBytes += ret;
+		}
+		if (_pipeBytes == 0) {
+			return 0;
+		}
+		const ssize_t ret = client.spliceHttpData(_pipe[0], _pipeBytes);
+		if (ret == -1) {
+			if (!wouldBlock(errno)) {
+				failed(client);
+				return -1;
+			}
+			const std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+			if (!_blocked) {
+				++_blockedWrites;
+				_blocked = true;
+				_tSpliceBlocked = now;
+			} else if (now - _tSpliceBlocked > _maxTime / 2) {
+				// Too slow, so continue with the backlog and its policy
+				return -1;
+			}
+			struct epoll_event ev;
+			if (_fd != -1) {
+				::epoll_wait(_epollFD, &ev, 1, 10);
+			}
+			return 0;
+		}
+		_blocked = false;
+		_pipeBytes -= ret;
+		_spliceOffset = (_spliceOffset + ret) % packetSize;
+		_splicedBytes += ret;
+		return ret;
+	}
+
+	bool TcpSink::writeBacklog(StreamClient &client) {
+		_blocked = false;
+		while (_size > 0) {
+			// The data may wrap around the end of the ring
+			const std::size_t capacity = _backlog.size();
+			const std::size_t first = (_size < capacity - _head) ? _size : capacity - _head;
+			struct iovec iov[2];
+			iov[0].iov_base = &_backlog[_head];
+			iov[0].iov_len = first;
+			iov[1].iov_base = &_backlog[0];
+			iov[1].iov_len = _size - first;
+			const ssize_t ret = client.sendHttpData(iov, (first < _size) ? 2 : 1, SEND_FLAGS);
+			if (ret == -1) {
+				if (!wouldBlock(errno)) {
+					return false;
+				}
+				++_blockedWrites;
+				_blocked = true;
+				return true;
+			}
+			consume(ret);
+		}
+		if (_reduced) {
+			SI_LOG_INFO("Stream: %d, %s client caught up, send all PIDs again",
+				_stream.getStreamID(), _protocol.c_str());
+			_reduced = false;
+		}
+		return true;
+	}
+
+	void TcpSink::consume(std::size_t bytes) {
+		_head = (_head + bytes) % _backlog.size();
+		_size -= bytes;
+		_backlogBytes = _size;
+		while (bytes > 0) {
+			Packet &packet = _packets.front();
+			if (bytes >= packet.size) {
+				bytes -= packet.size;
+				_packets.pop_front();
+			} else {
+				packet.size -= bytes;
+				packet.partial = true;
+				bytes = 0;
+			}
+		}
+	}
+
+	void TcpSink::queue(const struct iovec *iov, const std::size_t iovcnt, std::size_t skip,
+			const std::size_t *packetSize, const std::size_t packets) {
+		const std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+		const std::size_t capacity = _backlog.size();
+		// Walk through iov, copying to the backlog or skipping the bytes
+		std::size_t index = 0;
+		std::size_t offset = 0;
+		auto walk = [&](std::size_t bytes, const bool store) {
+			while (bytes > 0 && index < iovcnt) {
+				const std::size_t left = iov[index].iov_len - offset;
+				const std::size_t n = (left < bytes) ? left : bytes;
+				if (store) {
+					const unsigned char *src = static_cast<const unsigned char *>(iov[index].iov_base) + offset;
+					const std::size_t tail = (_head + _size) % capacity;
+					const std::size_t first = (n < capacity - tail) ? n : capacity - tail;
+					std::memcpy(&_backlog[tail], src, first);
+					std::memcpy(&_backlog[0], src + first, n - first);
+					_size += n;
+				}
+				offset += n;
+				bytes -= n;
+				if (offset == iov[index].iov_len) {
+					++index;
+					offset = 0;
+				}
+			}
+		};
+		for (std::size_t p = 0; p < packets; ++p) {
+			// Skip the written begin of this packet
+			const std::size_t written = (skip < packetSize[p]) ? skip : packetSize[p];
+			const std::size_t len = packetSize[p] - written;
+			skip -= written;
+			walk(written, false);
+			if (len == 0) {
+				continue;
+			}
+			// Make room by dropping the oldest packets, else drop this one.
+			// A partially written packet must be completed, so it always fits
+			// after the packets before it are written.
+			while (_size + len > capacity && dropOldest()) {}
+			if (_size + len <= capacity) {
+				_packets.push_back(Packet{len, written > 0, now});
+				walk(len, true);
+			} else {
+				const unsigned long ts = (len - _headerSize) / mpegts::PacketBuffer::TS_PACKET_SIZE;
+				_droppedPackets += ts;
+				_stream.addDroppedPackets(ts);
+				walk(len, false);
+			}
+		}
+		_backlogBytes = _size;
+		if (_size > _maxBacklogBytes) {
+			_maxBacklogBytes = _size;
+		}
+	}
+
+	bool TcpSink::dropOldest() {
+		if (_packets.empty() || _packets.front().partial) {
+			return false;
+		}
+		const std::size_t size = _packets.front().size;
+		const unsigned long ts = (size - _headerSize) / mpegts::PacketBuffer::TS_PACKET_SIZE;
+		_packets.pop_front();
+		_head = (_head + size) % _backlog.size();
+		_size -= size;
+		_backlogBytes = _size;
+		_droppedPackets += ts;
+		_stream.addDroppedPackets(ts);
+		return true;
+	}
+
+	bool TcpSink::checkBacklog(StreamClient &client) {
+		if (_packets.empty()) {
+			_overloaded = false;
+			return true;
+		}
+		const std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+		const bool tooOld = now - _packets.front().t > _maxTime;
+		if (_policy == Policy::Disconnect) {
+			if (!tooOld) {
+				_overloaded = false;
+			} else if (!_overloaded) {
+				_overloaded = true;
+				_tOverloaded = now;
+			} else if (now - _tOverloaded > _deadline) {
+				SI_LOG_ERROR("Stream: %d, %s client %s too slow for %u msec, disconnecting",
+					_stream.getStreamID(), _protocol.c_str(), client.getIPAddressOfStream().c_str(),
+					static_cast<unsigned int>(_deadline.count()));
+				++_disconnects;
+				_packets.clear();
+				_size = 0;
+				_backlogBytes = 0;
+				client.selfDestruct();
+				return false;
+			}
+			return true;
+		}
+		// Reduce before the backlog is full or too old
+		if (_policy == Policy::ReducedPIDs && !_reduced &&
+			(_size > _backlog.size() / 2 || now - _packets.front().t > _maxTime / 2)) {
+			SI_LOG_INFO("Stream: %d, %s client too slow, send only PIDs %s",
+				_stream.getStreamID(), _protocol.c_str(), _stream.getSinkReducedPIDs().c_str());
+			_reduced = true;
+			++_reductions;
+		}
+		// Keep the backlog within its max time
+		if (tooOld) {
+			while (!_packets.empty() && now - _packets.front().t > _maxTime && dropOldest()) {}
+		}
+		return true;
+	}
+
+	void TcpSink::updateTcpInfo(StreamClient &client) {
+		const std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+		if (now - _tTcpInfo < std::chrono::seconds(1)) {
+			return;
+		}
+		_tTcpInfo = now;
+		unsigned int sendQueue = 0;
+		unsigned int rtt = 0;
+		unsigned int retransmits = 0;
+		if (client.getHttpTcpInfo(sendQueue, rtt, retransmits)) {
+			_sendQueue = sendQueue;
+			_rtt = rtt;
+			_retransmits = retransmits;
+		}
+	}
+
+	void TcpSink::holdZeroCopyBuffers(mpegts::PacketBuffer *const *buffers, const std::size_t n) {
+		// Each send with MSG_ZEROCOPY gets the next id from the kernel
+		const uint32_t id = _zeroCopyID++;
+		for (std::size_t i = 0; i < n; ++i) {
+			_pool->addRef(buffers[i]);
+			_zeroCopyBuffers.push_back(ZeroCopyBuffer{id, buffers[i]});
+		}
+		++_zeroCopySends;
+	}
+
+	void TcpSink::reapZeroCopyCompletions(StreamClient &client) {
+		uint32_t lo;
+		uint32_t hi;
+		bool copied;
+		while (!_zeroCopyBuffers.empty() && client.getHttpZeroCopyCompletion(lo, hi, copied)) {
+			// Release the buffers of the sends lo up until hi, the ids may wrap
+			for (auto it = _zeroCopyBuffers.begin(); it != _zeroCopyBuffers.end(); ) {
+				if (it->id - lo <= hi - lo) {
+					_pool->release(it->buffer);
+					it = _zeroCopyBuffers.erase(it);
+				} else {
+					++it;
+				}
+			}
+			if (!copied) {
+				_copiedInRow = 0;
+				continue;
+			}
+			_zeroCopyCopied += hi - lo + 1;
+			_copiedInRow += hi - lo + 1;
+			if (_zeroCopy && _copiedInRow >= MAX_COPIED_IN_ROW) {
+				SI_LOG_INFO("Stream: %d, %s kernel copies the zero copy sends, so copy them here",
+					_stream.getStreamID(), _protocol.c_str());
+				_zeroCopy = false;
+			}
+		}
+	}
+
+	void TcpSink::releaseZeroCopyBuffers() {
+		for (const ZeroCopyBuffer &zc : _zeroCopyBuffers) {
+			_pool->release(zc.buffer);
+		}
+		_zeroCopyBuffers.clear();
+	}
+
+	bool TcpSink::openPipe() {
+		if (::pipe2(_pipe, O_NONBLOCK | O_CLOEXEC) == -1) {
+			PERROR("pipe2");
+			_spliceable = false;
+			return false;
+		}
+		// A bigger pipe is a best effort, it is limited for normal users
+		::fcntl(_pipe[1], F_SETPIPE_SZ, PIPE_SIZE);
+		const int size = ::fcntl(_pipe[1], F_GETPIPE_SZ);
+		_pipeSize = (size > 0) ? size : 0;
+		return true;
+	}
+
+	void TcpSink::queuePipe() {
+		std::vector<unsigned char> data(_pipeBytes);
+		std::size_t size = 0;
+		while (size < data.size()) {
+			const ssize_t ret = ::read(_pipe[0], &data[size], data.size() - size);
+			if (ret <= 0) {
+				break;
+			}
+			size += ret;
+		}
+		_pipeBytes = 0;
+		if (size == 0) {
+			return;
+		}
+		// The first TS packet may be partially written already, so skip that
+		// part in front of the data
+		static constexpr std::size_t packetSize = mpegts::PacketBuffer::TS_PACKET_SIZE;
+		const struct iovec iov[2] = {{&data[0], _spliceOffset}, {&data[0], size}};
+		const std::size_t total = _spliceOffset + size;
+		std::vector<std::size_t> packetSizes(total / packetSize, packetSize);
+		if (total % packetSize != 0) {
+			packetSizes.push_back(total % packetSize);
+		}
+		queue(iov, 2, _spliceOffset, packetSizes.data(), packetSizes.size());
+		_spliceOffset = 0;
+	}
+
+	void TcpSink::failed(StreamClient &client) {
+		if (!client.isSelfDestructing()) {
+			SI_LOG_ERROR("Stream: %d, Error sending %s Stream Data to %s", _stream.getStreamID(),
+				_protocol.c_str(), client.getIPAddressOfStream().c_str());
+			client.selfDestruct();
+		}
+	}
+
+} // namespace output
@@ -0,0 +1,295 @@
+/* TcpSink.h
+
+   Copyright (C) 2014 - 2020 Marc Postema (mpostema09 -at- gmail.com)
+
+   This program is free software; you can redistribute it and/or
+   modify it under the terms of the GNU General Public License
+   as published by the Free Software Foundation; either version 2
+   of the License, or (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program; if not, write to the Free Software
+   Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+   Or, point your browser to http://www.gnu.org/copyleft/gpl.html
+*/
+#ifndef OUTPUT_TCPSINK_H_INCLUDE
+#define OUTPUT_TCPSINK_H_INCLUDE OUTPUT_TCPSINK_H_INCLUDE
+
+#include <FwDecl.h>
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <string>
+#include <vector>
+
+#include <sys/uio.h>
+
+FW_DECL_NS0(StreamClient);
+FW_DECL_NS0(StreamInterface);
+FW_DECL_NS1(input, Device);
+FW_DECL_NS1(mpegts, PacketBuffer);
+FW_DECL_NS1(mpegts, PacketPool);
+
+namespace output {
+
+/// The class @c TcpSink writes the HTTP/RTP_TCP packets of a stream to its
+/// client without blocking. What the client can not take is copied to a
+/// bounded backlog, that is written when the socket is writable again. When
+/// the backlog gets too big or too old the @c Policy decides what happens.
+/// With zero copy the kernel sends from the buffers of the packet pool, they
+/// are kept until the kernel reports it is done with them.
+class TcpSink {
+	public:
+
+		enum class Policy {
+			DropOldest  = 0, /// drop the oldest packets of the backlog
+			ReducedPIDs = 1, /// send only the reduced PID set until the backlog is written
+			Disconnect  = 2  /// disconnect the client when it is too slow for too long
+		};
+
+		// =====================================================================
+		//  -- Constructors and destructor -------------------------------------
+		// =====================================================================
+	public:
+
+		/// @param headerSize specifies the bytes in front of the TS packets
+		/// of each packet
+		TcpSink(StreamInterface &stream, const std::string &protocol, std::size_t headerSize);
+
+		virtual ~TcpSink();
+
+		// =====================================================================
+		//  -- Other member functions ------------------------------------------
+		// =====================================================================
+	public:
+
+		/// Clear the backlog, watch the socket of the client and get the
+		/// settings of the stream
+		/// @param zeroCopy specifies if it should send with MSG_ZEROCOPY
+		void reset(StreamClient &client, bool zeroCopy);
+
+		/// Add the TS packets of the buffer to iov, all of them or only the
+		/// ones of the reduced PID set. Consecutive data is joined.
+		/// @param iov specifies the array to add to
+		/// @param iovcnt specifies the used entries of iov, it is updated
+		/// @return the amount of bytes added
+		std::size_t addTSPackets(mpegts::PacketBuffer &buffer,
+			struct iovec *iov, std::size_t &iovcnt) const;
+
+		/// Write packets to the client without blocking, what is not written
+		/// goes to the backlog
+		/// @param iov specifies the data of all packets after each other
+		/// @param packetSize specifies the size of each packet
+		/// @param packets specifies the amount of packets
+		/// @param buffers specifies the pool buffers iov points to, they are
+		/// kept when send with zero copy. nullptr when iov points to other
+		/// data, then it is never send with zero copy.
+		/// @param n specifies the amount of buffers
+		/// @return false if the client has an error or is disconnected
+		bool write(StreamClient &client, const struct iovec *iov, std::size_t iovcnt,
+			const std::size_t *packetSize, std::size_t packets,
+			mpegts::PacketBuffer *const *buffers, std::size_t n);
+
+		/// Move the data of the input device through a pipe to the client,
+		/// so it does not pass user space. The backlog should be empty.
+		/// @return the amount of bytes moved to the client, or -1 if it should
+		/// continue with @see write because splicing failed or the client is
+		/// too slow
+		ssize_t splice(StreamClient &client, input::Device &inputDevice);
+
+		/// Check if @see splice did not fail on the input device or pipe
+		bool isSpliceable() const {
+			return _spliceable;
+		}
+
+		/// Continue writing the backlog
+		/// @param timeoutMS specifies the max time to wait until the socket
+		/// is writable
+		/// @return true if there is still a backlog
+		bool flush(StreamClient &client, int timeoutMS);
+
+		/// Get the bytes in the backlog
+		std::size_t getBacklog() const {
+			return _backlogBytes;
+		}
+
+		/// Get the max bytes that where in the backlog
+		std::size_t getMaxBacklog() const {
+			return _maxBacklogBytes;
+		}
+
+		/// Get the amount of writes the socket could not take (completely)
+		unsigned long getBlockedWrites() const {
+			return _blockedWrites;
+		}
+
+		/// Get the TS packets dropped from the backlog
+		unsigned long getDroppedPackets() const {
+			return _droppedPackets;
+		}
+
+		/// Get the amount of times the reduced PID set was used
+		unsigned long getReductions() const {
+			return _reductions;
+		}
+
+		/// Get the amount of times the client was disconnected
+		unsigned long getDisconnects() const {
+			return _disconnects;
+		}
+
+		/// Get the bytes in the socket send queue, not acked yet
+		unsigned int getSendQueue() const {
+			return _sendQueue;
+		}
+
+		/// Get the smoothed round trip time of the connection in usec
+		unsigned int getRtt() const {
+			return _rtt;
+		}
+
+		/// Get the retransmitted segments of the connection
+		unsigned int getRetransmits() const {
+			return _retransmits;
+		}
+
+		/// Get the amount of sends with MSG_ZEROCOPY
+		unsigned long getZeroCopySends() const {
+			return _zeroCopySends;
+		}
+
+		/// Get the amount of zero copy completions that the kernel copied anyway
+		unsigned long getZeroCopyCopied() const {
+			return _zeroCopyCopied;
+		}
+
+		/// Get the bytes moved from the input device to the client with splice
+		unsigned long long getSplicedBytes() const {
+			return _splicedBytes;
+		}
+
+	private:
+
+		/// Write as much of the backlog as the socket takes
+		/// @return false if the client has an error
+		bool writeBacklog(StreamClient &client);
+
+		/// Remove written bytes from the backlog
+		void consume(std::size_t bytes);
+
+		/// Copy the packets to the backlog, skipping the bytes already written
+		void queue(const struct iovec *iov, std::size_t iovcnt, std::size_t skip,
+			const std::size_t *packetSize, std::size_t packets);
+
+		/// Drop the oldest packet of the backlog, if it is not partially written
+		/// @return true if a packet was dropped
+		bool dropOldest();
+
+		/// Apply the policy when the backlog is too big or too old
+		/// @return false if the client is disconnected
+		bool checkBacklog(StreamClient &client);
+
+		/// Get the backlog of the TCP connection, once a second
+		void updateTcpInfo(StreamClient &client);
+
+		/// Log the error and let the client self destruct
+		void failed(StreamClient &client);
+
+		/// Keep the buffers of a send with MSG_ZEROCOPY
+		void holdZeroCopyBuffers(mpegts::PacketBuffer *const *buffers, std::size_t n);
+
+		/// Release the buffers of the completed MSG_ZEROCOPY sends
+		void reapZeroCopyCompletions(StreamClient &client);
+
+		/// Release all buffers of MSG_ZEROCOPY sends
+		void releaseZeroCopyBuffers();
+
+		/// Open the pipe for @see splice
+		bool openPipe();
+
+		/// Copy the data in the pipe to the backlog, so @see write continues
+		/// after it
+		void queuePipe();
+
+		// =====================================================================
+		// -- Data members -----------------------------------------------------
+		// =====================================================================
+	public:
+
+		/// Max buffers kept for sends with MSG_ZEROCOPY, the packet pool has
+		/// these extra for each stream
+		static constexpr std::size_t MAX_ZERO_COPY_BUF = 128;
+
+	private:
+
+		/// A packet in the backlog
+		struct Packet {
+			std::size_t size;      /// bytes of this packet in the backlog
+			bool partial;          /// the begin of this packet is written already
+			std::chrono::steady_clock::time_point t;
+		};
+
+		StreamInterface &_stream;
+		std::string _protocol;
+		std::size_t _headerSize;
+		Policy _policy;
+		std::chrono::milliseconds _maxTime;
+		std::chrono::milliseconds _deadline;
+		std::vector<bool> _reducedPIDs;
+		bool _reduced;                      /// send only the reduced PID set
+		bool _overloaded;                   /// the backlog is too old
+		std::chrono::steady_clock::time_point _tOverloaded;
+		int _epollFD;
+		int _fd;                            /// socket watched by _epollFD
+		bool _blocked;                      /// the socket did not take all data
+
+		std::vector<unsigned char> _backlog; /// ring of bytes
+		std::size_t _head;                  /// begin of the data in _backlog
+		std::size_t _size;                  /// bytes of data in _backlog
+		std::deque<Packet> _packets;
+
+		std::chrono::steady_clock::time_point _tTcpInfo;
+		std::atomic<std::size_t> _backlogBytes;
+		std::atomic<std::size_t> _maxBacklogBytes;
+		std::atomic<unsigned long> _blockedWrites;
+		std::atomic<unsigned long> _droppedPackets;
+		std::atomic<unsigned long> _reductions;
+		std::atomic<unsigned long> _disconnects;
+		std::atomic<unsigned int> _sendQueue;
+		std::atomic<unsigned int> _rtt;
+		std::atomic<unsigned int> _retransmits;
+
+		/// A pool buffer of a send with MSG_ZEROCOPY
+		struct ZeroCopyBuffer {
+			uint32_t id;                  /// the send it belongs to
+			mpegts::PacketBuffer *buffer;
+		};
+
+		mpegts::PacketPool *_pool;
+		bool _zeroCopy;                     /// send with MSG_ZEROCOPY
+		uint32_t _zeroCopyID;               /// id of the next send with MSG_ZEROCOPY
+		unsigned int _copiedInRow;          /// completions that the kernel copied
+		std::deque<ZeroCopyBuffer> _zeroCopyBuffers;
+		std::atomic<unsigned long> _zeroCopySends;
+		std::atomic<unsigned long> _zeroCopyCopied;
+
+		int _pipe[2];
+		std::size_t _pipeSize;
+		std::size_t _pipeBytes;             /// bytes in the pipe
+		std::size_t _spliceOffset;          /// bytes of the last TS packet spliced
+		bool _spliceable;
+		std::chrono::steady_clock::time_point _tSpliceBlocked;
+		std::atomic<unsigned long long> _splicedBytes;
+};
+
+} // namespace output
+
+#endif // OUTPUT_TCPSINK_H_INCLUDE
@@ -62,6 +62,14 @@ const int HttpcSocket::HTTPC_TIMEOUT = 500;
 
 		client.clearMessage();
 
+		// an interleaved packet is binary, so it can not be read as text
+		if (si_other == nullptr) {
+			char first;
+			if (::recv(client.getFD(), &first, 1, recv_flags | MSG_PEEK) == 1 && first == '$') {
+				return recv_interleaved_message(client, recv_flags);
+			}
+		}
+
 		// read until we have '\r\n\r\n' (end of HTTP/RTSP message) then check
 		// if the header field 'Content-Length' is present
 		do {
@@ -105,3 +113,32 @@ const int HttpcSocket::HTTPC_TIMEOUT = 500;
 
 		return read_len;
 	}
+
+	ssize_t HttpcSocket::recv_interleaved_message(SocketClient &client, int recv_flags) {
+		std::size_t timeout = HTTPC_TIMEOUT;
+		std::size_t read_len = 0;
+		// first read the header, then the data its length tells
+		std::string msg(4, 0);
+		while (read_len < msg.size()) {
+			const ssize_t size = ::recv(client.getFD(), &msg[read_len], msg.size() - read_len, recv_flags);
+			if (size > 0) {
+				read_len += size;
+				// reset timeout again
+				timeout = HTTPC_TIMEOUT;
+				if (read_len == 4) {
+					const std::size_t len = (static_cast<unsigned char>(msg[2]) << 8) |
+						static_cast<unsigned char>(msg[3]);
+					msg.resize(4 + len);
+				}
+			} else {
+				if (timeout != 0 && size == -1 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+					std::this_thread::sleep_for(std::chrono::microseconds(1000));
+					--timeout;
+				} else {
+					return size;
+				}
+			}
+		}
+		client.addMessage(msg);
+		return read_len;
+	}
@@ -66,6 +66,10 @@ class HttpcSocket  {
 		ssize_t recv_recvfrom_httpc_message(SocketClient &client, int recv_flags,
 			struct sockaddr_in *si_other, socklen_t *addrlen);
 
+		/// Receive an interleaved packet ('$', channel, length and data) that
+		/// a RTP/TCP client sends on its RTSP connection, for ex. RTCP reports
+		ssize_t recv_interleaved_message(SocketClient &client, int recv_flags);
+
 };
 
 #endif // HTTPC_SOCKET_H_INCLUDE
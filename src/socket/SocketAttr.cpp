@@ -25,10 +25,31 @@
 
 #include <string>
 #include <cstring>
+#include <vector>
 
 #include <arpa/inet.h>
+#include <fcntl.h>
+#include <linux/errqueue.h>
+#include <linux/sockios.h>
+#include <netinet/tcp.h>
+#include <netinet/udp.h>
+#include <sys/ioctl.h>
+#include <sys/socket.h>
 #include <sys/uio.h>
 
+#ifndef UDP_SEGMENT
+	#define UDP_SEGMENT 103
+#endif
+#ifndef SO_ZEROCOPY
+	#define SO_ZEROCOPY 60
+#endif
+#ifndef SO_EE_ORIGIN_ZEROCOPY
+	#define SO_EE_ORIGIN_ZEROCOPY 5
+#endif
+#ifndef SO_EE_CODE_ZEROCOPY_COPIED
+	#define SO_EE_CODE_ZEROCOPY_COPIED 1
+#endif
+
 	// ===================================================================
 	//  -- Constructors and destructor -----------------------------------
 	// ===================================================================
@@ -153,16 +174,123 @@
 		return true;
 	}
 
-	bool SocketAttr::writeData(const iovec *iov, const int iovcnt) {
-		if (::writev(_fd, iov, iovcnt) == -1) {
-			if (errno != EBADF) {
-				PERROR("writev");
-			}
+	ssize_t SocketAttr::sendData(const iovec *iov, const int iovcnt, const int flags) {
+		struct msghdr msg;
+		std::memset(&msg, 0, sizeof(msg));
+		msg.msg_iov = const_cast<iovec *>(iov);
+		msg.msg_iovlen = iovcnt;
+		return ::sendmsg(_fd, &msg, flags);
+	}
+
+	bool SocketAttr::getTcpInfo(unsigned int &sendQueue, unsigned int &rtt,
+			unsigned int &retransmits) const {
+		int outq = 0;
+		if (::ioctl(_fd, SIOCOUTQ, &outq) == -1) {
+			return false;
+		}
+		struct tcp_info info;
+		socklen_t len = sizeof(info);
+		if (::getsockopt(_fd, IPPROTO_TCP, TCP_INFO, &info, &len) == -1) {
+			return false;
+		}
+		sendQueue = outq;
+		rtt = info.tcpi_rtt;
+		retransmits = info.tcpi_total_retrans;
+		return true;
+	}
+
+	bool SocketAttr::setZeroCopy() {
+		const int val = 1;
+		if (::setsockopt(_fd, SOL_SOCKET, SO_ZEROCOPY, &val, sizeof(val)) == -1) {
+			PERROR("SO_ZEROCOPY");
 			return false;
 		}
 		return true;
 	}
 
+	bool SocketAttr::getZeroCopyCompletion(uint32_t &lo, uint32_t &hi, bool &copied) {
+		for (;;) {
+			char control[CMSG_SPACE(sizeof(struct sock_extended_err) + sizeof(struct sockaddr_in6))];
+			struct msghdr msg;
+			std::memset(&msg, 0, sizeof(msg));
+			msg.msg_control = control;
+			msg.msg_controllen = sizeof(control);
+			if (::recvmsg(_fd, &msg, MSG_ERRQUEUE | MSG_DONTWAIT) == -1) {
+				return false;
+			}
+			// Skip other errors, like ICMP
+			for (struct cmsghdr *cmsg = CMSG_FIRSTHDR(&msg); cmsg != nullptr; cmsg = CMSG_NXTHDR(&msg, cmsg)) {
+				if ((cmsg->cmsg_level != SOL_IP || cmsg->cmsg_type != IP_RECVERR) &&
+					(cmsg->cmsg_level != SOL_IPV6 || cmsg->cmsg_type != IPV6_RECVERR)) {
+					continue;
+				}
+				struct sock_extended_err err;
+				std::memcpy(&err, CMSG_DATA(cmsg), sizeof(err));
+				if (err.ee_errno == 0 && err.ee_origin == SO_EE_ORIGIN_ZEROCOPY) {
+					lo = err.ee_info;
+					hi = err.ee_data;
+					copied = (err.ee_code & SO_EE_CODE_ZEROCOPY_COPIED) != 0;
+					return true;
+				}
+			}
+		}
+	}
+
+	ssize_t SocketAttr::spliceData(const int pipeFD, const std::size_t len) {
+		// SPLICE_F_NONBLOCK is only for the pipe, the socket waits unless it
+		// is non-blocking itself
+		const int flags = ::fcntl(_fd, F_GETFL);
+		const bool blocking = (flags != -1) && (flags & O_NONBLOCK) == 0;
+		if (flags == -1 || (blocking && ::fcntl(_fd, F_SETFL, flags | O_NONBLOCK) == -1)) {
+			return -1;
+		}
+		const ssize_t ret = ::splice(pipeFD, nullptr, _fd, nullptr, len,
+			SPLICE_F_MOVE | SPLICE_F_MORE | SPLICE_F_NONBLOCK);
+		if (blocking) {
+			const int err = errno;
+			::fcntl(_fd, F_SETFL, flags);
+			errno = err;
+		}
+		return ret;
+	}
+
+	bool SocketAttr::writeData(const iovec *iov, const int iovcnt) {
+		std::size_t len = 0;
+		for (int i = 0; i < iovcnt; ++i) {
+			len += iov[i].iov_len;
+		}
+		ssize_t written = ::writev(_fd, iov, iovcnt);
+		if (written == static_cast<ssize_t>(len)) {
+			return true;
+		}
+		// Short write or error, so continue with a copy of the buffers that
+		// can be adjusted to where the write stopped
+		std::vector<iovec> rest(iov, iov + iovcnt);
+		std::size_t index = 0;
+		for (;;) {
+			if (written == -1) {
+				if (errno != EINTR) {
+					if (errno != EBADF) {
+						PERROR("writev");
+					}
+					return false;
+				}
+				written = 0;
+			}
+			// Skip the buffers that are written completely
+			while (index < rest.size() && static_cast<std::size_t>(written) >= rest[index].iov_len) {
+				written -= rest[index].iov_len;
+				++index;
+			}
+			if (index == rest.size()) {
+				return true;
+			}
+			rest[index].iov_base = static_cast<unsigned char *>(rest[index].iov_base) + written;
+			rest[index].iov_len -= written;
+			written = ::writev(_fd, &rest[index], rest.size() - index);
+		}
+	}
+
 	bool SocketAttr::sendDataTo(const void *buf, std::size_t len, int flags) {
 		if (::sendto(_fd, buf, len, flags, reinterpret_cast<sockaddr *>(&_addr),
 				   sizeof(_addr)) == -1) {
@@ -172,6 +300,64 @@
 		return true;
 	}
 
+	bool SocketAttr::sendDataTo(const iovec *iov, const int iovcnt, const int flags) {
+		struct msghdr msg;
+		std::memset(&msg, 0, sizeof(msg));
+		msg.msg_name = &_addr;
+		msg.msg_namelen = sizeof(_addr);
+		msg.msg_iov = const_cast<iovec *>(iov);
+		msg.msg_iovlen = iovcnt;
+		if (::sendmsg(_fd, &msg, flags) == -1) {
+			if (errno != EAGAIN && errno != EWOULDBLOCK && errno != ENOBUFS) {
+				PERROR("sendmsg");
+			}
+			return false;
+		}
+		return true;
+	}
+
+	int SocketAttr::sendDataTo(struct mmsghdr *msgvec, const unsigned int vlen, const int flags) {
+		for (unsigned int i = 0; i < vlen; ++i) {
+			msgvec[i].msg_hdr.msg_name = &_addr;
+			msgvec[i].msg_hdr.msg_namelen = sizeof(_addr);
+		}
+		// sendmmsg may send less then requested, then the error of the
+		// first not send datagram is returned by the next call
+		for (unsigned int send = 0; send < vlen; ) {
+			const int ret = ::sendmmsg(_fd, &msgvec[send], vlen - send, flags);
+			if (ret == -1) {
+				// The socket buffer is full, so the rest is dropped
+				if (errno == EAGAIN || errno == EWOULDBLOCK || errno == ENOBUFS) {
+					return send;
+				}
+				PERROR("sendmmsg");
+				return -1;
+			}
+			send += ret;
+		}
+		return vlen;
+	}
+
+	bool SocketAttr::sendSegmentedDataTo(const iovec *iov, const int iovcnt,
+			const uint16_t segmentSize, const int flags) {
+		char control[CMSG_SPACE(sizeof(uint16_t))];
+		std::memset(control, 0, sizeof(control));
+		struct msghdr msg;
+		std::memset(&msg, 0, sizeof(msg));
+		msg.msg_name = &_addr;
+		msg.msg_namelen = sizeof(_addr);
+		msg.msg_iov = const_cast<iovec *>(iov);
+		msg.msg_iovlen = iovcnt;
+		msg.msg_control = control;
+		msg.msg_controllen = sizeof(control);
+		struct cmsghdr *cmsg = CMSG_FIRSTHDR(&msg);
+		cmsg->cmsg_level = SOL_UDP;
+		cmsg->cmsg_type = UDP_SEGMENT;
+		cmsg->cmsg_len = CMSG_LEN(sizeof(uint16_t));
+		std::memcpy(CMSG_DATA(cmsg), &segmentSize, sizeof(uint16_t));
+		return ::sendmsg(_fd, &msg, flags) != -1;
+	}
+
 	ssize_t SocketAttr::recvDatafrom(void *buf, std::size_t len, int flags) {
 		struct sockaddr_in si_other;
 		socklen_t addrlen = sizeof(si_other);
@@ -179,6 +365,11 @@
 		return size;
 	}
 
+	ssize_t SocketAttr::recvDatafrom(void *buf, std::size_t len, int flags, struct sockaddr_in &from) {
+		socklen_t addrlen = sizeof(from);
+		return ::recvfrom(_fd, buf, len, flags, reinterpret_cast<sockaddr *>(&from), &addrlen);
+	}
+
 	int SocketAttr::getFD() const {
 		return _fd;
 	}
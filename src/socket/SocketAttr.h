@@ -22,9 +22,11 @@
 
 #include <FwDecl.h>
 
+#include <cstdint>
 #include <string>
 
 #include <netinet/in.h>
+#include <sys/socket.h>
 
 FW_DECL_NS0(SocketClient);
 
@@ -67,16 +69,63 @@ class SocketAttr {
 			return _ipAddr;
 		}
 
-		///
+		/// Write the data gathered from several buffers, a short write is
+		/// resumed where it stopped (mid-iovec) until all data is written
+		/// @param iovcnt specifies the amount of buffers, at most IOV_MAX
 		bool writeData(const struct iovec *iov, int iovcnt);
 
 		/// Use this function when the socket is in connected state
 		bool sendData(const void *buf, std::size_t len, int flags);
 
+		/// Send the data gathered from several buffers without waiting when
+		/// flags has MSG_DONTWAIT, errors are not logged
+		/// @return the amount of bytes send, or -1 and errno tells why
+		ssize_t sendData(const struct iovec *iov, int iovcnt, int flags);
+
+		/// Get the backlog of a TCP socket
+		/// @param sendQueue will get the bytes in the send queue not acked yet
+		/// @param rtt will get the smoothed round trip time in usec
+		/// @param retransmits will get the total retransmitted segments
+		bool getTcpInfo(unsigned int &sendQueue, unsigned int &rtt,
+			unsigned int &retransmits) const;
+
+		/// Let sends with MSG_ZEROCOPY use the user pages, instead of copying
+		/// them. The completions are reported on the error queue.
+		bool setZeroCopy();
+
+		/// Get a completion of the sends with MSG_ZEROCOPY, without waiting
+		/// @param lo will get the first completed send
+		/// @param hi will get the last completed send
+		/// @param copied will be true if the kernel copied the data anyway
+		/// @return false if there is no completion (yet)
+		bool getZeroCopyCompletion(uint32_t &lo, uint32_t &hi, bool &copied);
+
+		/// Move the data of a pipe to this connected socket, without waiting
+		/// @return the amount of bytes moved, or -1 and errno tells why
+		ssize_t spliceData(int pipeFD, std::size_t len);
+
 		/// Use this function when the socket is on a
 		/// connection-mode (SOCK_STREAM)
 		bool sendDataTo(const void *buf, std::size_t len, int flags);
 
+		/// Send the data gathered from several buffers as one datagram
+		/// to the address of this socket. A full socket buffer is not
+		/// logged, errno tells why it failed.
+		bool sendDataTo(const struct iovec *iov, int iovcnt, int flags);
+
+		/// Send several datagrams to the address of this socket with one
+		/// system call (if possible)
+		/// @return the amount of datagrams send, less than vlen when the
+		/// socket buffer is full, or -1 on an error
+		int sendDataTo(struct mmsghdr *msgvec, unsigned int vlen, int flags);
+
+		/// Send the data gathered from several buffers as one UDP GSO send,
+		/// that is segmented into datagrams of segmentSize (the last one
+		/// may be smaller). Errors are not logged, errno tells why it failed
+		/// so the caller can fall back when GSO is rejected.
+		bool sendSegmentedDataTo(const struct iovec *iov, int iovcnt,
+			uint16_t segmentSize, int flags);
+
 		/// Get the port of this Socket
 		int getSocketPort() const;
 
@@ -95,9 +144,19 @@ class SocketAttr {
 		/// Get the file descriptor of this Socket
 		int getFD() const;
 
+		/// Get the address the send functions send to
+		const struct sockaddr_in &getSocketAddress() const {
+			return _addr;
+		}
+
 		///
 		ssize_t recvDatafrom(void *buf, std::size_t len, int flags);
 
+		/// Receive a datagram and the address it was send from
+		/// @param from will get the address of the sender
+		/// @return the size of the datagram, or -1 and errno tells why
+		ssize_t recvDatafrom(void *buf, std::size_t len, int flags, struct sockaddr_in &from);
+
 		/// bind the socket to the port number
 		bool bind();
 